@@ -1,6 +1,6 @@
 /*******************************************************************************
  * @file    ElegantDebug.h
- * @version 1.5
+ * @version 1.6
  * @brief   ANSI-colored debug logging — STM32 HAL, Renesas RA FSP, TI MSPM0 DL.
  *
  * This header provides a small C API that mirrors the C++
@@ -25,7 +25,7 @@
  *   - See repository README for examples and integration instructions.
  *
  * @author:    WilliTourt <willitourt@foxmail.com>
- * @date:      2026-07-24
+ * @date:      2026-10-15
  *
  * @changelog:
  * - 2025-12-10: Initial release.
@@ -39,6 +39,60 @@
  *               Background colors too.
  * - 2026-07-16: Added Renesas RA FSP support (USE_RA_FSP).
  * - 2026-07-24: Added support for TI MSPM0 series.
+ * - 2026-10-15: Added non-blocking transmit (DEBUG_TX_NONBLOCKING). Lines are
+ *               copied into a static TX ring and drained by DMA/IT on STM32 UART.
+ *             Added binary logging mode (DEBUG_BINARY_MODE). Calls emit compact
+ *               records (format ID + timestamp + raw args); format strings live
+ *               in a non-loaded section and are rendered by `Tools/ed_decode.py`.
+ *             Added compile-time level threshold (DEBUG_MIN_LEVEL). Calls below
+ *               it expand to nothing, arguments and format strings included.
+ *             Added per-module runtime levels (`debug_moduleRegister()`,
+ *               `debug_moduleInfo()` ...), filtered before any formatting.
+ *             Lines are assembled in a single buffer (no msg/combined/out
+ *               copies), less stack and time per call.
+ *             Added optional built-in printf engine (DEBUG_BUILTIN_PRINTF),
+ *               used instead of vsnprintf(); %f works without
+ *               `-u _printf_float`.
+ *             Timestamp text is cached and updated without division.
+ *             Added microsecond timestamps (DEBUG_TIMESTAMP_US) from DWT CYCCNT or
+ *               SysTick interpolation, and a pluggable clock (debug_setClockSource()).
+ *             Added ISR/RTOS-safe logging (DEBUG_THREAD_SAFE). Lines are reserved
+ *               whole in the TX ring with one atomic step and never interleave.
+ *             USB-CDC output goes through the TX ring: busy retry, lines packed
+ *               into whole USB packets, dropped bytes counted (debug_txDropped()).
+ *             Non-blocking transmit on TI MSPM0: TX FIFO filled in bursts and
+ *               refilled from the UART TX interrupt (debug_txCpltCallback()).
+ *             Renesas RA output goes through the TX ring, chained from the SCI
+ *               UART callback (debug_txCpltCallback(p_args)).
+ *             Added TX ring overflow policies (DEBUG_TX_OVERFLOW): drop, block with
+ *               timeout, keep room for warnings/errors, or overwrite the oldest
+ *               lines not being sent. Dropped lines are
+ *               counted per level (debug_txDroppedLines()) and reported in one line.
+ *             Added logger statistics (DEBUG_STATS): lines, bytes and drops per
+ *               level, truncations, TX ring high-water mark and cycles spent
+ *               logging, in a debugger-readable struct (debug_stats(), debug_dumpStats()).
+ *             Added rate-limited call sites (debug_once(), debug_everyN(),
+ *               debug_everyMs()); the next line tells how many calls were skipped.
+ *             Added repeated-line suppression (DEBUG_REPEAT_SUPPRESS): back-to-back
+ *               copies of a line become one "last message repeated N times".
+ *             Added debug_hexdump(): offset/hex/ASCII rows built from a byte-to-hex
+ *               table, changed bytes highlighted against a previous snapshot.
+ *             Added binary telemetry (DEBUG_TELEMETRY, debug_streamSamples()):
+ *               delta/varint sample packets, COBS-framed between the text lines.
+ *             Added output sinks (DEBUG_SINKS, debug_sinkAdd()): one formatted line
+ *               fans out to the port, a RAM ring and user callbacks, each with its
+ *               own enable flag, level and color.
+ *             Added reset-surviving crash log (DEBUG_CRASHLOG): the latest output is
+ *               kept in a .noinit block with a magic/CRC header and replayed after
+ *               the reset by debug_crashlogReplay().
+ *             Added flash log (DEBUG_FLASHLOG): a sink appending lines or binary
+ *               records to a wear-levelled ring of flash sectors behind a driver
+ *               interface, exported to the port by debug_flashlogExport().
+ *             Added panic and fault dump (DEBUG_PANIC, debug_panic(),
+ *               DEBUG_FAULT_HANDLER()): stacked frame and fault status registers
+ *               written through a polled register-level path, no HAL or heap.
+ *             Level prefixes come from a [colored][level] table with lengths
+ *               known at compile time, copied into the line with one memcpy.
  *
  *******************************************************************************/
 
@@ -67,11 +121,263 @@
 
 /*** Buffer size settings ***********************************************/
 
+// Message length. The whole line (timestamp, prefix, [file:line], message) is
+// assembled in one stack buffer of DEBUG_BUFFER_LEN + 128 bytes.
 #define DEBUG_BUFFER_LEN 256
 
 /************************************************************************/
 
 
+/*** Formatter settings *************************************************/
+
+// Set to 1 to format with the library's own small printf engine instead of
+// vsnprintf(): no newlib printf code linked, no `-u _printf_float` needed.
+// Supports %d %i %u %x %X %o %c %s %p %f %%, flags "-0+ #", width and
+// precision (also '*'), length modifiers hh h l ll z t j.
+// Floats differ from vsnprintf(): %e / %g are printed like %f, at most 9
+// decimals are shown, and magnitudes above ~1.8e19 print "ovf".
+#define DEBUG_BUILTIN_PRINTF 0
+
+// Set to 0 to drop %f support from the built-in formatter (prints "?")
+#define DEBUG_PRINTF_FLOAT 1
+
+/************************************************************************/
+
+
+/*** Timestamp settings *************************************************/
+
+// Clock sources for microsecond timestamps
+#define DEBUG_CLOCK_AUTO     0  // DWT where the core has a cycle counter, else SysTick
+#define DEBUG_CLOCK_DWT      1  // DWT->CYCCNT at SystemCoreClock (M3/M4/M7/M33)
+#define DEBUG_CLOCK_SYSTICK  2  // ms tick + SysTick->VAL, SysTick must drive the 1 kHz tick
+#define DEBUG_CLOCK_TICK     3  // ms tick only, no core registers touched
+
+// Set to 1 for microsecond timestamps "[hh:mm:ss.mmmuuu]", 0 for milliseconds
+#define DEBUG_TIMESTAMP_US 0
+
+// Clock used when DEBUG_TIMESTAMP_US is 1. A clock installed at runtime with
+// `debug_setClockSource()` takes precedence in both resolutions.
+#define DEBUG_CLOCK_SOURCE DEBUG_CLOCK_AUTO
+
+/************************************************************************/
+
+
+/*** Log level settings *************************************************/
+
+// Levels, lowest to highest
+#define DEBUG_LEVEL_LOG      0  // debug_log / debug_logWithType
+#define DEBUG_LEVEL_INFO     1
+#define DEBUG_LEVEL_OK       2
+#define DEBUG_LEVEL_SUCCESS  3
+#define DEBUG_LEVEL_WARNING  4
+#define DEBUG_LEVEL_ERROR    5
+#define DEBUG_LEVEL_NONE     6
+
+// Calls below this level compile to nothing: their arguments are never
+// evaluated and their format strings are not linked. e.g. set to
+// DEBUG_LEVEL_WARNING in release builds to keep only warnings and errors.
+#define DEBUG_MIN_LEVEL DEBUG_LEVEL_LOG
+
+// Number of modules (subsystems) with their own runtime level. Module IDs are
+// 0 ~ DEBUG_MODULE_COUNT - 1, typically an enum in your project.
+#define DEBUG_MODULE_COUNT 8
+
+// Set to 1 to collapse a line sent again and again at the same level into one
+// "last message repeated N times" line. The count is written before the next
+// different line of that level, or once DEBUG_REPEAT_TIMEOUT_MS have passed
+// since the first dropped copy. The timeout is only looked at when a line is
+// logged, of any level, or when `debug_repeatPoll()` is called: call it from
+// a periodic task if the counts should not wait for the next line. Lines are
+// compared by length, a hash of their text after the timestamp and the first
+// DEBUG_REPEAT_KEEP_LEN bytes of it, kept per level (set it to
+// DEBUG_BUFFER_LEN to compare whole lines). On by default when compiled in,
+// see `debug_setRepeatSuppressEnabled()`.
+#define DEBUG_REPEAT_SUPPRESS 0
+#define DEBUG_REPEAT_TIMEOUT_MS 1000
+#define DEBUG_REPEAT_KEEP_LEN 32
+
+/************************************************************************/
+
+
+/*** Transmit settings **************************************************/
+
+// Set to 1 to queue each line into a static TX ring and return immediately;
+// the ring is drained in the background. 0 keeps the blocking transmit.
+// STM32 UART: drained with HAL_UART_Transmit_DMA (or _IT when no DMA channel
+// is linked to the handle). Call `debug_txCpltCallback()` from
+// `HAL_UART_TxCpltCallback()` to chain the next chunk.
+// TI MSPM0: the UART TX FIFO is filled in bursts and refilled from the TX
+// interrupt. Call `debug_txCpltCallback(UART_x_INST)` from the UART IRQ handler on
+// DL_UART_IIDX_TX and enable the UART interrupt in the NVIC.
+// Renesas RA: always queued, R_SCI_UART_Write() is asynchronous. The next
+// chunk starts on UART_EVENT_TX_COMPLETE: call `debug_txCpltCallback(p_args)` from
+// the UART callback set in the FSP configurator.
+#define DEBUG_TX_NONBLOCKING 0
+
+// TX ring size in bytes. Must be a power of two, 64 ~ 32768.
+#define DEBUG_TX_RING_LEN 1024
+
+// USB-CDC (USB_AS_DEBUG_PORT = 1) always queues into the TX ring. Queued lines
+// are packed into transfers of whole packets of this size (64 for full speed,
+// 512 for high speed); a busy endpoint is retried on the next line, or right
+// away when `debug_cdcTxCpltCallback()` is called from `CDC_TransmitCplt_FS()`.
+#define DEBUG_CDC_PACKET_LEN 64
+
+// Set to 1 to log safely from interrupts and RTOS tasks. Every line goes
+// through the TX ring: space for the whole line is reserved in one atomic
+// step (LDREX/STREX, or a few-instruction PRIMASK section on Cortex-M0/M0+),
+// so lines from different contexts never interleave. Without
+// DEBUG_TX_NONBLOCKING the caller that finds the port idle sends the ring;
+// a line logged meanwhile from an ISR or another task is sent by that caller
+// right after its own. The ring must hold at least one full line.
+#define DEBUG_THREAD_SAFE 0
+
+// What a line does when the TX ring has no room for it
+#define DEBUG_OVERFLOW_DROP      0  // the line is dropped
+#define DEBUG_OVERFLOW_BLOCK     1  // wait up to DEBUG_TX_BLOCK_MS for room, then drop
+#define DEBUG_OVERFLOW_PRIORITY  2  // drop; lines below warning leave the last
+                                    // DEBUG_TX_PRIORITY_RESERVE bytes to warnings/errors
+#define DEBUG_OVERFLOW_OVERWRITE 3  // the oldest whole lines not being sent make room
+
+// Only thread-mode callers with interrupts enabled wait; in an ISR the line
+// is dropped. Overwriting keeps the newest lines, e.g. while USB is unplugged,
+// but only lines no transfer is reading: while DMA/IT/USB still sends from
+// the ring, the new line is dropped instead. Dropped and overwritten lines
+// are counted per level and reported in one warning line
+// ("[WARNING] 12 lines dropped (1 warning, 11 info)") as soon as the ring
+// has room again. Overwriting marks what each queued line is (4 bits per
+// ring byte), so it works with binary records and telemetry packets too.
+#define DEBUG_TX_OVERFLOW DEBUG_OVERFLOW_DROP
+
+// Longest wait for DEBUG_OVERFLOW_BLOCK. A DMA transfer frees its room only
+// when it completes: a full 1 KB ring takes about 90 ms at 115200 baud.
+#define DEBUG_TX_BLOCK_MS 100
+
+// Bytes only warnings and errors may use, for DEBUG_OVERFLOW_PRIORITY
+#define DEBUG_TX_PRIORITY_RESERVE (DEBUG_TX_RING_LEN / 4)
+
+/************************************************************************/
+
+
+/*** Binary logging settings ********************************************/
+
+// Set to 1 to send compact binary records instead of rendered text. The log
+// macros then place their format string in the `.elegant_debug_fmt` section
+// (keep it out of flash in the linker script, see README) and only the
+// string's address, the timestamp and the raw argument bytes go over the
+// wire. Decode on the host with `Tools/ed_decode.py firmware.elf`.
+// Requires C11 (_Generic) and string-literal format strings.
+#define DEBUG_BINARY_MODE 0
+
+// Max size of one binary record in bytes, 16 ~ 255.
+#define DEBUG_BIN_RECORD_LEN 64
+
+/************************************************************************/
+
+
+/*** Statistics settings ************************************************/
+
+// Set to 1 to count what the logger does: lines and bytes per level,
+// truncated and dropped lines, the TX ring high-water mark and the CPU cycles
+// spent in log calls and in the transmit path. The counters are a plain
+// struct (`_debug_stats`), readable from a debugger without touching the
+// port; see `debug_stats()` and `debug_dumpStats()`. Cycles come from DWT
+// CYCCNT and stay 0 on cores without it (Cortex-M0/M0+).
+#define DEBUG_STATS 0
+
+/************************************************************************/
+
+
+/*** Telemetry settings *************************************************/
+
+// Set to 1 for the binary telemetry channel (`debug_streamSamples()`). Sample
+// blocks are delta/varint encoded and COBS-framed between 0x00 bytes, which
+// never occur in text lines, so they share the port with the logs without
+// corrupting them. `Tools/ed_demux.py` splits a capture into the log text and
+// one CSV file per channel. Text logs only: binary mode records may contain
+// 0x00, so DEBUG_BINARY_MODE cannot be combined with it. Packets are counted
+// apart from the log lines (stats, drops).
+#define DEBUG_TELEMETRY 0
+
+// Max size of one packet before framing in bytes, 16 ~ 254. Longer sample
+// blocks are sent as several packets.
+#define DEBUG_TELEMETRY_LEN 128
+
+/************************************************************************/
+
+
+/*** Sink settings ******************************************************/
+
+// Set to 1 to send each line to several sinks at once: the debug port
+// (DEBUG_SINK_PORT), the RAM ring below (DEBUG_SINK_RAM) and callbacks added
+// with `debug_sinkAdd()`, e.g. USB-CDC next to the UART. Each sink has its own
+// enable flag, minimum level and color setting. The line is formatted once
+// and every sink gets the same buffer; for sinks without color the ANSI
+// sequences are taken out of it in place, after the colored sinks are done.
+#define DEBUG_SINKS 0
+
+// Sinks, the debug port and the RAM ring included, 2 ~ 8
+#define DEBUG_SINK_MAX 4
+
+// RAM ring sink size in bytes, 0 for none, else a power of two 64 ~ 65536.
+// It keeps the latest lines for post-mortem reading, from a debugger or with
+// `debug_sinkRamRead()`.
+#define DEBUG_SINK_RAM_LEN 0
+
+/************************************************************************/
+
+
+/*** Crash log settings *************************************************/
+
+// Set to 1 to keep a copy of the latest output in a RAM block that survives
+// a reset (watchdog, fault handler, NVIC_SystemReset(); not a power cycle).
+// The block sits in DEBUG_CRASHLOG_SECTION, which the startup code must
+// neither zero nor initialize: add it to the linker script as NOLOAD, see
+// README. A magic number and a CRC-32 of its header tell a block left by
+// the previous session from power-up garbage; `debug_crashlogReplay()` sends
+// what it holds after the reset.
+#define DEBUG_CRASHLOG 0
+
+// Crash log size in bytes, a power of two 256 ~ 65536
+#define DEBUG_CRASHLOG_LEN 1024
+
+// Output section of the crash log block
+#define DEBUG_CRASHLOG_SECTION ".noinit"
+
+/************************************************************************/
+
+
+/*** Flash log settings *************************************************/
+
+// Set to 1 for a flash log: a sink that appends each line (each record in
+// binary mode) to a reserved flash region, so that logs outlive a power
+// cycle. The region is a ring of erase sectors filled one after the other,
+// which erases every sector as often as the others. The flash is reached
+// through a small driver (debug_flash_t), and `debug_flashlogExport()` sends
+// the stored log to the port on demand. Needs DEBUG_SINKS.
+#define DEBUG_FLASHLOG 0
+
+/************************************************************************/
+
+
+/*** Panic settings *****************************************************/
+
+// Set to 1 for `debug_panic()` and the fault dump (DEBUG_FAULT_HANDLER).
+// With interrupts off, they send what the TX ring still holds and then the
+// fault state straight to the UART data register, polling: no HAL call, no
+// DMA, no vsnprintf() and no heap, so they work when none of these can be
+// trusted any more. With DEBUG_CRASHLOG the dump also goes to the crash log.
+// USB-CDC (USB_AS_DEBUG_PORT = 1) cannot be polled: there the dump only goes
+// to the crash log.
+#define DEBUG_PANIC 0
+
+// After the dump: 1 resets the MCU (NVIC_SystemReset()), 0 stops in a loop
+// for the debugger
+#define DEBUG_PANIC_RESET 1
+
+/************************************************************************/
+
+
 
 #if defined(USE_STM32_HAL)
     #define DEBUG_PLATFORM_STM32  1
@@ -89,6 +395,85 @@
     #error "Please define USE_STM32_HAL / USE_RA_FSP / USE_TI_MSPM0_DL macro before including ElegantDebug.h"
 #endif
 
+// The ring is drained by the port's own DMA/interrupts (always on RA, whose writes are asynchronous)
+#if ((DEBUG_TX_NONBLOCKING && ((DEBUG_PLATFORM_STM32 && (USB_AS_DEBUG_PORT != 1)) || DEBUG_PLATFORM_TI)) || DEBUG_PLATFORM_RA)
+    #define DEBUG_TX_RING_ENABLED 1
+#else
+    #define DEBUG_TX_RING_ENABLED 0
+#endif
+
+#if (DEBUG_PLATFORM_STM32 && (USB_AS_DEBUG_PORT == 1))
+    #define DEBUG_TX_CDC_ENABLED 1
+#else
+    #define DEBUG_TX_CDC_ENABLED 0
+#endif
+
+// Lines are queued in the TX ring, drained by DMA/IT, USB or by the caller that owns the port
+#if (DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED || DEBUG_THREAD_SAFE)
+    #define DEBUG_TX_QUEUED 1
+#else
+    #define DEBUG_TX_QUEUED 0
+#endif
+
+#if (DEBUG_BUFFER_LEN < 64)
+    #error "DEBUG_BUFFER_LEN must be at least 64"
+#endif
+
+#if DEBUG_TX_QUEUED
+    #if ((DEBUG_TX_RING_LEN & (DEBUG_TX_RING_LEN - 1)) != 0) || (DEBUG_TX_RING_LEN < 64) || (DEBUG_TX_RING_LEN > 32768)
+    #error "DEBUG_TX_RING_LEN must be a power of two between 64 and 32768"
+    #endif
+    #if (DEBUG_THREAD_SAFE && !DEBUG_TX_RING_ENABLED && !DEBUG_TX_CDC_ENABLED && \
+         (DEBUG_TX_RING_LEN < DEBUG_BUFFER_LEN + 128))
+    #error "DEBUG_THREAD_SAFE: DEBUG_TX_RING_LEN must hold one full line (DEBUG_BUFFER_LEN + 128)"
+    #endif
+    #if (DEBUG_TX_OVERFLOW < DEBUG_OVERFLOW_DROP) || (DEBUG_TX_OVERFLOW > DEBUG_OVERFLOW_OVERWRITE)
+    #error "DEBUG_TX_OVERFLOW must be one of the DEBUG_OVERFLOW_* policies"
+    #endif
+    #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_PRIORITY) && (DEBUG_TX_PRIORITY_RESERVE >= DEBUG_TX_RING_LEN)
+    #error "DEBUG_TX_PRIORITY_RESERVE must be smaller than DEBUG_TX_RING_LEN"
+    #endif
+#endif
+
+#if DEBUG_BINARY_MODE
+    #if defined(__cplusplus)
+    #error "Binary logging mode of the C API needs a C11 compiler; use Src-CPP from C++"
+    #elif !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 201112L)
+    #error "Binary logging mode needs C11 (_Generic)"
+    #endif
+    #if (DEBUG_BIN_RECORD_LEN < 16) || (DEBUG_BIN_RECORD_LEN > 255)
+    #error "DEBUG_BIN_RECORD_LEN must be between 16 and 255"
+    #endif
+#endif
+
+#if DEBUG_TELEMETRY
+    #if DEBUG_BINARY_MODE
+    #error "DEBUG_TELEMETRY frames packets between 0x00 bytes, which binary records contain: not with DEBUG_BINARY_MODE"
+    #endif
+    #if (DEBUG_TELEMETRY_LEN < 16) || (DEBUG_TELEMETRY_LEN > 254)
+    #error "DEBUG_TELEMETRY_LEN must be between 16 and 254"
+    #endif
+#endif
+
+#if DEBUG_SINKS
+    #if (DEBUG_SINK_MAX < 2) || (DEBUG_SINK_MAX > 8)
+    #error "DEBUG_SINK_MAX must be between 2 and 8"
+    #endif
+    #if (DEBUG_SINK_RAM_LEN != 0) && (((DEBUG_SINK_RAM_LEN & (DEBUG_SINK_RAM_LEN - 1)) != 0) || \
+         (DEBUG_SINK_RAM_LEN < 64) || (DEBUG_SINK_RAM_LEN > 65536))
+    #error "DEBUG_SINK_RAM_LEN must be 0 or a power of two between 64 and 65536"
+    #endif
+#endif
+
+#if DEBUG_CRASHLOG && (((DEBUG_CRASHLOG_LEN & (DEBUG_CRASHLOG_LEN - 1)) != 0) || \
+                       (DEBUG_CRASHLOG_LEN < 256) || (DEBUG_CRASHLOG_LEN > 65536))
+    #error "DEBUG_CRASHLOG_LEN must be a power of two between 256 and 65536"
+#endif
+
+#if DEBUG_FLASHLOG && !DEBUG_SINKS
+    #error "DEBUG_FLASHLOG needs DEBUG_SINKS"
+#endif
+
 /*** Platform-specific includes *****************************************/
 
 #if DEBUG_PLATFORM_STM32
@@ -147,6 +532,30 @@
     #endif
 #endif
 
+// Clock actually used for microsecond timestamps
+#if DEBUG_TIMESTAMP_US
+    #if (DEBUG_CLOCK_SOURCE != DEBUG_CLOCK_AUTO)
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_SOURCE
+    #elif defined(DWT_CTRL_CYCCNTENA_Msk)
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_DWT
+    #else
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_SYSTICK
+    #endif
+#else
+    #define DEBUG_CLOCK_USED DEBUG_CLOCK_TICK
+#endif
+
+#if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT) && !defined(DWT_CTRL_CYCCNTENA_Msk)
+    #error "DEBUG_CLOCK_DWT: this core has no DWT cycle counter, use DEBUG_CLOCK_SYSTICK"
+#endif
+
+// Cycle counters of DEBUG_STATS
+#if (DEBUG_STATS && defined(DWT_CTRL_CYCCNTENA_Msk))
+    #define DEBUG_STATS_CYCLES 1
+#else
+    #define DEBUG_STATS_CYCLES 0
+#endif
+
 
 
 #include <stdbool.h>
@@ -256,10 +665,71 @@ void debug_init(uart_instance_t const *uart, bool enable_timestamp, bool enable_
 void debug_init(UART_Regs *uart_inst, bool enable_timestamp, bool enable_color, bool enable_filename_line);
 #endif
 
+#if (DEBUG_TX_RING_ENABLED && DEBUG_PLATFORM_STM32)
+// Call from `HAL_UART_TxCpltCallback()` when DEBUG_TX_NONBLOCKING is 1:
+// releases the chunk that has just been sent and starts the next one.
+// Handles that are not the debug port are ignored.
+void debug_txCpltCallback(UART_HandleTypeDef *huart);
+#elif DEBUG_PLATFORM_RA
+// Call from the SCI UART callback (set in the FSP configurator) with its
+// arguments: on UART_EVENT_TX_COMPLETE the next queued chunk is started.
+// Other events and channels are ignored.
+void debug_txCpltCallback(uart_callback_args_t *p_args);
+#elif (DEBUG_TX_RING_ENABLED && DEBUG_PLATFORM_TI)
+// Call from the UART IRQ handler on DL_UART_IIDX_TX when DEBUG_TX_NONBLOCKING
+// is 1: refills the TX FIFO from the ring. Other UARTs are ignored.
+void debug_txCpltCallback(UART_Regs *uart_inst);
+#endif
+
+#if DEBUG_TX_CDC_ENABLED
+// Optional, call from `CDC_TransmitCplt_FS()` in usbd_cdc_if.c: starts the
+// next USB transfer as soon as the previous one is done instead of on the
+// next line.
+void debug_cdcTxCpltCallback(void);
+#endif
+
+#if DEBUG_TX_QUEUED
+// Bytes dropped so far because the TX ring was full
+uint32_t debug_txDropped(void);
+// Lines of one level (DEBUG_LEVEL_*) dropped so far, see DEBUG_TX_OVERFLOW
+uint32_t debug_txDroppedLines(uint8_t level);
+#if DEBUG_TELEMETRY
+// Telemetry packets dropped so far
+uint32_t debug_txDroppedPackets(void);
+#endif
+#endif
+
+#if DEBUG_STATS
+// Counters since start-up or the last debug_statsReset(), see DEBUG_STATS
+typedef struct {
+    uint32_t lines[DEBUG_LEVEL_NONE];   // lines (binary records) sent or queued, per level
+    uint32_t bytes[DEBUG_LEVEL_NONE];   // ... and their bytes
+    uint32_t dropped[DEBUG_LEVEL_NONE]; // lines dropped on a full TX ring, per level
+    uint32_t truncated;                 // lines cut at the line buffer (or record) size
+    uint32_t ring_high_water;           // most bytes ever held by the TX ring (0 without one)
+#if DEBUG_TELEMETRY
+    uint32_t tlm_packets;               // telemetry packets sent or queued, not in lines[]
+    uint32_t tlm_bytes;                 // ... and their bytes
+    uint32_t tlm_dropped;               // ... dropped on a full TX ring
+#endif
+    uint64_t log_cycles;                // CPU cycles inside log calls, transmit included
+    uint64_t tx_cycles;                 // ... of which in the transmit path
+} debug_stats_t;
+
+// The counters themselves; updated in place, so a debugger can watch them
+extern debug_stats_t _debug_stats;
+
+const debug_stats_t* debug_stats(void);
+// Zero the counters. Lines being logged meanwhile may be counted or not.
+void debug_statsReset(void);
+// Print the counters as info lines, as they were before the first one
+void debug_dumpStats(void);
+#endif
+
 #if (DEBUG_PLATFORM_RA || DEBUG_PLATFORM_TI)
 // RA FSP tick provider (User must feed from timer ISR)
 static inline void debug_tick() {
-    _debug_tick_ms++;
+    _debug_tick_ms = _debug_tick_ms + 1;   // also included from C++20 sources, where ++ on volatile is deprecated
 }
 #endif
 
@@ -284,6 +754,225 @@ void debug_setTimestampEnabled(bool enabled);
 void debug_setColorEnabled(bool enabled);
 // Enable/disable showing filename:line when using the file/line variants or macros
 void debug_setFilenameLineEnabled(bool enabled);
+#if DEBUG_REPEAT_SUPPRESS
+// Enable/disable collapsing repeated lines; disabling reports pending counts
+void debug_setRepeatSuppressEnabled(bool enabled);
+// Report the counts whose DEBUG_REPEAT_TIMEOUT_MS has passed, without
+// waiting for the next line. Not from an ISR: it may log.
+void debug_repeatPoll(void);
+#endif
+
+// Install a microsecond clock for timestamps, e.g. a free-running hardware
+// timer or a fake counter in host tests. NULL restores DEBUG_CLOCK_SOURCE.
+void debug_setClockSource(uint64_t (*now_us)(void));
+
+// Per-module runtime levels. Messages from a module below its level are
+// dropped before any formatting: the check is one load and one compare.
+// Modules start at DEBUG_LEVEL_LOG (everything passes) with no name.
+extern uint8_t _debug_module_levels[DEBUG_MODULE_COUNT];
+
+// Set a module's name (printed as "[name] " after the type prefix, NULL for
+// none) and level.
+void debug_moduleRegister(uint8_t module, const char* name, uint8_t level);
+void debug_moduleSetLevel(uint8_t module, uint8_t level);
+uint8_t debug_moduleGetLevel(uint8_t module);
+const char* debug_moduleName(uint8_t module);
+
+static inline bool debug_moduleEnabled(uint8_t module, uint8_t level) {
+    return (module >= DEBUG_MODULE_COUNT) || (level >= _debug_module_levels[module]);
+}
+
+// Module variant behind the debug_module*() macros; `file` may be NULL
+void debug_logModule(uint8_t module, uint8_t level, const char* file, int line, const char* format, ...);
+
+// Per-call-site state of debug_once() / debug_everyN() / debug_everyMs(),
+// zero-initialized as a static. The checks return 0 to skip the call, else
+// 1 + the calls skipped since the site last logged.
+typedef struct {
+    uint32_t mark;      // every N: calls left to skip; every ms: tick of the last line
+    uint32_t skipped;   // calls skipped since the last line
+    bool     started;   // false until the first call
+} debug_limit_t;
+
+static inline uint32_t _debug_limitPass(debug_limit_t* lim, uint32_t mark) {
+    uint32_t pass = lim->skipped + 1U;
+    lim->started = true;
+    lim->mark = mark;
+    lim->skipped = 0;
+    return pass;
+}
+
+static inline uint32_t _debug_limitSkip(debug_limit_t* lim) {
+    if (lim->skipped < 0xFFFFFFFEU) lim->skipped++;
+    return 0;
+}
+
+static inline uint32_t debug_limitOnce(debug_limit_t* lim) {
+    return !lim->started ? _debug_limitPass(lim, 0) : _debug_limitSkip(lim);
+}
+
+static inline uint32_t debug_limitEveryN(debug_limit_t* lim, uint32_t n) {
+    if (lim->started && lim->mark != 0U) {
+        lim->mark--;
+        return _debug_limitSkip(lim);
+    }
+    return _debug_limitPass(lim, (n != 0U) ? n - 1U : 0U);
+}
+
+static inline uint32_t debug_limitEveryMs(debug_limit_t* lim, uint32_t ms) {
+#if DEBUG_PLATFORM_STM32
+    uint32_t now = HAL_GetTick();
+#else
+    uint32_t now = _debug_tick_ms;
+#endif
+    if (lim->started && now - lim->mark < ms) return _debug_limitSkip(lim);
+    return _debug_limitPass(lim, now);
+}
+
+// Rate-limited variant behind the macros below: "[N suppressed] " is added
+// after the prefix when `suppressed` is not 0. `file` may be NULL.
+void debug_logLimited(uint8_t level, uint32_t suppressed, const char* file, int line, const char* format, ...);
+
+// Hex dump of `len` bytes at `data`, 16 per row with offset, hex and ASCII
+// columns, one line per row at DEBUG_LEVEL_LOG. With `prev` (a snapshot of
+// the same length, or NULL) and colors on, bytes that differ from it are
+// shown in red. In binary mode the rows are sent as raw bytes and rendered
+// by `Tools/ed_decode.py`.
+void debug_hexdump(const void* data, size_t len, const void* prev);
+
+#if DEBUG_TELEMETRY
+// Binary telemetry, see DEBUG_TELEMETRY. `n` samples of one channel go out
+// in one or more packets, each written whole like a log line:
+//   0x00 | COBS(channel | kind | varint ms | count | samples... | checksum) | 0x00
+// kind: 1 int16, 2 int32, 3 float. Integer samples are zigzag varints, the
+// first of a packet as is and the others as the difference to the previous
+// one; floats are 4 raw bytes (little-endian). checksum is the inverted 8-bit
+// sum of the bytes before it.
+void debug_streamSamples(uint8_t channel, const int16_t* samples, size_t n);
+void debug_streamSamples32(uint8_t channel, const int32_t* samples, size_t n);
+void debug_streamFloats(uint8_t channel, const float* samples, size_t n);
+#endif
+
+#if DEBUG_SINKS
+// Output sinks, see DEBUG_SINKS. Sink IDs:
+#define DEBUG_SINK_PORT 0   // the port given to debug_init(); its color is debug_setColorEnabled()
+#define DEBUG_SINK_RAM  1   // the RAM ring, when DEBUG_SINK_RAM_LEN is not 0
+
+// Called with each line (or binary record / telemetry packet) of at least
+// the sink's level, in the context of the log call. `data` is only valid
+// during the call: send or copy it before returning. With DEBUG_THREAD_SAFE
+// it may be called from several contexts at once.
+typedef void (*debug_sink_fn)(void* ctx, const char* data, size_t len);
+
+// Add a sink, enabled, for lines of `level` and above. Returns its ID, or -1
+// when all DEBUG_SINK_MAX are in use. Set sinks up before logging from other
+// contexts; the table is not locked.
+int debug_sinkAdd(debug_sink_fn write, void* ctx, uint8_t level, bool color);
+void debug_sinkEnable(uint8_t sink, bool enabled);
+void debug_sinkSetLevel(uint8_t sink, uint8_t level);
+void debug_sinkSetColor(uint8_t sink, bool color);
+
+#if DEBUG_SINK_RAM_LEN
+// Copy the latest lines of the RAM ring into `dst`, oldest first, starting at
+// a whole line. Returns the bytes copied; the ring is left as it is.
+size_t debug_sinkRamRead(char* dst, size_t size);
+void debug_sinkRamClear(void);
+#endif
+#endif
+
+#if DEBUG_CRASHLOG
+// Crash log block, see DEBUG_CRASHLOG. Text lines (binary records in binary
+// mode) are copied into `data` as they are written; telemetry is not kept.
+typedef struct {
+    uint32_t magic;     // set once the block is in use
+    uint32_t size;      // DEBUG_CRASHLOG_LEN
+    uint32_t head;      // bytes ever written, `data` holds the last of them
+    uint32_t crc;       // CRC-32 of size and head
+    char data[DEBUG_CRASHLOG_LEN];
+} debug_crashlog_t;
+
+// The block itself, readable from a debugger after a crash
+extern debug_crashlog_t _debug_crashlog;
+
+// Send what the previous session left in the crash log through the normal
+// output, at DEBUG_LEVEL_LOG between two warning lines, starting at a whole
+// line. Call once after debug_init(), before logging much: lines logged
+// first may already have overwritten the oldest ones. Returns the bytes
+// replayed, 0 when the block held nothing valid.
+size_t debug_crashlogReplay(void);
+// Forget what the crash log holds
+void debug_crashlogClear(void);
+#endif
+
+#if DEBUG_FLASHLOG
+// Flash driver for the flash log, see DEBUG_FLASHLOG. Addresses are offsets
+// into the log region: sector i spans i * sector_size ~ (i + 1) * sector_size.
+// program() only gets whole, aligned program units of erased flash; erase()
+// leaves a sector all 0xFF. Each returns false on failure.
+typedef struct {
+    bool (*read)(void* ctx, uint32_t addr, void* dst, size_t len);
+    bool (*program)(void* ctx, uint32_t addr, const void* src, size_t len);
+    bool (*erase)(void* ctx, uint32_t sector);
+    void* ctx;
+    uint32_t sector_size;   // erase unit in bytes, at least DEBUG_BUFFER_LEN + 256
+    uint16_t sectors;       // sectors in the region, at least 2
+    uint8_t prog_size;      // program unit in bytes: 1, 2, 4, 8, 16 or 32
+} debug_flash_t;
+
+// Mount the flash log in the region `flash` describes (kept by pointer) and
+// add its sink for lines of `level` and above. Returns the sink ID, or -1
+// when the geometry is not supported or all sinks are in use.
+// Each line is programmed in the log call, and opening a new sector erases
+// it there: keep the level high and the log calls out of ISRs. With
+// DEBUG_THREAD_SAFE, a line logged while another is being written is
+// dropped rather than waited for.
+int debug_flashlogInit(const debug_flash_t* flash, uint8_t level);
+// Send the stored records to the port, oldest first, "--- boot ---" marking
+// each debug_flashlogInit(). Lines for the flash log are dropped meanwhile.
+// Returns the records sent.
+size_t debug_flashlogExport(void);
+// Erase the whole region; false when an erase failed
+bool debug_flashlogErase(void);
+#endif
+
+#if DEBUG_PANIC
+// Exception frame the core stacks on fault entry
+typedef struct {
+    uint32_t r0, r1, r2, r3, r12;
+    uint32_t lr;        // of the faulting code
+    uint32_t pc;        // faulting instruction (or the one after it)
+    uint32_t xpsr;
+} debug_fault_frame_t;
+
+// Send `reason` and the caller's address, after what the TX ring still
+// holds, through the polled path (see DEBUG_PANIC), then reset or stop.
+// For states the code cannot go on from; usable from any context.
+void debug_panic(const char* reason) __attribute__((noreturn));
+// The same for a fault: the stacked frame, the stack pointer it was found
+// at, EXC_RETURN and the fault status registers (CFSR, HFSR, MMFAR, BFAR;
+// not on Cortex-M0/M0+). Called by the DEBUG_FAULT_HANDLER() handler.
+void debug_fault(const debug_fault_frame_t* frame, uint32_t exc_return) __attribute__((noreturn));
+
+// Define fault handler `name` (HardFault_Handler, MemManage_Handler, ...)
+// to pass the frame of the stack in use to debug_fault(). Remove the
+// generated handler of the same name, e.g. in stm32xxxx_it.c.
+#define DEBUG_FAULT_HANDLER(name)                                               \
+    __attribute__((naked)) void name(void) {                                    \
+        __asm volatile(                                                         \
+            "movs r0, #4            \n"                                         \
+            "mov  r1, lr            \n"                                         \
+            "tst  r0, r1            \n"   /* EXC_RETURN bit 2: PSP in use */    \
+            "beq  1f                \n"                                         \
+            "mrs  r0, psp           \n"                                         \
+            "b    2f                \n"                                         \
+            "1:                     \n"                                         \
+            "mrs  r0, msp           \n"                                         \
+            "2:                     \n"                                         \
+            "ldr  r2, =debug_fault  \n"                                         \
+            "bx   r2                \n"                                         \
+            ".ltorg                 \n");                                       \
+    }
+#endif
 
 // helper functions generating ANSI escape sequences for variable 24-bit colors
 // they return a pointer to a static string which remains valid until the
@@ -292,11 +981,243 @@ void debug_setFilenameLineEnabled(bool enabled);
 const char* customTextColor(uint8_t r, uint8_t g, uint8_t b);
 const char* customBgColor(uint8_t r, uint8_t g, uint8_t b);
 
+#if !DEBUG_BINARY_MODE
+
 // Macros to automatically pass caller file/line
 #define debug_error(...)                debug_error_fileline(__FILE__, __LINE__, __VA_ARGS__)
 #define debug_warning(...)              debug_warning_fileline(__FILE__, __LINE__, __VA_ARGS__)
 // #define debug_logWithType(type, ...) debug_logWithType_fileline(__FILE__, __LINE__, (type), __VA_ARGS__)
 
+#define _DEBUG_MODULE_CALL(module, level, file, line, ...) do {                 \
+        if (debug_moduleEnabled((module), (level))) {                           \
+            debug_logModule((module), (level), (file), (line), __VA_ARGS__);    \
+        }                                                                       \
+    } while (0)
+
+#else
+
+/*** Binary logging *****************************************************/
+//
+// Record on the wire (little-endian):
+//   0xED | len | flags | varint fmt address | [u32 ms] | [u32 suppressed] | args... | checksum
+// `len` counts the bytes between itself and the checksum; checksum is the
+// inverted 8-bit sum of those bytes. flags: bit0 timestamp, bit1 color,
+// bit2 filename/line, bit3 suppressed count (rate-limited call sites),
+// bit7 arguments truncated.
+//
+// Format section entry: "<tag>\x1F<file>\x1F<line>\x1F<format>", tag is one
+// of L(og) T(ype) I(nfo) O(k) S(uccess) W(arning) E(rror); lower case for
+// the module variants, whose first argument is the module name. H(exdump)
+// rows have an empty format and carry u32 offset | u8 count (bit7: 8-digit
+// offset) | u16 changed-byte mask | the bytes.
+// Arguments: integers as 4 bytes (8 for long long), floating point as an
+// 8-byte double, strings inline with NUL, pointers as 4 bytes.
+// Up to 8 arguments per call.
+
+#define DEBUG_BIN_SYNC 0xEDU
+
+typedef struct {
+    uint8_t len;
+    uint8_t level;      // DEBUG_LEVEL_*, for DEBUG_TX_OVERFLOW
+#if DEBUG_STATS
+    uint32_t t0;        // cycle count at debug_binBegin()
+#endif
+    uint8_t buf[DEBUG_BIN_RECORD_LEN];
+} debug_bin_record_t;
+
+// Record builders used by the macros below
+void debug_binBegin(debug_bin_record_t *rec, const char *fmt_id, uint8_t level);
+void debug_binU32(debug_bin_record_t *rec, uint32_t v);
+void debug_binU64(debug_bin_record_t *rec, uint64_t v);
+void debug_binLong(debug_bin_record_t *rec, unsigned long v);
+void debug_binF64(debug_bin_record_t *rec, double v);
+void debug_binStr(debug_bin_record_t *rec, const char *s);
+void debug_binPtr(debug_bin_record_t *rec, const void *p);
+void debug_binSuppressed(debug_bin_record_t *rec, uint32_t n);
+void debug_binEnd(debug_bin_record_t *rec);
+
+#define DEBUG_BIN_SECTION   __attribute__((section(".elegant_debug_fmt"), used))
+
+#define _DEBUG_STR_(x)      #x
+#define _DEBUG_STR(x)       _DEBUG_STR_(x)
+#define _DEBUG_CAT_(a, b)   a##b
+#define _DEBUG_CAT(a, b)    _DEBUG_CAT_(a, b)
+
+// number of arguments after the format string (0 ~ 8)
+#define _DEBUG_BIN_NARG(...) _DEBUG_BIN_NARG_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define _DEBUG_BIN_NARG_(f, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+#define _DEBUG_BIN_FIRST(...) _DEBUG_BIN_FIRST_(__VA_ARGS__, ~)
+#define _DEBUG_BIN_FIRST_(f, ...) f
+
+#define _DEBUG_BIN_ARG(r, a) _Generic((a),                              \
+        _Bool: debug_binU32, char: debug_binU32,                        \
+        signed char: debug_binU32, unsigned char: debug_binU32,         \
+        short: debug_binU32, unsigned short: debug_binU32,              \
+        int: debug_binU32, unsigned int: debug_binU32,                  \
+        long: debug_binLong, unsigned long: debug_binLong,              \
+        long long: debug_binU64, unsigned long long: debug_binU64,      \
+        float: debug_binF64, double: debug_binF64,                      \
+        long double: debug_binF64,                                      \
+        char*: debug_binStr, const char*: debug_binStr,                 \
+        default: debug_binPtr)((r), (a));
+
+#define _DEBUG_BIN_ARGS_0(r, f)
+#define _DEBUG_BIN_ARGS_1(r, f, a)      _DEBUG_BIN_ARG(r, a)
+#define _DEBUG_BIN_ARGS_2(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_1(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_3(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_2(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_4(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_3(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_5(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_4(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_6(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_5(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_7(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_6(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS_8(r, f, a, ...) _DEBUG_BIN_ARG(r, a) _DEBUG_BIN_ARGS_7(r, f, __VA_ARGS__)
+#define _DEBUG_BIN_ARGS(r, ...) _DEBUG_CAT(_DEBUG_BIN_ARGS_, _DEBUG_BIN_NARG(__VA_ARGS__))(r, __VA_ARGS__)
+
+// DEBUG_LEVEL_* of a record tag, folded at compile time (the format section
+// itself is not readable at run time)
+#define _DEBUG_BIN_LEVEL(tag)                                                   \
+        ((((tag)[0] | 0x20) == 'e') ? DEBUG_LEVEL_ERROR :                       \
+         (((tag)[0] | 0x20) == 'w') ? DEBUG_LEVEL_WARNING :                     \
+         (((tag)[0] | 0x20) == 's') ? DEBUG_LEVEL_SUCCESS :                     \
+         (((tag)[0] | 0x20) == 'o') ? DEBUG_LEVEL_OK :                          \
+         (((tag)[0] | 0x20) == 'i') ? DEBUG_LEVEL_INFO : DEBUG_LEVEL_LOG)
+
+// `pre` emits arguments that come before the user's (logWithType's type/style)
+#define _DEBUG_BIN_RECORD(tag, pre, ...) do {                                   \
+        static const char _debug_fmt[] DEBUG_BIN_SECTION =                      \
+            tag "\x1F" __FILE__ "\x1F" _DEBUG_STR(__LINE__) "\x1F"             \
+            _DEBUG_BIN_FIRST(__VA_ARGS__);                                      \
+        debug_bin_record_t _debug_rec;                                          \
+        debug_binBegin(&_debug_rec, _debug_fmt, _DEBUG_BIN_LEVEL(tag));         \
+        pre                                                                     \
+        _DEBUG_BIN_ARGS(&_debug_rec, __VA_ARGS__)                               \
+        debug_binEnd(&_debug_rec);                                              \
+    } while (0)
+
+#define debug_log(...)              _DEBUG_BIN_RECORD("L", , __VA_ARGS__)
+#define debug_info(...)             _DEBUG_BIN_RECORD("I", , __VA_ARGS__)
+#define debug_ok(...)               _DEBUG_BIN_RECORD("O", , __VA_ARGS__)
+#define debug_success(...)          _DEBUG_BIN_RECORD("S", , __VA_ARGS__)
+#define debug_warning(...)          _DEBUG_BIN_RECORD("W", , __VA_ARGS__)
+#define debug_error(...)            _DEBUG_BIN_RECORD("E", , __VA_ARGS__)
+#define debug_logWithType(type, style, ...)                                     \
+        _DEBUG_BIN_RECORD("T", debug_binStr(&_debug_rec, (type));               \
+                               debug_binStr(&_debug_rec, (style));, __VA_ARGS__)
+
+#define _DEBUG_BIN_MODULE_RECORD(module, level, tag, ...) do {                  \
+        if (debug_moduleEnabled((module), (level))) {                           \
+            _DEBUG_BIN_RECORD(tag, debug_binStr(&_debug_rec,                    \
+                              debug_moduleName(module));, __VA_ARGS__);         \
+        }                                                                       \
+    } while (0)
+
+/************************************************************************/
+
+#endif // !DEBUG_BINARY_MODE
+
+#if !DEBUG_BINARY_MODE
+    #define debug_moduleLog(module, ...)     _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_LOG, NULL, 0, __VA_ARGS__)
+    #define debug_moduleInfo(module, ...)    _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_INFO, NULL, 0, __VA_ARGS__)
+    #define debug_moduleOk(module, ...)      _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_OK, NULL, 0, __VA_ARGS__)
+    #define debug_moduleSuccess(module, ...) _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_SUCCESS, NULL, 0, __VA_ARGS__)
+    #define debug_moduleWarning(module, ...) _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_WARNING, __FILE__, __LINE__, __VA_ARGS__)
+    #define debug_moduleError(module, ...)   _DEBUG_MODULE_CALL(module, DEBUG_LEVEL_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#else
+    #define debug_moduleLog(module, ...)     _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_LOG, "l", __VA_ARGS__)
+    #define debug_moduleInfo(module, ...)    _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_INFO, "i", __VA_ARGS__)
+    #define debug_moduleOk(module, ...)      _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_OK, "o", __VA_ARGS__)
+    #define debug_moduleSuccess(module, ...) _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_SUCCESS, "s", __VA_ARGS__)
+    #define debug_moduleWarning(module, ...) _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_WARNING, "w", __VA_ARGS__)
+    #define debug_moduleError(module, ...)   _DEBUG_BIN_MODULE_RECORD(module, DEBUG_LEVEL_ERROR, "e", __VA_ARGS__)
+#endif
+
+// Rate-limited call sites. `lvl` is a level name without DEBUG_LEVEL_: LOG,
+// INFO, OK, SUCCESS, WARNING or ERROR. Each call site keeps a few bytes of
+// static state; a skipped call is a compare and an increment, its arguments
+// are not evaluated and nothing is formatted. The next line from the site
+// tells how many calls were skipped:
+//   "[ERROR] [adc.c:88] [1234 suppressed] ADC timeout"
+//
+//   debug_once(lvl, format, ...)           only the first call
+//   debug_everyN(lvl, n, format, ...)      the 1st, (n+1)th, (2n+1)th ... call
+//   debug_everyMs(lvl, ms, format, ...)    at most one line per `ms`
+//
+// The state is not locked: from several contexts at once the counts are
+// approximate.
+#define debug_once(lvl, ...)        _DEBUG_LIMIT(DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                 debug_limitOnce(&_debug_lim), __VA_ARGS__)
+#define debug_everyN(lvl, n, ...)   _DEBUG_LIMIT(DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                 debug_limitEveryN(&_debug_lim, (n)), __VA_ARGS__)
+#define debug_everyMs(lvl, ms, ...) _DEBUG_LIMIT(DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                 debug_limitEveryMs(&_debug_lim, (ms)), __VA_ARGS__)
+
+#define _DEBUG_BIN_TAG_LOG      "L"
+#define _DEBUG_BIN_TAG_INFO     "I"
+#define _DEBUG_BIN_TAG_OK       "O"
+#define _DEBUG_BIN_TAG_SUCCESS  "S"
+#define _DEBUG_BIN_TAG_WARNING  "W"
+#define _DEBUG_BIN_TAG_ERROR    "E"
+
+// Levels below DEBUG_MIN_LEVEL fold to nothing, state included
+#define _DEBUG_LIMIT(level, tag, check, ...) do {                               \
+        if ((level) >= DEBUG_MIN_LEVEL) {                                       \
+            static debug_limit_t _debug_lim;                                    \
+            uint32_t _debug_pass = (check);                                     \
+            if (_debug_pass != 0U) {                                            \
+                _DEBUG_LIMIT_EMIT(level, tag, _debug_pass - 1U, __VA_ARGS__);   \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+
+#if !DEBUG_BINARY_MODE
+    #define _DEBUG_LIMIT_EMIT(level, tag, n, ...)                               \
+        debug_logLimited((level), (n), ((level) >= DEBUG_LEVEL_WARNING) ? __FILE__ : NULL, __LINE__, __VA_ARGS__)
+#else
+    #define _DEBUG_LIMIT_EMIT(level, tag, n, ...)                               \
+        _DEBUG_BIN_RECORD(tag, if ((n) != 0U) debug_binSuppressed(&_debug_rec, (n));, __VA_ARGS__)
+#endif
+
+// Compile-time level filter (DEBUG_MIN_LEVEL): replaces filtered calls with
+// an empty expression, in both text and binary mode.
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_LOG)
+    #undef  debug_log
+    #undef  debug_logWithType
+    #define debug_log(...)              ((void)0)
+    #define debug_logWithType(...)      ((void)0)
+    #undef  debug_moduleLog
+    #define debug_moduleLog(...)        ((void)0)
+    #define debug_hexdump(...)          ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_INFO)
+    #undef  debug_info
+    #define debug_info(...)             ((void)0)
+    #undef  debug_moduleInfo
+    #define debug_moduleInfo(...)       ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_OK)
+    #undef  debug_ok
+    #define debug_ok(...)               ((void)0)
+    #undef  debug_moduleOk
+    #define debug_moduleOk(...)         ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_SUCCESS)
+    #undef  debug_success
+    #define debug_success(...)          ((void)0)
+    #undef  debug_moduleSuccess
+    #define debug_moduleSuccess(...)    ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_WARNING)
+    #undef  debug_warning
+    #define debug_warning(...)          ((void)0)
+    #undef  debug_moduleWarning
+    #define debug_moduleWarning(...)    ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_ERROR)
+    #undef  debug_error
+    #define debug_error(...)            ((void)0)
+    #undef  debug_moduleError
+    #define debug_moduleError(...)      ((void)0)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
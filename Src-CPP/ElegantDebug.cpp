@@ -1,6 +1,6 @@
 /*******************************************************************************
  * @file    ElegantDebug.cpp
- * @version 1.5
+ * @version 1.6
  * @brief   C++ implementation for ANSI-colored debug logging — STM32 HAL,
  *          Renesas RA FSP, TI MSPM0 DL.
  *
@@ -14,8 +14,18 @@
  * `uart_instance_t const*` (RA), or `UART_Regs*` (TI MSPM0), then call
  * `log()`, `info()`, `error()`, etc. See README for examples and integration notes.
  *
+ * With `DEBUG_TX_NONBLOCKING` enabled, `_write()` only copies the line into the
+ * instance's TX ring; the ring is drained by DMA/IT and chained from
+ * `txCpltCallback()`, so the caller never waits for the wire. With
+ * `DEBUG_THREAD_SAFE` the same ring takes lines from any context and the
+ * caller that owns the port drains it.
+ * USB-CDC output always goes through the ring, packed into whole USB packets.
+ *
+ * With `DEBUG_BINARY_MODE` enabled, the `dbg_*` macros build binary records
+ * with the `_bin*()` helpers below `customBgColor()` instead of formatting.
+ *
  * @author:    WilliTourt <willitourt@foxmail.com>
- * @date:      2026-07-24
+ * @date:      2026-10-15
  * 
  * @changelog:
  * - (See header file)
@@ -89,56 +99,822 @@ ElegantDebug::~ElegantDebug() {
 ElegantDebug::~ElegantDebug() {
     if (_uart != nullptr) {
         #ifdef R_SCI_UART_H
-        R_SCI_UART_Close(const_cast<uart_instance_t*>(_uart));
+        R_SCI_UART_Close(_uart->p_ctrl);
         #else
-        R_SCI_B_UART_Close(const_cast<uart_instance_t*>(_uart));
+        R_SCI_B_UART_Close(_uart->p_ctrl);
         #endif
     }
 }
 #endif
 
-void ElegantDebug::_send(const char* text) {
-    char out[DEBUG_BUFFER_LEN * 2];
-    size_t pos = 0;
-    if (_timestamp_enabled) { // Prefix timestamp [hh:mm:ss.mmm] using _getTick()
-        uint32_t ms = _getTick();
-        uint32_t s = ms / 1000U;
-        uint32_t hours = s / 3600U;
-        uint32_t minutes = (s % 3600U) / 60U;
-        uint32_t seconds = s % 60U;
-        pos = snprintf(out, sizeof(out), "[%02lu:%02lu:%02lu.%03lu] ",
-                       (unsigned long)hours, (unsigned long)minutes,
-                       (unsigned long)seconds, (unsigned long)(ms % 1000U));
-        if (pos >= sizeof(out)) pos = 0; // guard
+/*** Atomics ************************************************************/
+
+// Short critical section and 32-bit compare-and-swap, safe against ISRs and
+// RTOS tasks: LDREX/STREX where the core has them, PRIMASK on Cortex-M0/M0+.
+// Host builds (simulators, tests) use the GCC atomic builtins instead.
+#if defined(__ARM_FEATURE_LDREX) && (__ARM_FEATURE_LDREX & 4)
+    #define _ATOMIC_EXCLUSIVE 1
+#elif defined(__GNUC__) && !defined(__arm__) && !defined(__thumb__)
+    #define _ATOMIC_HOST 1
+#endif
+
+#if defined(_ATOMIC_HOST)
+static volatile uint32_t _host_lock = 0;
+#endif
+
+static inline uint32_t _lock() {
+#if defined(_ATOMIC_HOST)
+    while (__atomic_exchange_n(&_host_lock, 1U, __ATOMIC_ACQUIRE) != 0U) {}
+    return 0;
+#else
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+#endif
+}
+
+static inline void _unlock(uint32_t key) {
+#if defined(_ATOMIC_HOST)
+    (void)key;
+    __atomic_store_n(&_host_lock, 0U, __ATOMIC_RELEASE);
+#else
+    __set_PRIMASK(key);
+#endif
+}
+
+#if DEBUG_TX_QUEUED
+#define _TX_IDX_MASK    0x1FFFFU
+#define _TX_WRITER      0x20000U
+
+static inline uint32_t _atomicLoad(volatile uint32_t* p) {
+#if defined(_ATOMIC_HOST)
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    return *p;
+#endif
+}
+
+static inline void _atomicStore(volatile uint32_t* p, uint32_t v) {
+#if defined(_ATOMIC_HOST)
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#else
+    __DMB();    // ring bytes land before the index that publishes them
+    *p = v;
+#endif
+}
+
+static inline bool _atomicCas(volatile uint32_t* p, uint32_t expected, uint32_t desired) {
+#if defined(_ATOMIC_EXCLUSIVE)
+    if (__LDREXW(p) != expected) {
+        __CLREX();
+        return false;
     }
+    return __STREXW(desired, p) == 0U;
+#elif defined(_ATOMIC_HOST)
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#else
+    uint32_t key = _lock();
+    bool ok = (*p == expected);
+    if (ok) *p = desired;
+    _unlock(key);
+    return ok;
+#endif
+}
+
+static inline void _atomicAdd(volatile uint32_t* p, uint32_t v) {
+    uint32_t old;
+    do {
+        old = _atomicLoad(p);
+    } while (!_atomicCas(p, old, old + v));
+}
+#endif
 
-    // append text safely
-    strncpy(out + pos, text, sizeof(out) - pos - 1);
-    out[sizeof(out) - 1] = '\0';
+/************************************************************************/
 
-    #if DEBUG_PLATFORM_STM32
-        #if (USB_AS_DEBUG_PORT == 1)
-        CDC_Transmit_FS((uint8_t*)out, (uint16_t)strlen(out));
-        #else
-        HAL_UART_Transmit(_huart, (uint8_t*)out, (uint16_t)strlen(out), HAL_MAX_DELAY);
+
+
+/*** Statistics **********************************************************/
+
+#if DEBUG_STATS
+#if DEBUG_STATS_CYCLES
+// DWT CYCCNT, started on first use
+static uint32_t _cycles() {
+    if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0U) {
+        CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+        #if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+        DWT->LAR = 0xC5ACCE55U;     // unlock on M7
         #endif
+        DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+    }
+    return DWT->CYCCNT;
+}
+#else
+static inline uint32_t _cycles() {
+    return 0U;
+}
+#endif
+
+// Contexts that log at once (DEBUG_THREAD_SAFE) update the counters one at
+// a time; the 64-bit cycle sums could not be added atomically anyway.
+static inline uint32_t _statsLock() {
+#if DEBUG_THREAD_SAFE
+    return _lock();
+#else
+    return 0U;
+#endif
+}
+
+static inline void _statsUnlock(uint32_t key) {
+#if DEBUG_THREAD_SAFE
+    _unlock(key);
+#else
+    (void)key;
+#endif
+}
+
+void ElegantDebug::_statsLine(uint8_t level, size_t len) {
+    uint32_t key = _statsLock();
+    #if DEBUG_TELEMETRY
+    if (level == _KIND_TELEMETRY) {
+        _stats.tlm_packets++;
+        _stats.tlm_bytes += (uint32_t)len;
+        _statsUnlock(key);
+        return;
+    }
+    #endif
+    _stats.lines[level]++;
+    _stats.bytes[level] += (uint32_t)len;
+    _statsUnlock(key);
+}
+
+void ElegantDebug::_statsCount(uint32_t& counter) {
+    uint32_t key = _statsLock();
+    counter++;
+    _statsUnlock(key);
+}
+
+// Add the cycles since `t0`
+void ElegantDebug::_statsCycles(uint64_t& sum, uint32_t t0) {
+    uint32_t cycles = _cycles() - t0;
+    uint32_t key = _statsLock();
+    sum += cycles;
+    _statsUnlock(key);
+}
+
+#if DEBUG_TX_QUEUED
+void ElegantDebug::_statsHighWater(uint32_t used) {
+    uint32_t key = _statsLock();
+    if (used > _stats.ring_high_water) _stats.ring_high_water = used;
+    _statsUnlock(key);
+}
+#endif
+
+void ElegantDebug::statsReset() {
+    uint32_t key = _statsLock();
+    _stats = Stats();
+    _statsUnlock(key);
+}
+#endif
+
+/************************************************************************/
+
+
+
+/*** TX ring *************************************************************/
+
+#if DEBUG_TX_QUEUED
+// Reserve room for a whole line with one CAS on _tx_claim (reserve index in
+// the low 17 bits, writers still copying in the high bits); returns the start
+// index, or -1 when it does not fit with at least `keep` bytes left free.
+int32_t ElegantDebug::_txReserve(size_t len, size_t keep) {
+    uint32_t claim, start, used;
+    do {
+        claim = _atomicLoad(&_tx_claim);
+        start = claim & _TX_IDX_MASK;
+        used = (start - _atomicLoad(&_tx_tail)) & _TX_IDX_MASK;
+        if (len + keep > DEBUG_TX_RING_LEN - used) return -1;
+    } while (!_atomicCas(&_tx_claim, claim,
+                         ((claim & ~_TX_IDX_MASK) + _TX_WRITER) | ((start + (uint32_t)len) & _TX_IDX_MASK)));
+    #if DEBUG_STATS
+    _statsHighWater(used + (uint32_t)len);
+    #endif
+    return (int32_t)start;
+}
+
+#if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+// Mark the first byte of the line at `start` and clear the marks of older
+// lines in the rest of its bytes. Neighbouring lines share the words.
+void ElegantDebug::_txMark(uint32_t start, size_t len, uint32_t mark) {
+    for (size_t done = 0; done < len; ) {
+        uint32_t pos = (start + (uint32_t)done) & (DEBUG_TX_RING_LEN - 1U);
+        uint32_t shift = (pos & 7U) * 4U;
+        size_t n = 8U - (pos & 7U);
+        if (n > len - done) n = len - done;
+        uint32_t mask = (n == 8U) ? 0xFFFFFFFFU : (((1U << (4U * n)) - 1U) << shift);
+        uint32_t set = (done == 0U) ? (mark << shift) : 0U;
+
+        volatile uint32_t* word = &_tx_marks[pos >> 3];
+        uint32_t old;
+        do {
+            old = _atomicLoad(word);
+        } while (!_atomicCas(word, old, (old & ~mask) | set));
+        done += n;
+    }
+}
+#endif
+
+// The line at `start` is in the ring; `mark` says what it is. The last
+// writer still copying publishes everything reserved so far; a writer that
+// interrupted another one leaves it to them.
+void ElegantDebug::_txCommit(uint32_t start, size_t len, uint32_t mark) {
+    #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+    _txMark(start, len, mark);
+    #else
+    (void)start;
+    (void)len;
+    (void)mark;
+    #endif
+    uint32_t claim;
+    do {
+        claim = _atomicLoad(&_tx_claim);
+    } while (!_atomicCas(&_tx_claim, claim, claim - _TX_WRITER));
+    if (((claim - _TX_WRITER) & ~_TX_IDX_MASK) != 0U) return;
+
+    // A later writer may have published past us already; never move back
+    uint32_t end = claim & _TX_IDX_MASK;
+    uint32_t head;
+    do {
+        head = _atomicLoad(&_tx_head);
+        uint32_t ahead = (end - head) & _TX_IDX_MASK;
+        if (ahead == 0U || ahead > DEBUG_TX_RING_LEN) return;
+    } while (!_atomicCas(&_tx_head, head, end));
+}
+
+void ElegantDebug::_txCopy(uint32_t start, const char* data, size_t len) {
+    uint32_t pos = start & (DEBUG_TX_RING_LEN - 1U);
+    size_t first = DEBUG_TX_RING_LEN - pos;
+    if (first > len) first = len;
+
+    memcpy(&_tx_ring[pos], data, first);
+    memcpy(_tx_ring, data + first, len - first);
+}
+
+// `lines` lines of one level (or telemetry packets), `len` bytes in all,
+// did not make it
+void ElegantDebug::_txDrop(uint8_t level, uint32_t lines, size_t len) {
+    _atomicAdd(&_tx_dropped, (uint32_t)len);
+    _atomicAdd(&_tx_drop_lines[level], lines);
+    _atomicStore(&_tx_drop_new, 1U);
+    #if DEBUG_STATS
+    uint32_t key = _statsLock();
+    #if DEBUG_TELEMETRY
+    if (level == _KIND_TELEMETRY) {
+        _stats.tlm_dropped += lines;
+    } else
+    #endif
+    {
+        _stats.dropped[level] += lines;
+    }
+    _statsUnlock(key);
+    #endif
+}
+#endif
+
+#if (DEBUG_TX_RING_ENABLED && !DEBUG_PLATFORM_TI)
+// Start transmitting the next contiguous chunk of the ring if the port is idle.
+// Called from both thread context and the TX complete ISR.
+void ElegantDebug::_txKick() {
+    uint32_t key = _lock();
+
+    uint32_t head = _atomicLoad(&_tx_head);
+    uint32_t tail = _atomicLoad(&_tx_tail);
+    if (_tx_inflight == 0U && head != tail) {
+        uint32_t start = tail & (DEBUG_TX_RING_LEN - 1U);
+        uint32_t len = (head - tail) & _TX_IDX_MASK;
+        if (len > DEBUG_TX_RING_LEN - start) {
+            len = DEBUG_TX_RING_LEN - start; // up to the end of the ring, rest goes next time
+        }
+
+    #if DEBUG_PLATFORM_STM32
+        HAL_StatusTypeDef status;
+        if (_huart->hdmatx != nullptr) {
+            status = HAL_UART_Transmit_DMA(_huart, &_tx_ring[start], (uint16_t)len);
+        } else {
+            status = HAL_UART_Transmit_IT(_huart, &_tx_ring[start], (uint16_t)len);
+        }
+        // HAL_BUSY: the UART is used elsewhere, retry on the next line
+        if (status == HAL_OK) {
+            _tx_inflight = (uint16_t)len;
+        }
     #elif DEBUG_PLATFORM_RA
+        // The SCI reads the ring in place until UART_EVENT_TX_COMPLETE.
+        // FSP_ERR_IN_USE: the UART is used elsewhere, retry on the next line
         #ifdef R_SCI_UART_H
-        R_SCI_UART_Write(const_cast<uart_instance_t*>(_uart)->p_ctrl,
-                         (uint8_t*)out,
-                         (uint32_t)strlen(out));
+        fsp_err_t err = R_SCI_UART_Write(_uart->p_ctrl, &_tx_ring[start], len);
         #else
-        R_SCI_B_UART_Write(const_cast<uart_instance_t*>(_uart)->p_ctrl,
-                           (uint8_t*)out,
-                           (uint32_t)strlen(out));
+        fsp_err_t err = R_SCI_B_UART_Write(_uart->p_ctrl, &_tx_ring[start], len);
         #endif
+        if (err == FSP_SUCCESS) {
+            _tx_inflight = (uint16_t)len;
+        }
+    #endif
+    }
+
+    _unlock(key);
+}
+
+#if DEBUG_PLATFORM_STM32
+void ElegantDebug::txCpltCallback(UART_HandleTypeDef *huart) {
+    if (huart != _huart) return;
+
+    uint32_t key = _lock();
+    _atomicStore(&_tx_tail, (_tx_tail + _tx_inflight) & _TX_IDX_MASK);
+    _tx_inflight = 0;
+    _unlock(key);
+    _txKick();
+}
+#elif DEBUG_PLATFORM_RA
+void ElegantDebug::txCpltCallback(uart_callback_args_t *p_args) {
+    if (p_args == nullptr || p_args->event != UART_EVENT_TX_COMPLETE) return;
+    if (_uart == nullptr || p_args->channel != _uart->p_cfg->channel) return;
+
+    uint32_t key = _lock();
+    _atomicStore(&_tx_tail, (_tx_tail + _tx_inflight) & _TX_IDX_MASK);
+    _tx_inflight = 0;
+    _unlock(key);
+    _txKick();
+}
+#endif
+
+#elif (DEBUG_TX_RING_ENABLED && DEBUG_PLATFORM_TI)
+// Move queued bytes into the UART TX FIFO until it is full or the ring is
+// empty. While bytes are left, the TX interrupt (FIFO drained to its
+// threshold) calls back in to refill it.
+void ElegantDebug::_txKick() {
+    uint32_t key = _lock();
+
+    uint32_t head = _atomicLoad(&_tx_head);
+    uint32_t tail = _atomicLoad(&_tx_tail);
+    while (head != tail) {
+        uint32_t start = tail & (DEBUG_TX_RING_LEN - 1U);
+        uint32_t len = (head - tail) & _TX_IDX_MASK;
+        if (len > DEBUG_TX_RING_LEN - start) {
+            len = DEBUG_TX_RING_LEN - start;
+        }
+
+        uint32_t n = DL_UART_fillTXFIFO(_uart_inst, &_tx_ring[start], len);
+        if (n == 0U) break;     // FIFO full
+        tail = (tail + n) & _TX_IDX_MASK;
+    }
+    _atomicStore(&_tx_tail, tail);
+
+    if (head != tail) {
+        DL_UART_enableInterrupt(_uart_inst, DL_UART_INTERRUPT_TX);
+    } else {
+        DL_UART_disableInterrupt(_uart_inst, DL_UART_INTERRUPT_TX);
+    }
+
+    _unlock(key);
+}
+
+void ElegantDebug::txCpltCallback(UART_Regs *uart_inst) {
+    if (uart_inst != _uart_inst) return;
+    _txKick();
+}
+#elif DEBUG_TX_CDC_ENABLED
+// Hand the next run of queued bytes to the USB stack. The stack reads them
+// from the ring in place, so they stay reserved until the transfer is done:
+// reported by cdcTxCpltCallback(), or proven by the stack accepting the next
+// transfer. More than a packet is sent as whole packets, the remainder waits
+// to be packed with the lines that follow.
+void ElegantDebug::_txKick() {
+    uint32_t key = _lock();
+
+    uint32_t head = _atomicLoad(&_tx_head);
+    uint32_t tail = _atomicLoad(&_tx_tail);
+    uint32_t next = (tail + _tx_inflight) & _TX_IDX_MASK;
+    if (next != head) {
+        uint32_t start = next & (DEBUG_TX_RING_LEN - 1U);
+        uint32_t len = (head - next) & _TX_IDX_MASK;
+        if (len > DEBUG_TX_RING_LEN - start) {
+            len = DEBUG_TX_RING_LEN - start;
+        }
+        if (len > DEBUG_CDC_PACKET_LEN) {
+            len -= len % DEBUG_CDC_PACKET_LEN;
+        }
+
+        // USBD_BUSY: previous transfer still running, retried on the next
+        // line or from the completion callback
+        if (CDC_Transmit_FS(&_tx_ring[start], (uint16_t)len) == USBD_OK) {
+            _atomicStore(&_tx_tail, next);
+            _tx_inflight = (uint16_t)len;
+        }
+    }
+
+    _unlock(key);
+}
+
+void ElegantDebug::cdcTxCpltCallback() {
+    uint32_t key = _lock();
+    _atomicStore(&_tx_tail, (_tx_tail + _tx_inflight) & _TX_IDX_MASK);
+    _tx_inflight = 0;
+    _unlock(key);
+    _txKick();
+}
+#endif
+
+/************************************************************************/
+
+
+
+#if !(DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED)
+// Send raw bytes on the debug port, blocking until they are out
+void ElegantDebug::_portWrite(const char* data, size_t len) {
+    #if DEBUG_PLATFORM_STM32
+        HAL_UART_Transmit(_huart, (uint8_t*)data, (uint16_t)len, HAL_MAX_DELAY);
     #elif DEBUG_PLATFORM_TI
-        for (size_t i = 0; out[i] != '\0'; i++) {
-            DL_UART_transmitDataBlocking(_uart_inst, (uint8_t)out[i]);
+        for (size_t i = 0; i < len; i++) {
+            DL_UART_transmitDataBlocking(_uart_inst, (uint8_t)data[i]);
+        }
+    #endif
+}
+#endif
+
+#if (DEBUG_TX_QUEUED && !DEBUG_TX_RING_ENABLED && !DEBUG_TX_CDC_ENABLED)
+// Send everything committed to the ring. One caller at a time owns the port;
+// a context that interrupts it only queues, the owner picks the line up
+// before letting go.
+void ElegantDebug::_txDrain() {
+    while (_atomicLoad(&_tx_head) != _atomicLoad(&_tx_tail) && _atomicCas(&_tx_busy, 0U, 1U)) {
+        uint32_t head, tail;
+        while ((head = _atomicLoad(&_tx_head)) != (tail = _atomicLoad(&_tx_tail))) {
+            uint32_t start = tail & (DEBUG_TX_RING_LEN - 1U);
+            uint32_t len = (head - tail) & _TX_IDX_MASK;
+            if (len > DEBUG_TX_RING_LEN - start) len = DEBUG_TX_RING_LEN - start;
+
+            _portWrite((const char*)&_tx_ring[start], len);
+            _atomicStore(&_tx_tail, (tail + len) & _TX_IDX_MASK);
+        }
+        _atomicStore(&_tx_busy, 0U);
+    }
+}
+#endif
+
+#if DEBUG_TX_QUEUED
+// Move queued bytes towards the port
+void ElegantDebug::_txPush() {
+    #if (DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED)
+        _txKick();
+    #else
+        _txDrain();
+    #endif
+}
+
+#if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_BLOCK)
+// Keep the port moving until the line fits or DEBUG_TX_BLOCK_MS is up. Only
+// from thread mode with interrupts enabled: an ISR, or a caller that masks
+// them, would hold off the very interrupt that frees the room.
+int32_t ElegantDebug::_txReserveWait(size_t len) {
+    int32_t start = -1;
+    uint32_t t0 = _getTick();
+    while (__get_IPSR() == 0U && __get_PRIMASK() == 0U) {
+    #if ((DEBUG_TX_RING_ENABLED && !DEBUG_PLATFORM_TI) || DEBUG_TX_CDC_ENABLED)
+        _txKick();
+        // sampled before the retry, so a transfer that just finished is seen
+        uint32_t key = _lock();
+        uint16_t busy = _tx_inflight;
+        _unlock(key);
+        start = _txReserve(len, 0);
+        if (start >= 0 || busy == 0U) break;    // port idle or used elsewhere
+    #else
+        _txPush();
+        start = _txReserve(len, 0);
+        if (start >= 0) break;
+    #endif
+        if (_getTick() - t0 >= DEBUG_TX_BLOCK_MS) break;
+    }
+    return start;
+}
+#endif
+#endif
+
+// Hand a whole line to the debug port (or the TX ring when queued)
+void ElegantDebug::_portSend(uint8_t level, const char* data, size_t len) {
+    if (level >= _KINDS) level = DEBUG_LEVEL_ERROR;
+    #if DEBUG_STATS
+    uint32_t t0 = _cycles();
+    #endif
+
+    #if DEBUG_TX_QUEUED
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_PRIORITY)
+        const size_t reserve = DEBUG_TX_PRIORITY_RESERVE;
+        bool urgent = (level == DEBUG_LEVEL_WARNING || level == DEBUG_LEVEL_ERROR);
+        size_t keep = urgent ? 0U : reserve;
+        #else
+        const size_t reserve = 0;
+        size_t keep = 0;
+        #endif
+
+        // the report is not worth a warning's or an error's room
+        if (_atomicLoad(&_tx_drop_new) != 0U) {
+            _txReport(len + reserve);
+        }
+
+        int32_t start = _txReserve(len, keep);
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_BLOCK)
+        if (start < 0) {
+            start = _txReserveWait(len);
+        }
+        #elif (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+        if (start < 0 && _txEvict(len)) {
+            start = _txReserve(len, 0);
+        }
+        #endif
+        if (start < 0) {            // no room, line dropped
+            _txDrop(level, 1U, len);
+            _txPush();              // retry a refused transfer, a finished one frees room
+        } else {
+            _txCopy((uint32_t)start, data, len);
+            _txCommit((uint32_t)start, len, _TX_MARK_LINE + level);
+            _txPush();
+            #if DEBUG_STATS
+            _statsLine(level, len);
+            #endif
+        }
+    #else
+        _portWrite(data, len);
+        #if DEBUG_STATS
+        _statsLine(level, len);
+        #endif
+    #endif
+
+    #if DEBUG_STATS
+    _statsCycles(_stats.tx_cycles, t0);
+    #endif
+}
+
+#if (DEBUG_SINKS || (DEBUG_CRASHLOG && !DEBUG_BINARY_MODE))
+// Take the ANSI sequences (ESC '[' ... final byte) out of a line, in place
+size_t ElegantDebug::_ansiStrip(char* s, size_t len) {
+    char* o = (char*)memchr(s, '\033', len);
+    if (o == nullptr) return len;
+    const char* p = o;
+    const char* end = s + len;
+    while (p < end) {
+        p++;    // ESC
+        if (p < end && *p == '[') {
+            do { p++; } while (p < end && (uint8_t)(*p - 0x40) > 0x3EU);
+            if (p < end) p++;
+        }
+        const char* next = (const char*)memchr(p, '\033', (size_t)(end - p));
+        if (next == nullptr) next = end;
+        memmove(o, p, (size_t)(next - p));
+        o += next - p;
+        p = next;
+    }
+    return (size_t)(o - s);
+}
+#endif
+
+#if DEBUG_CRASHLOG
+/*** Crash log (see DEBUG_CRASHLOG in header) ***************************/
+
+#define _CRASH_MAGIC    0x4544434CU     // "EDCL"
+
+// Left alone by the startup code: after a reset it still holds the previous
+// session's bytes, after power-up it is garbage that fails the checks
+ElegantDebug::CrashLog ElegantDebug::_crashlog __attribute__((section(DEBUG_CRASHLOG_SECTION)));
+
+// Shared by all instances, like the block
+static bool _crash_started = false;     // block checked since this reset
+static bool _crash_replaying = false;
+static uint32_t _crash_prev = 0;        // head at start-up: end of the previous session
+
+// CRC-32 (IEEE), a nibble at a time
+static uint32_t _crashCrc(const void* data, size_t len) {
+    static const uint32_t t[16] = {
+        0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU, 0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+        0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU, 0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+    };
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t crc = 0xFFFFFFFFU;
+    while (len-- != 0U) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ t[crc & 15U];
+        crc = (crc >> 4) ^ t[crc & 15U];
+    }
+    return ~crc;
+}
+
+// size and head are adjacent, one CRC covers both
+static void _crashCommit(uint32_t head) {
+    ElegantDebug::CrashLog& b = ElegantDebug::_crashlog;
+    b.head = head;
+    b.crc = _crashCrc(&b.size, 8);
+}
+
+// First use since the reset: keep a valid block and remember where the
+// previous session ended, else start an empty one
+static void _crashStart() {
+    ElegantDebug::CrashLog& b = ElegantDebug::_crashlog;
+    _crash_started = true;
+    if (b.magic == _CRASH_MAGIC && b.size == DEBUG_CRASHLOG_LEN && b.crc == _crashCrc(&b.size, 8)) {
+        _crash_prev = b.head;
+        return;
+    }
+    b.magic = _CRASH_MAGIC;
+    b.size = DEBUG_CRASHLOG_LEN;
+    _crashCommit(0);
+    _crash_prev = 0;
+}
+
+// The bytes go in before the header that covers them: a reset halfway
+// through only garbles the oldest line, which the replay skips anyway
+static void _crashWrite(const char* data, size_t len) {
+    if (_crash_replaying) return;
+    if (len > DEBUG_CRASHLOG_LEN) {
+        data += len - DEBUG_CRASHLOG_LEN;
+        len = DEBUG_CRASHLOG_LEN;
+    }
+    ElegantDebug::CrashLog& b = ElegantDebug::_crashlog;
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    if (!_crash_started) _crashStart();
+    uint32_t head = b.head;
+    uint32_t pos = head & (DEBUG_CRASHLOG_LEN - 1U);
+    size_t first = DEBUG_CRASHLOG_LEN - pos;
+    if (first > len) first = len;
+    memcpy(&b.data[pos], data, first);
+    memcpy(b.data, data + first, len - first);
+    _crashCommit(head + (uint32_t)len);
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+}
+
+/************************************************************************/
+#endif
+
+#if DEBUG_SINKS
+/*** Sinks **************************************************************/
+
+void ElegantDebug::_sinkUpdate() {
+    _sink_color = false;
+    _sink_level = DEBUG_LEVEL_NONE;
+    for (uint8_t i = 0; i < _sink_count; i++) {
+        if (!_sinks[i].enabled) continue;
+        if (i != DEBUG_SINK_PORT && _sinks[i].color) _sink_color = true;
+        if (_sinks[i].level < _sink_level) _sink_level = _sinks[i].level;
+    }
+}
+
+#if DEBUG_SINK_RAM_LEN
+void ElegantDebug::_ramWrite(const char* data, size_t len) {
+    if (len > DEBUG_SINK_RAM_LEN) {     // only the end of it fits
+        data += len - DEBUG_SINK_RAM_LEN;
+        len = DEBUG_SINK_RAM_LEN;
+    }
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    uint32_t pos = _ram_head & (DEBUG_SINK_RAM_LEN - 1U);
+    size_t first = DEBUG_SINK_RAM_LEN - pos;
+    if (first > len) first = len;
+    memcpy(&_ram_ring[pos], data, first);
+    memcpy(_ram_ring, data + first, len - first);
+    _ram_head += (uint32_t)len;
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+}
+#endif
+
+void ElegantDebug::_sinkSend(uint8_t i, uint8_t level, const char* data, size_t len) {
+    const Sink& s = _sinks[i];
+    if (i == DEBUG_SINK_PORT) {
+        _portSend(level, data, len);
+    #if DEBUG_SINK_RAM_LEN
+    } else if (i == DEBUG_SINK_RAM) {
+        _ramWrite(data, len);
+    #endif
+    } else {
+        s.write(s.ctx, data, len);
+    }
+}
+
+// Hand a whole text line to every sink that takes its level. Colored sinks
+// get it first, then it is stripped in place for the others.
+void ElegantDebug::_write(uint8_t level, char* data, size_t len) {
+    #if DEBUG_CRASHLOG
+    _crashWrite(data, len);
+    #endif
+    bool esc = memchr(data, '\033', len) != nullptr;
+    uint8_t plain = 0;      // sinks waiting for the stripped line
+    for (uint8_t i = 0; i < _sink_count; i++) {
+        if (!_sinkTakes(i, level)) continue;
+        bool color = (i == DEBUG_SINK_PORT) ? _color_enabled : _sinks[i].color;
+        if (esc && !color) {
+            plain |= (uint8_t)(1U << i);
+        } else {
+            _sinkSend(i, level, data, len);
         }
+    }
+    if (plain == 0U) return;
+    len = _ansiStrip(data, len);
+    for (uint8_t i = 0; i < _sink_count; i++) {
+        if (plain & (1U << i)) _sinkSend(i, level, data, len);
+    }
+}
+
+// Binary records and telemetry packets go to every sink as they are.
+// Packets go where log() lines go.
+void ElegantDebug::_writeRaw(uint8_t level, const char* data, size_t len) {
+    uint8_t take = (level < DEBUG_LEVEL_NONE) ? level : DEBUG_LEVEL_LOG;
+    for (uint8_t i = 0; i < _sink_count; i++) {
+        if (_sinkTakes(i, take)) _sinkSend(i, level, data, len);
+    }
+}
+
+int ElegantDebug::sinkAdd(SinkFn write, void* ctx, uint8_t level, bool color) {
+    if (write == nullptr || _sink_count >= DEBUG_SINK_MAX) return -1;
+    uint8_t i = _sink_count;
+    _sinks[i].write = write;
+    _sinks[i].ctx = ctx;
+    _sinks[i].level = level;
+    _sinks[i].color = color;
+    _sinks[i].enabled = true;
+    _sink_count = i + 1U;
+    _sinkUpdate();
+    return i;
+}
+
+void ElegantDebug::sinkEnable(uint8_t sink, bool enabled) {
+    if (sink >= _sink_count) return;
+    _sinks[sink].enabled = enabled;
+    _sinkUpdate();
+}
+
+void ElegantDebug::sinkSetLevel(uint8_t sink, uint8_t level) {
+    if (sink >= _sink_count) return;
+    _sinks[sink].level = level;
+    _sinkUpdate();
+}
+
+void ElegantDebug::sinkSetColor(uint8_t sink, bool color) {
+    if (sink == DEBUG_SINK_PORT) {
+        _color_enabled = color;
+    } else if (sink < _sink_count) {
+        _sinks[sink].color = color;
+        _sinkUpdate();
+    }
+}
+
+#if DEBUG_SINK_RAM_LEN
+size_t ElegantDebug::sinkRamRead(char* dst, size_t size) {
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    uint32_t head = _ram_head;
+    size_t n = (head < DEBUG_SINK_RAM_LEN) ? head : DEBUG_SINK_RAM_LEN;
+    if (n > size) n = size;
+    uint32_t pos = (head - (uint32_t)n) & (DEBUG_SINK_RAM_LEN - 1U);
+    size_t first = DEBUG_SINK_RAM_LEN - pos;
+    if (first > n) first = n;
+    memcpy(dst, &_ram_ring[pos], first);
+    memcpy(dst + first, _ram_ring, n - first);
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+
+    // start at a whole line unless everything since start-up fits
+    if (n < head) {
+        char* nl = (char*)memchr(dst, '\n', n);
+        size_t skip = (nl != nullptr) ? (size_t)(nl + 1 - dst) : n;
+        memmove(dst, dst + skip, n - skip);
+        n -= skip;
+    }
+    return n;
+}
+#endif
+
+/************************************************************************/
+#else
+
+void ElegantDebug::_write(uint8_t level, char* data, size_t len) {
+    #if DEBUG_CRASHLOG
+    _crashWrite(data, len);
     #endif
+    _portSend(level, data, len);
+}
+
+void ElegantDebug::_writeRaw(uint8_t level, const char* data, size_t len) {
+    _portSend(level, data, len);
 }
 
+#endif // DEBUG_SINKS
+
 uint32_t ElegantDebug::_getTick() {
     #if DEBUG_PLATFORM_STM32
     return HAL_GetTick();
@@ -148,166 +924,1478 @@ uint32_t ElegantDebug::_getTick() {
 }
 
 
-void ElegantDebug::log(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
-    _send(msg);
+// Type prefix for the helpers, [colored][level]; log() has none.
+// Lengths come from the literal types, so a line starts with one copy.
+struct ElegantDebug::Prefix {
+    const char* text;
+    uint8_t len;
+};
+
+template <size_t N>
+constexpr ElegantDebug::Prefix ElegantDebug::_prefixOf(const char (&s)[N]) {
+    static_assert(N <= 256, "prefix too long");
+    return Prefix{s, static_cast<uint8_t>(N - 1)};
+}
+
+const ElegantDebug::Prefix ElegantDebug::_prefixes[2][DEBUG_LEVEL_NONE] = {
+    { _prefixOf(""), _prefixOf(INFO_TYPE_PLAIN), _prefixOf(OK_TYPE_PLAIN),
+      _prefixOf(SUCCESS_TYPE_PLAIN), _prefixOf(WARNING_TYPE_PLAIN), _prefixOf(ERROR_TYPE_PLAIN) },
+    { _prefixOf(""), _prefixOf(INFO_TYPE), _prefixOf(OK_TYPE),
+      _prefixOf(SUCCESS_TYPE), _prefixOf(WARNING_TYPE), _prefixOf(ERROR_TYPE) },
+};
+
+const ElegantDebug::Prefix& ElegantDebug::_prefix(uint8_t level) const {
+    // each table length is its literal's, none cut by the uint8_t
+    static_assert(_prefixOf(INFO_TYPE_PLAIN).len == sizeof(INFO_TYPE_PLAIN) - 1U &&
+                  _prefixOf(INFO_TYPE).len == sizeof(INFO_TYPE) - 1U, "INFO prefix length");
+    static_assert(_prefixOf(OK_TYPE_PLAIN).len == sizeof(OK_TYPE_PLAIN) - 1U &&
+                  _prefixOf(OK_TYPE).len == sizeof(OK_TYPE) - 1U, "OK prefix length");
+    static_assert(_prefixOf(SUCCESS_TYPE_PLAIN).len == sizeof(SUCCESS_TYPE_PLAIN) - 1U &&
+                  _prefixOf(SUCCESS_TYPE).len == sizeof(SUCCESS_TYPE) - 1U, "SUCCESS prefix length");
+    static_assert(_prefixOf(WARNING_TYPE_PLAIN).len == sizeof(WARNING_TYPE_PLAIN) - 1U &&
+                  _prefixOf(WARNING_TYPE).len == sizeof(WARNING_TYPE) - 1U, "WARNING prefix length");
+    static_assert(_prefixOf(ERROR_TYPE_PLAIN).len == sizeof(ERROR_TYPE_PLAIN) - 1U &&
+                  _prefixOf(ERROR_TYPE).len == sizeof(ERROR_TYPE) - 1U, "ERROR prefix length");
+    return _prefixes[_colorOn() ? 1 : 0][level];
+}
+
+/*** Formatter ***********************************************************/
+
+// Two-digit decimal table, shared by the formatter and the timestamp
+static const char _dec_lut[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+#if !DEBUG_BINARY_MODE
+// Two upper-case hex digits per byte value, for hexdump()
+static const char _hex_lut[513] =
+    "000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+#endif
+
+#if DEBUG_BUILTIN_PRINTF
+// Small reentrant vsnprintf() replacement, see DEBUG_BUILTIN_PRINTF. Digits
+// come from lookup tables; 64-bit division is only used for values that do
+// not fit in 32 bits.
+
+#define _FMT_LEFT   0x01U
+#define _FMT_ZERO   0x02U
+#define _FMT_PLUS   0x04U
+#define _FMT_SPACE  0x08U
+#define _FMT_ALT    0x10U
+
+static const char _hex_lower[] = "0123456789abcdef";
+static const char _hex_upper[] = "0123456789ABCDEF";
+
+struct _fmt_out_t {
+    char* buf;
+    size_t pos;
+    size_t cap;     // usable bytes, the terminating NUL excluded
+};
+
+static void _fmtPut(_fmt_out_t* o, const char* s, size_t n) {
+    if (n > o->cap - o->pos) n = o->cap - o->pos;
+    memcpy(o->buf + o->pos, s, n);
+    o->pos += n;
+}
+
+static void _fmtPad(_fmt_out_t* o, char c, int n) {
+    while (n-- > 0 && o->pos < o->cap) {
+        o->buf[o->pos++] = c;
+    }
+}
+
+// Decimal digits of v, written backwards ending at `end`; returns the count
+static size_t _fmtDec32(char* end, uint32_t v) {
+    char* p = end;
+    while (v >= 100U) {
+        uint32_t r = (v % 100U) * 2U;
+        v /= 100U;
+        *--p = _dec_lut[r + 1U];
+        *--p = _dec_lut[r];
+    }
+    if (v >= 10U) {
+        *--p = _dec_lut[v * 2U + 1U];
+        *--p = _dec_lut[v * 2U];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    return (size_t)(end - p);
+}
+
+static size_t _fmtDec(char* end, uint64_t v) {
+    char* p = end;
+    while (v > 0xFFFFFFFFULL) {
+        uint32_t low = (uint32_t)(v % 1000000000U);
+        v /= 1000000000U;
+        size_t n = _fmtDec32(p, low);
+        p -= n;
+        while (n++ < 9U) *--p = '0';
+    }
+    p -= _fmtDec32(p, (uint32_t)v);
+    return (size_t)(end - p);
+}
+
+static size_t _fmtBase(char* end, uint64_t v, unsigned shift, const char* digits) {
+    char* p = end;
+    unsigned mask = (1U << shift) - 1U;
+    do {
+        *--p = digits[v & mask];
+        v >>= shift;
+    } while (v != 0U);
+    return (size_t)(end - p);
+}
+
+// One field: [prefix][zeros][body], padded to `width`
+static void _fmtField(_fmt_out_t* o, const char* prefix, size_t plen, int zeros,
+                      const char* body, size_t blen, int width, unsigned flags) {
+    if (zeros < 0) zeros = 0;
+    int pad = width - (int)(plen + blen) - zeros;
+
+    if (!(flags & (_FMT_LEFT | _FMT_ZERO))) _fmtPad(o, ' ', pad);
+    _fmtPut(o, prefix, plen);
+    if ((flags & (_FMT_LEFT | _FMT_ZERO)) == _FMT_ZERO) _fmtPad(o, '0', pad);
+    _fmtPad(o, '0', zeros);
+    _fmtPut(o, body, blen);
+    if (flags & _FMT_LEFT) _fmtPad(o, ' ', pad);
+}
+
+#if DEBUG_PRINTF_FLOAT
+static const uint32_t _pow10[10] = {
+    1U, 10U, 100U, 1000U, 10000U, 100000U, 1000000U, 10000000U, 100000000U, 1000000000U
+};
+
+// Rounding error of p = a * b (Dekker's two-product): a * b == p + error
+// exactly, without fma() or libm
+static double _fmtMulError(double a, double b, double p) {
+    const double split = 134217729.0;   // 2^27 + 1
+    double t = a * split;
+    double ah = t - (t - a);
+    double al = a - ah;
+    t = b * split;
+    double bh = t - (t - b);
+    double bl = b - bh;
+    return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+// Fixed point %f, rounded to nearest on the last digit, ties to even
+static void _fmtFloat(_fmt_out_t* o, double v, int prec, int width, unsigned flags) {
+    char tmp[32];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+    char sign = 0;
+
+    if (prec < 0) prec = 6;
+    if (prec > 9) prec = 9;
+
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    if (bits >> 63) {       // sign bit: also -0.0, which compares equal to 0
+        sign = '-';
+        v = -v;
+    } else if (flags & _FMT_PLUS) {
+        sign = '+';
+    } else if (flags & _FMT_SPACE) {
+        sign = ' ';
+    }
+
+    if (v != v || v > 1.8e19) {   // NaN, inf, or beyond 64 bits
+        const char* s = (v != v) ? "nan" : ((v - v) != (v - v)) ? "inf" : "ovf";
+        _fmtField(o, &sign, sign ? 1U : 0U, 0, s, 3U, width, flags & ~_FMT_ZERO);
+        return;
+    }
+
+    uint64_t ipart = (uint64_t)v;
+    double frac = v - (double)ipart;            // exact
+    double scaled = frac * _pow10[prec];
+    uint32_t fpart = (uint32_t)scaled;
+    double rest = scaled - fpart;
+
+    // A product that rounded to exactly .5 may come from just above or below
+    // it (0.05 is 0.05000000000000000277): the rounding error decides, and
+    // only a true tie goes to even
+    bool up = rest > 0.5;
+    if (rest == 0.5) {
+        double error = _fmtMulError(frac, (double)_pow10[prec], scaled);
+        up = (error > 0.0) || (error == 0.0 && (prec ? (fpart & 1U) : (uint32_t)(ipart & 1U)));
+    }
+    if (up) {
+        if (++fpart >= _pow10[prec]) {
+            fpart = 0;
+            ipart++;
+        }
+    }
+
+    if (prec > 0) {
+        size_t n = _fmtDec32(p, fpart);
+        p -= n;
+        while (n++ < (size_t)prec) *--p = '0';
+    }
+    if (prec > 0 || (flags & _FMT_ALT)) *--p = '.';
+    p -= _fmtDec(p, ipart);
+
+    _fmtField(o, &sign, sign ? 1U : 0U, 0, p, (size_t)(end - p), width, flags);
+}
+#endif
+
+// Formats into buf (always NUL-terminated when size > 0) and returns the
+// number of characters written, truncation included.
+static size_t _vformat(char* buf, size_t size, const char* format, va_list args) {
+    if (size == 0U) return 0U;
+
+    _fmt_out_t o = { buf, 0U, size - 1U };
+    const char* f = format;
+
+    while (*f != '\0') {
+        if (*f != '%') {
+            const char* lit = f;
+            while (*f != '\0' && *f != '%') f++;
+            _fmtPut(&o, lit, (size_t)(f - lit));
+            continue;
+        }
+        f++;
+
+        unsigned flags = 0;
+        for (;; f++) {
+            if      (*f == '-') flags |= _FMT_LEFT;
+            else if (*f == '0') flags |= _FMT_ZERO;
+            else if (*f == '+') flags |= _FMT_PLUS;
+            else if (*f == ' ') flags |= _FMT_SPACE;
+            else if (*f == '#') flags |= _FMT_ALT;
+            else break;
+        }
+
+        int width = 0;
+        if (*f == '*') {
+            width = va_arg(args, int);
+            if (width < 0) {
+                flags |= _FMT_LEFT;
+                width = -width;
+            }
+            f++;
+        } else {
+            while (*f >= '0' && *f <= '9') width = width * 10 + (*f++ - '0');
+        }
+
+        int prec = -1;
+        if (*f == '.') {
+            f++;
+            prec = 0;
+            if (*f == '*') {
+                prec = va_arg(args, int);
+                if (prec < 0) prec = -1;
+                f++;
+            } else {
+                while (*f >= '0' && *f <= '9') prec = prec * 10 + (*f++ - '0');
+            }
+        }
+
+        // Length modifier: 'H' char, 'h' short, 'l' long, 'q' long long,
+        // 'z' size_t, 't' ptrdiff_t
+        char len = 0;
+        if (*f == 'h') {
+            len = (f[1] == 'h') ? 'H' : 'h';
+            f += (f[1] == 'h') ? 2 : 1;
+        } else if (*f == 'l') {
+            len = (f[1] == 'l') ? 'q' : 'l';
+            f += (f[1] == 'l') ? 2 : 1;
+        } else if (*f == 'j') {
+            len = 'q';
+            f++;
+        } else if (*f == 'z' || *f == 't') {
+            len = *f++;
+        } else if (*f == 'L') {
+            f++;
+        }
+
+        char tmp[24];
+        char* end = tmp + sizeof(tmp);
+        char spec = *f;
+        if (spec == '\0') break;
+        f++;
+
+        switch (spec) {
+            case 'd':
+            case 'i': {
+                int64_t v;
+                if      (len == 'q') v = va_arg(args, long long);
+                else if (len == 'l') v = va_arg(args, long);
+                else if (len == 'z') v = (int64_t)va_arg(args, size_t);
+                else if (len == 't') v = va_arg(args, ptrdiff_t);
+                else                 v = va_arg(args, int);
+                if      (len == 'h') v = (short)v;
+                else if (len == 'H') v = (signed char)v;
+
+                char sign = (v < 0) ? '-' : (flags & _FMT_PLUS) ? '+' : (flags & _FMT_SPACE) ? ' ' : 0;
+                uint64_t u = (v < 0) ? (0U - (uint64_t)v) : (uint64_t)v;
+                size_t n = (prec == 0 && u == 0U) ? 0U : _fmtDec(end, u);
+                if (prec >= 0) flags &= ~_FMT_ZERO;
+                _fmtField(&o, &sign, sign ? 1U : 0U, prec - (int)n, end - n, n, width, flags);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                uint64_t u;
+                if      (len == 'q') u = va_arg(args, unsigned long long);
+                else if (len == 'l') u = va_arg(args, unsigned long);
+                else if (len == 'z') u = va_arg(args, size_t);
+                else if (len == 't') u = (uint64_t)va_arg(args, ptrdiff_t);
+                else                 u = va_arg(args, unsigned int);
+                if      (len == 'h') u = (unsigned short)u;
+                else if (len == 'H') u = (unsigned char)u;
+
+                size_t n = 0;
+                const char* prefix = "";
+                if (prec == 0 && u == 0U) {
+                    n = 0;
+                } else if (spec == 'u') {
+                    n = _fmtDec(end, u);
+                } else if (spec == 'o') {
+                    n = _fmtBase(end, u, 3U, _hex_lower);
+                    if ((flags & _FMT_ALT) && end[-(int)n] != '0' && prec <= (int)n) prefix = "0";
+                } else {
+                    n = _fmtBase(end, u, 4U, (spec == 'x') ? _hex_lower : _hex_upper);
+                    if ((flags & _FMT_ALT) && u != 0U) prefix = (spec == 'x') ? "0x" : "0X";
+                }
+                if (prec >= 0) flags &= ~_FMT_ZERO;
+                _fmtField(&o, prefix, strlen(prefix), prec - (int)n, end - n, n, width, flags);
+                break;
+            }
+            case 'p': {
+                uintptr_t u = (uintptr_t)va_arg(args, void*);
+                size_t n = _fmtBase(end, u, 4U, _hex_lower);
+                _fmtField(&o, "0x", 2U, prec - (int)n, end - n, n, width, flags & ~_FMT_ZERO);
+                break;
+            }
+            case 'c': {
+                char c = (char)va_arg(args, int);
+                _fmtField(&o, "", 0U, 0, &c, 1U, width, flags & ~_FMT_ZERO);
+                break;
+            }
+            case 's': {
+                const char* s = va_arg(args, const char*);
+                if (s == nullptr) s = "(null)";
+                size_t n = 0;
+                while (s[n] != '\0' && (prec < 0 || n < (size_t)prec)) n++;
+                _fmtField(&o, "", 0U, 0, s, n, width, flags & ~_FMT_ZERO);
+                break;
+            }
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double v = va_arg(args, double);
+            #if DEBUG_PRINTF_FLOAT
+                _fmtFloat(&o, v, prec, width, flags);
+            #else
+                (void)v;
+                _fmtField(&o, "", 0U, 0, "?", 1U, width, flags & ~_FMT_ZERO);
+            #endif
+                break;
+            }
+            case '%':
+                _fmtPut(&o, "%", 1U);
+                break;
+            default:    // unknown conversion, print it as is
+                _fmtPut(&o, f - 2, 2U);
+                break;
+        }
+    }
+
+    buf[o.pos] = '\0';
+    return o.pos;
+}
+
+#else
+
+static size_t _vformat(char* buf, size_t size, const char* format, va_list args) {
+    if (size == 0U) return 0U;
+    int n = vsnprintf(buf, size, format, args);
+    if (n < 0) return 0U;
+    return ((size_t)n < size) ? (size_t)n : (size - 1U); // truncated
+}
+
+#endif // DEBUG_BUILTIN_PRINTF
+
+static size_t _format(char* buf, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    size_t n = _vformat(buf, size, format, args);
+    va_end(args);
+    return n;
+}
+
+/************************************************************************/
+
+
+
+/*** Clock *************************************************************/
+
+#if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT)
+// CYCCNT extended to 64-bit microseconds on every read. The cycles since the
+// last read are converted exactly, in units of 1/SystemCoreClock us, and the
+// remainder is carried to the next read, so the count does not drift from
+// the core clock whatever its frequency (2.097 MHz, 32.768 kHz ...). It
+// restarts from the ms tick, with SystemCoreClock read again, when no line
+// was logged for half a CYCCNT period or SystemCoreClock has changed.
+static uint32_t _clk_cyc;           // CYCCNT at the last read
+static uint32_t _clk_tick;          // ms tick at the last read
+static uint32_t _clk_rem;           // microseconds * SystemCoreClock not yet counted
+static uint32_t _clk_hz = 0;        // SystemCoreClock the count runs at, 0 until started
+static uint32_t _clk_stale_ms;
+static uint64_t _clk_now;
+
+uint64_t ElegantDebug::_clockDwt() {
+    uint32_t tick = _getTick();
+    uint32_t cyc = DWT->CYCCNT;
+
+    if (_clk_hz != SystemCoreClock || tick - _clk_tick >= _clk_stale_ms) {
+        if (_clk_hz == 0U) {
+            CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;
+            #if defined(__CORTEX_M) && (__CORTEX_M == 7U)
+            DWT->LAR = 0xC5ACCE55U;     // unlock on M7
+            #endif
+            DWT->CTRL = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+            cyc = DWT->CYCCNT;
+        }
+        _clk_hz = SystemCoreClock;
+        uint32_t per_ms = _clk_hz / 1000U;
+        _clk_stale_ms = (0xFFFFFFFFU / ((per_ms != 0U) ? per_ms : 1U)) / 2U;
+        _clk_now = (uint64_t)tick * 1000U;
+        _clk_rem = 0;
+    } else {
+        // Below 2^32 cycles * 10^6 + SystemCoreClock: no overflow
+        uint64_t scaled = (uint64_t)(cyc - _clk_cyc) * 1000000U + _clk_rem;
+        _clk_now += scaled / _clk_hz;
+        _clk_rem = (uint32_t)(scaled % _clk_hz);
+    }
+
+    _clk_cyc = cyc;
+    _clk_tick = tick;
+    return _clk_now;
+}
+
+#elif (DEBUG_CLOCK_USED == DEBUG_CLOCK_SYSTICK)
+// ms tick plus the elapsed part of the current SysTick period
+static uint32_t _clk_load = 0;      // SysTick->LOAD + 1 the scale was computed for
+static uint32_t _clk_scale;         // microseconds per count, 12.20 fixed point
+
+uint64_t ElegantDebug::_clockSysTick() {
+    uint32_t tick, val, pending;
+    do {
+        tick = _getTick();
+        val = SysTick->VAL;
+        pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+    } while (tick != _getTick());
+
+    uint32_t load = SysTick->LOAD + 1U;
+    if (load != _clk_load) {
+        _clk_load = load;
+        _clk_scale = (1000U << 20) / load;
+    }
+    // Reloaded but the tick ISR has not run yet (interrupts masked)
+    if (pending && val > load / 2U) tick++;
+
+    uint32_t counted = load - 1U - val;     // SysTick counts down
+    return (uint64_t)tick * 1000U + ((counted * _clk_scale) >> 20);
+}
+#endif
+
+/************************************************************************/
+
+
+
+/*** Timestamp ***********************************************************/
+
+// "[hh:mm:ss.mmm] " (or ".mmmuuu") is kept rendered. The "[hh:mm:ss." part
+// only changes when the second does; gaps under a minute are stepped forward
+// without dividing, longer ones recompute it. Lines within the same tick
+// reuse the text as is.
+#if DEBUG_TIMESTAMP_US
+#define _TS_PER_SEC     1000000U
+#define _TS_FRAC_LEN    6U
+#else
+#define _TS_PER_SEC     1000U
+#define _TS_FRAC_LEN    3U
+#endif
+
+ElegantDebug::TsTime ElegantDebug::_clockNow() {
+    if (_clock_us != nullptr) {
+    #if DEBUG_TIMESTAMP_US
+        return _clock_us();
+    #else
+        return (uint32_t)(_clock_us() / 1000U);
+    #endif
+    }
+#if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT)
+    return _clockDwt();
+#elif (DEBUG_CLOCK_USED == DEBUG_CLOCK_SYSTICK)
+    return _clockSysTick();
+#else
+    return (TsTime)_getTick() * (_TS_PER_SEC / 1000U);
+#endif
+}
+
+static void _tsPut2(char* p, uint32_t v) {
+    p[0] = _dec_lut[v * 2U];
+    p[1] = _dec_lut[v * 2U + 1U];
+}
+
+static void _tsPut3(char* p, uint32_t v) {
+    uint32_t hundreds = (v * 41U) >> 12;        // v / 100 for v < 1000
+    p[0] = (char)('0' + hundreds);
+    _tsPut2(p + 1, v - hundreds * 100U);
+}
+
+void ElegantDebug::_tsRenderSecond() {
+    char* p = _ts_text;
+    uint32_t h = _ts_hours;
+
+    *p++ = '[';
+    if (h >= 100U) {        // past 100 h of uptime, once per second
+        char digits[10];
+        char* end = digits + sizeof(digits);
+        char* q = end;
+        uint32_t hi = h / 100U;
+        h -= hi * 100U;
+        do {
+            *--q = (char)('0' + hi % 10U);
+            hi /= 10U;
+        } while (hi != 0U);
+        memcpy(p, q, (size_t)(end - q));
+        p += end - q;
+    }
+    _tsPut2(p, h);
+    p[2] = ':';
+    _tsPut2(p + 3, _ts_minutes);
+    p[5] = ':';
+    _tsPut2(p + 6, _ts_seconds);
+    p[8] = '.';
+    p += 9 + _TS_FRAC_LEN;
+    p[0] = ']';
+    p[1] = ' ';
+    _ts_len = (uint8_t)(p + 2 - _ts_text);
+}
+
+void ElegantDebug::_tsUpdate(TsTime now) {
+    if (_ts_len != 0U && now == _ts_time) return;
+
+    TsTime elapsed = now - _ts_sec_start;
+    if (_ts_len == 0U || now < _ts_sec_start || elapsed >= 60U * (TsTime)_TS_PER_SEC) {
+        // first line, clock went back or wrapped, or a long gap: recompute
+    #if DEBUG_TIMESTAMP_US
+        uint32_t s = (uint32_t)(now / _TS_PER_SEC);
+        uint32_t h = s / 3600U;
+    #else
+        uint32_t s = (uint32_t)(((uint64_t)now * 274877907U) >> 38);       // ms / 1000
+        uint32_t h = (uint32_t)(((uint64_t)s * 2386093U) >> 33);            // s / 3600
+    #endif
+        uint32_t rem = s - h * 3600U;
+        uint32_t m = (rem * 2185U) >> 17;                                   // rem / 60
+        _ts_sec_start = (TsTime)s * _TS_PER_SEC;
+        _ts_hours = h;
+        _ts_minutes = (uint8_t)m;
+        _ts_seconds = (uint8_t)(rem - m * 60U);
+        _tsRenderSecond();
+    } else if (elapsed >= _TS_PER_SEC) {
+        do {
+            _ts_sec_start += _TS_PER_SEC;
+            if (++_ts_seconds == 60U) {
+                _ts_seconds = 0;
+                if (++_ts_minutes == 60U) {
+                    _ts_minutes = 0;
+                    _ts_hours++;
+                }
+            }
+        } while (now - _ts_sec_start >= _TS_PER_SEC);
+        _tsRenderSecond();
+    }
+
+    uint32_t frac = (uint32_t)(now - _ts_sec_start);
+    char* p = _ts_text + _ts_len - 2U - _TS_FRAC_LEN;
+#if DEBUG_TIMESTAMP_US
+    uint32_t ms = (uint32_t)(((uint64_t)frac * 274877907U) >> 38);         // frac / 1000
+    _tsPut3(p, ms);
+    _tsPut3(p + 3, frac - ms * 1000U);
+#else
+    _tsPut3(p, frac);
+#endif
+    _ts_time = now;
+}
+
+/************************************************************************/
+
+
+
+// Lines are assembled once, in place: timestamp, prefix, [file:line] and the
+// message are written into one stack buffer and the length is carried to
+// _write() instead of being re-measured.
+struct ElegantDebug::Line {
+    char buf[DEBUG_BUFFER_LEN + 128];
+    size_t len = 0;
+    #if DEBUG_STATS
+    uint32_t t0 = _cycles();
+    #endif
+    #if DEBUG_REPEAT_SUPPRESS
+    size_t body = 0;    // start of the text after the timestamp
+    #endif
+
+    void put(const char* s, size_t n) {
+        size_t room = sizeof(buf) - len;
+        if (n > room) n = room;
+        memcpy(buf + len, s, n);
+        len += n;
+    }
+
+    void str(const char* s) { put(s, strlen(s)); }
+
+    void format(const char* fmt, va_list args) {
+        len += _vformat(buf + len, sizeof(buf) - len, fmt, args);
+    }
+
+    void printf(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        format(fmt, args);
+        va_end(args);
+    }
+};
+
+// Current timestamp text [hh:mm:ss.mmm] into dst (at least sizeof(_ts_text)
+// bytes), or nothing when timestamps are off
+size_t ElegantDebug::_tsCopy(char* dst) {
+    if (!_timestamp_enabled) return 0;
+    #if DEBUG_THREAD_SAFE
+    // the cached text and the clock state are shared by every context
+    uint32_t key = _lock();
+    #endif
+    _tsUpdate(_clockNow());
+    size_t n = _ts_len;
+    memcpy(dst, _ts_text, n);
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+    return n;
+}
+
+void ElegantDebug::_lineBegin(Line& l) {
+    l.len = _tsCopy(l.buf);
+    #if DEBUG_REPEAT_SUPPRESS
+    l.body = l.len;
+    #endif
+}
+
+#if DEBUG_REPEAT_SUPPRESS
+// FNV-1a, one pass over the rendered text
+static uint32_t _repeatHash(const char* s, size_t n) {
+    uint32_t h = 2166136261U;
+    while (n-- != 0U) {
+        h = (h ^ (uint8_t)*s++) * 16777619U;
+    }
+    return h;
+}
+
+// "[ts] <prefix>last message repeated N times"
+void ElegantDebug::_repeatSend(uint8_t level, uint32_t count) {
+    char buf[sizeof(_ts_text) + 96];
+    size_t n = _tsCopy(buf);
+    n += _format(buf + n, sizeof(buf) - n, "%slast message repeated %lu times\n",
+                 _prefix(level).text, (unsigned long)count);
+    _write(level, buf, n);
+}
+
+// Take the counts whose timeout has passed into `report`. Called locked.
+void ElegantDebug::_repeatExpire(uint32_t now, uint32_t* report) {
+    for (uint8_t i = 0; _repeat_pending != 0U && i < DEBUG_LEVEL_NONE; i++) {
+        if ((_repeat_pending & (1U << i)) != 0U &&
+            now - _repeat[i].since >= DEBUG_REPEAT_TIMEOUT_MS) {
+            report[i] = _repeat[i].count;
+            _repeat[i].count = 0;
+            _repeat_pending &= (uint8_t)~(1U << i);
+        }
+    }
+}
+
+// True when the line repeats the last one of its level and is to be dropped.
+// Counts are reported before a different line of the level, or once
+// DEBUG_REPEAT_TIMEOUT_MS have passed since the first dropped copy (checked
+// on every line, of any level, and in repeatPoll()).
+bool ElegantDebug::_repeatFilter(uint8_t level, const char* text, size_t n) {
+    uint32_t report[DEBUG_LEVEL_NONE] = {};
+    uint32_t hash = _repeatHash(text, n);
+    size_t head = (n < DEBUG_REPEAT_KEEP_LEN) ? n : DEBUG_REPEAT_KEEP_LEN;
+    uint32_t now = _getTick();
+    bool drop;
+
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    Repeat& r = _repeat[level];
+    if (r.hash == hash && r.len == n && memcmp(r.head, text, head) == 0) {
+        if (r.count++ == 0U) {
+            r.since = now;
+            _repeat_pending |= (uint8_t)(1U << level);
+        }
+        drop = true;
+    } else {
+        r.hash = hash;
+        r.len = (uint32_t)n;
+        memcpy(r.head, text, head);
+        report[level] = r.count;
+        r.count = 0;
+        _repeat_pending &= (uint8_t)~(1U << level);
+        drop = false;
+    }
+    _repeatExpire(now, report);
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+
+    for (uint8_t i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        if (report[i] != 0U) _repeatSend(i, report[i]);
+    }
+    return drop;
+}
+
+void ElegantDebug::setRepeatSuppressEnabled(bool enabled) {
+    _repeat_enabled = enabled;
+    if (enabled) return;
+
+    // report what is pending and forget the last lines
+    uint32_t report[DEBUG_LEVEL_NONE];
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    for (uint8_t i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        report[i] = _repeat[i].count;
+        _repeat[i] = Repeat{};
+    }
+    _repeat_pending = 0;
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+
+    for (uint8_t i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        if (report[i] != 0U) _repeatSend(i, report[i]);
+    }
+}
+
+void ElegantDebug::repeatPoll() {
+    uint32_t report[DEBUG_LEVEL_NONE] = {};
+    if (_repeat_pending == 0U) return;
+
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    _repeatExpire(_getTick(), report);
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+
+    for (uint8_t i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        if (report[i] != 0U) _repeatSend(i, report[i]);
+    }
+}
+#endif
+
+// Hand the finished line to _write()
+void ElegantDebug::_lineEnd(Line& l, uint8_t level) {
+    #if DEBUG_REPEAT_SUPPRESS
+    if (level >= DEBUG_LEVEL_NONE) level = DEBUG_LEVEL_ERROR;
+    if (_repeat_enabled && _repeatFilter(level, l.buf + l.body, l.len - l.body)) {
+        #if DEBUG_STATS
+        _statsCycles(_stats.log_cycles, l.t0);
+        #endif
+        return;
+    }
+    #endif
+    _write(level, l.buf, l.len);
+    #if DEBUG_STATS
+    if (l.len >= sizeof(l.buf) - 1U) {      // filled up, most likely cut
+        _statsCount(_stats.truncated);
+    }
+    _statsCycles(_stats.log_cycles, l.t0);
+    #endif
+}
+
+#if (DEBUG_TX_QUEUED || (DEBUG_STATS && DEBUG_MIN_LEVEL <= DEBUG_LEVEL_INFO))
+static const char* const _level_names[DEBUG_LEVEL_NONE] = {
+    "log", "info", "ok", "success", "warning", "error"
+};
+#endif
+
+#if DEBUG_TX_QUEUED
+// Tell the reader how many lines went missing, as soon as the report fits
+// with `room` bytes to spare for the line that is about to follow it:
+// "[WARNING] 12 lines dropped (1 warning, 11 info)", followed by
+// ", 4 telemetry packets" (or "[WARNING] 4 telemetry packets dropped")
+void ElegantDebug::_txReport(size_t room) {
+    if (!_atomicCas(&_tx_reporting, 0U, 1U)) return;  // another context is on it
+    _atomicStore(&_tx_drop_new, 0U);    // drops from here on flag a new report
+
+    uint32_t count[_KINDS];
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _KINDS; i++) {
+        count[i] = _atomicLoad(&_tx_drop_lines[i]) - _atomicLoad(&_tx_drop_shown[i]);
+        if (i < DEBUG_LEVEL_NONE) total += count[i];
+    }
+    #if DEBUG_TELEMETRY
+    uint32_t packets = count[_KIND_TELEMETRY];
+    #else
+    uint32_t packets = 0;
+    #endif
+
+    if (total != 0U || packets != 0U) {
+        char buf[192];
+        size_t n = _format(buf, sizeof(buf), "%s", _prefix(DEBUG_LEVEL_WARNING).text);
+        if (total != 0U) {
+            n += _format(buf + n, sizeof(buf) - n, "%lu lines dropped (", (unsigned long)total);
+            const char* sep = "";
+            for (int i = DEBUG_LEVEL_NONE - 1; i >= 0; i--) {
+                if (count[i] == 0U) continue;
+                n += _format(buf + n, sizeof(buf) - n, "%s%lu %s", sep, (unsigned long)count[i], _level_names[i]);
+                sep = ", ";
+            }
+            n += _format(buf + n, sizeof(buf) - n, (packets != 0U) ? "), " : ")");
+        }
+        if (packets != 0U) {
+            n += _format(buf + n, sizeof(buf) - n, (total != 0U) ? "%lu telemetry packets" : "%lu telemetry packets dropped",
+                         (unsigned long)packets);
+        }
+        n += _format(buf + n, sizeof(buf) - n, "\n");
+
+        #if DEBUG_SINKS
+        if (!_color_enabled) n = _ansiStrip(buf, n);    // formatted for the other sinks
+        #endif
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+        int slot = _txReportSlot();     // the counts, should the report be overwritten
+        int32_t start = (slot >= 0) ? _txReserve(n, room) : -1;
+        uint32_t mark = _TX_MARK_REPORT + (uint32_t)slot;
+        #else
+        int32_t start = _txReserve(n, room);
+        uint32_t mark = _TX_MARK_REPORT;
+        #endif
+        if (start >= 0) {
+            #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+            memcpy(_tx_report_counts[slot], count, sizeof(count));
+            _tx_report_at[slot] = (uint32_t)start;
+            #endif
+            _txCopy((uint32_t)start, buf, n);
+            _txCommit((uint32_t)start, n, mark);
+            for (uint8_t i = 0; i < _KINDS; i++) {
+                _atomicAdd(&_tx_drop_shown[i], count[i]);
+            }
+        } else {
+            _atomicStore(&_tx_drop_new, 1U);    // still no room, try again later
+        }
+    }
+
+    _atomicStore(&_tx_reporting, 0U);
+}
+
+#if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+uint32_t ElegantDebug::_txMarkAt(uint32_t i) {
+    uint32_t pos = i & (DEBUG_TX_RING_LEN - 1U);
+    return (_atomicLoad(&_tx_marks[pos >> 3]) >> ((pos & 7U) * 4U)) & 0xFU;
+}
+
+// Start of the line after the one at `i` (i != end), or `end`
+uint32_t ElegantDebug::_txNextLine(uint32_t i, uint32_t end) {
+    do {
+        i = (i + 1U) & _TX_IDX_MASK;
+    } while (i != end && _txMarkAt(i) == 0U);
+    return i;
+}
+
+// A slot for the counts of a new report: one whose report is no longer
+// queued, or -1 while all of them are
+int ElegantDebug::_txReportSlot() {
+    uint32_t tail = _atomicLoad(&_tx_tail);
+    uint32_t queued = (_atomicLoad(&_tx_head) - tail) & _TX_IDX_MASK;
+    for (uint8_t i = 0; i < _TX_REPORTS; i++) {
+        uint32_t at = _tx_report_at[i];
+        if (((at - tail) & _TX_IDX_MASK) >= queued || _txMarkAt(at) != _TX_MARK_REPORT + i) return i;
+    }
+    return -1;
+}
+
+// Make room for `need` bytes by dropping the oldest whole lines, only while
+// nothing is reading the ring. When the port stopped in the middle of a line
+// the rest of it is moved up to the new read index, so it still goes out
+// whole. One line goes per pass with interrupts off. Dropped lines are
+// counted by the mark they were queued with; a dropped report hands its
+// counts back to the next one. Returns false when the line still does not fit.
+bool ElegantDebug::_txEvict(size_t need) {
+    uint32_t lines[_KINDS] = {};
+    uint32_t bytes[_KINDS] = {};
+    uint32_t back[_KINDS] = {};
+    bool fits = false;
+
+    for (bool more = true; more; ) {
+        more = false;
+        uint32_t key = _lock();
+        #if ((DEBUG_TX_RING_ENABLED && !DEBUG_PLATFORM_TI) || DEBUG_TX_CDC_ENABLED)
+        bool idle = (_tx_inflight == 0U);
+        #elif !DEBUG_TX_RING_ENABLED
+        bool idle = _atomicCas(&_tx_busy, 0U, 1U);
+        #else
+        bool idle = true;       // the TX FIFO holds its own copy
+        #endif
+
+        if (idle) {
+            uint32_t tail = _atomicLoad(&_tx_tail);
+            uint32_t head = _atomicLoad(&_tx_head);
+            uint32_t used = ((_atomicLoad(&_tx_claim) & _TX_IDX_MASK) - tail) & _TX_IDX_MASK;
+            uint32_t room = DEBUG_TX_RING_LEN - used;
+            uint32_t first = (tail == head || _txMarkAt(tail) != 0U) ? tail : _txNextLine(tail, head);
+
+            fits = (room >= need);
+            if (!fits && first != head && room + ((head - first) & _TX_IDX_MASK) >= need) {
+                uint32_t end = _txNextLine(first, head);
+                uint32_t len = (end - first) & _TX_IDX_MASK;
+                uint32_t mark = _txMarkAt(first);
+                if (mark >= _TX_MARK_REPORT) {
+                    for (uint8_t i = 0; i < _KINDS; i++) back[i] += _tx_report_counts[mark - _TX_MARK_REPORT][i];
+                } else if (mark >= _TX_MARK_LINE) {
+                    lines[mark - _TX_MARK_LINE]++;
+                    bytes[mark - _TX_MARK_LINE] += len;
+                }
+
+                // the cut line's rest ends where the kept lines begin
+                uint32_t cut = (first - tail) & _TX_IDX_MASK;
+                for (uint32_t k = cut; k != 0U; k--) {
+                    _tx_ring[(end - cut + k - 1U) & (DEBUG_TX_RING_LEN - 1U)] =
+                        _tx_ring[(tail + k - 1U) & (DEBUG_TX_RING_LEN - 1U)];
+                }
+                _txMark(end - cut, cut, 0U);
+                _atomicStore(&_tx_tail, (end - cut) & _TX_IDX_MASK);
+                fits = (room + len >= need);
+                more = !fits;
+            }
+
+            #if !(DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED)
+            _atomicStore(&_tx_busy, 0U);
+            #endif
+        }
+        _unlock(key);
+    }
+
+    for (uint8_t i = 0; i < _KINDS; i++) {
+        if (lines[i] != 0U) _txDrop(i, lines[i], bytes[i]);
+        if (back[i] != 0U) {
+            _atomicAdd(&_tx_drop_shown[i], (uint32_t)0U - back[i]);
+            _atomicStore(&_tx_drop_new, 1U);
+        }
+    }
+    return fits;
+}
+#endif
+#endif
+
+// "[ts] <prefix>[name] [file:line] [N suppressed] <message>"; name and file
+// may be nullptr
+void ElegantDebug::_vemit(uint8_t level, const char* name, const char* file, uint32_t line,
+                          uint32_t suppressed, const char* format, va_list args) {
+    #if DEBUG_SINKS
+    if (level < _sink_level) return;   // no sink takes it, skip the formatting
+    #endif
+    Line l;
+    _lineBegin(l);
+    const Prefix& prefix = _prefix(level);
+    l.put(prefix.text, prefix.len);
+    if (name != nullptr && name[0] != '\0') {
+        l.put("[", 1);
+        l.str(name);
+        l.put("] ", 2);
+    }
+#if __cplusplus >= 202002L
+    if (file != nullptr && _filename_line_enabled) {
+        l.printf("[%s:%lu] ", file, (unsigned long)line);
+    }
+#else
+    (void)file;
+    (void)line;
+#endif
+    if (suppressed != 0U) {
+        l.printf("[%lu suppressed] ", (unsigned long)suppressed);
+    }
+    l.format(format, args);
+    _lineEnd(l, level);
+}
+
+void ElegantDebug::_emit(uint8_t level, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    _vemit(level, nullptr, nullptr, 0, 0, format, args);
+    va_end(args);
+}
+
+// #if __cplusplus >= 202002L
+// void ElegantDebug::logWithType(const char* type, const char* format, std::source_location loc, ...) {
+//     char msg[DEBUG_BUFFER_LEN];
+//     va_list args;
+//     va_start(args, loc);
+//     vsnprintf(msg, sizeof(msg), format, args);
+//     va_end(args);
+
+//     char combined[DEBUG_BUFFER_LEN + 96];
+//     // if (_filename_line_enabled) {
+//     //     snprintf(combined, sizeof(combined), "\033[1m[%s]\033[0m [%s:%ld] %s", type, loc.file_name(), loc.line(), msg);
+//     // } else {
+//         snprintf(combined, sizeof(combined), "\033[1m[%s]\033[0m %s", type, msg);
+//     // }
+//     _send(combined);
+// }
+// #else
+void ElegantDebug::_emitWithType(const char* type, const char* style, const char* format, ...) {
+    #if DEBUG_SINKS
+    if (DEBUG_LEVEL_LOG < _sink_level) return;   // no sink takes it, skip the formatting
+    #endif
+    Line l;
+    _lineBegin(l);
+    l.str("\033[1m");
+    l.str(style);
+    l.put("[", 1);
+    l.str(type);
+    l.put("]\033[0m ", 6);
+
+    va_list args;
+    va_start(args, format);
+    l.format(format, args);
+    va_end(args);
+    _lineEnd(l, DEBUG_LEVEL_LOG);
+}
+// #endif
+
+#if __cplusplus >= 202002L
+void ElegantDebug::_emitLocation(uint8_t level, const char* file, uint32_t line, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    _vemit(level, nullptr, file, line, 0, format, args);
+    va_end(args);
+}
+#endif
+
+// Module filtering is done by the module*() methods before calling this
+void ElegantDebug::_emitModule(uint8_t module, uint8_t level, const char* file, uint32_t line, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    _vemit(level, moduleName(module), file, line, 0, format, args);
+    va_end(args);
+}
+
+// Rate limiting is done by the dbg_once/everyN/everyMs macros
+void ElegantDebug::_emitLimited(uint8_t level, uint32_t suppressed, const char* file, uint32_t line, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    _vemit(level, nullptr, file, line, suppressed, format, args);
+    va_end(args);
+}
+
+
+// runtime helpers for 24‑bit ANSI colours; return a pointer to a static buffer
+const char* ElegantDebug::customTextColor(uint8_t r, uint8_t g, uint8_t b) {
+    static char ansi[24];
+    _format(ansi, sizeof(ansi), "\033[38;2;%u;%u;%um", (unsigned)r, (unsigned)g, (unsigned)b);
+    return ansi;
+}
+
+const char* ElegantDebug::customBgColor(uint8_t r, uint8_t g, uint8_t b) {
+    static char ansi[24];
+    _format(ansi, sizeof(ansi), "\033[48;2;%u;%u;%um", (unsigned)r, (unsigned)g, (unsigned)b);
+    return ansi;
+}
+
+
+
+#if DEBUG_STATS
+// Goes through the dbg_* macros, so it also works in binary mode
+void ElegantDebug::dumpStats() {
+#if (DEBUG_MIN_LEVEL <= DEBUG_LEVEL_INFO)
+    Stats s = _stats;       // before the dump adds its own lines
+    uint32_t lines = 0, bytes = 0, dropped = 0;
+    for (uint8_t i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        lines += s.lines[i];
+        bytes += s.bytes[i];
+        dropped += s.dropped[i];
+    }
+
+    dbg_info(*this, "Logger stats: %lu lines, %lu bytes, %lu dropped, %lu truncated\n",
+             (unsigned long)lines, (unsigned long)bytes, (unsigned long)dropped, (unsigned long)s.truncated);
+    for (int i = DEBUG_LEVEL_NONE - 1; i >= 0; i--) {
+        if (s.lines[i] == 0U && s.dropped[i] == 0U) continue;
+        dbg_info(*this, "  %-8s%8lu lines %9lu B %6lu dropped\n", _level_names[i],
+                 (unsigned long)s.lines[i], (unsigned long)s.bytes[i], (unsigned long)s.dropped[i]);
+    }
+    #if DEBUG_TELEMETRY
+    dbg_info(*this, "  telemetry%7lu packets %7lu B %6lu dropped\n",
+             (unsigned long)s.tlm_packets, (unsigned long)s.tlm_bytes, (unsigned long)s.tlm_dropped);
+    #endif
+    #if DEBUG_TX_QUEUED
+    dbg_info(*this, "  TX ring high-water %lu / %u B\n", (unsigned long)s.ring_high_water, (unsigned)DEBUG_TX_RING_LEN);
+    #endif
+    #if DEBUG_STATS_CYCLES
+    dbg_info(*this, "  %llu cycles in log calls, %llu of them in transmit, %lu per line\n",
+             (unsigned long long)s.log_cycles, (unsigned long long)s.tx_cycles,
+             (unsigned long)((lines != 0U) ? s.log_cycles / lines : 0U));
+    #endif
+#endif
+}
+#endif
+
+
+
+#if DEBUG_BINARY_MODE
+/*** Binary record builders (see DEBUG_BINARY_MODE in header) ***********/
+
+static constexpr uint8_t BIN_FLAG_TIMESTAMP     = 0x01U;
+static constexpr uint8_t BIN_FLAG_COLOR         = 0x02U;
+static constexpr uint8_t BIN_FLAG_FILENAME_LINE = 0x04U;
+static constexpr uint8_t BIN_FLAG_SUPPRESSED    = 0x08U;
+static constexpr uint8_t BIN_FLAG_TRUNCATED     = 0x80U;
+
+// reserve one byte at the end for the checksum
+bool ElegantDebug::_binRoom(BinRecord& rec, size_t n) {
+    if ((size_t)rec.len + n + 1U > sizeof(rec.buf)) {
+        rec.buf[2] |= BIN_FLAG_TRUNCATED;
+        return false;
+    }
+    return true;
+}
+
+void ElegantDebug::_binPut(BinRecord& rec, uint64_t v, size_t n) {
+    if (!_binRoom(rec, n)) return;
+    for (size_t i = 0; i < n; i++) {
+        rec.buf[rec.len++] = (uint8_t)(v >> (8U * i));
+    }
+}
+
+void ElegantDebug::_binBegin(BinRecord& rec, const char* fmt_id, uint8_t level) {
+    uint32_t id = (uint32_t)(uintptr_t)fmt_id;
+    #if DEBUG_STATS
+    rec.t0 = _cycles();
+    #endif
+    rec.level = level;
+    uint8_t flags = (uint8_t)((_timestamp_enabled ? BIN_FLAG_TIMESTAMP : 0U) |
+                              (_color_enabled ? BIN_FLAG_COLOR : 0U));
+    #if __cplusplus >= 202002L
+    if (_filename_line_enabled) flags |= BIN_FLAG_FILENAME_LINE;
+    #endif
+
+    rec.buf[0] = DEBUG_BIN_SYNC;
+    rec.buf[1] = 0;     // length, filled in by _binEnd()
+    rec.buf[2] = flags;
+    rec.len = 3;
+
+    // format address as LEB128 varint: 2~3 bytes when the section is linked at 0
+    do {
+        uint8_t b = (uint8_t)(id & 0x7FU);
+        id >>= 7;
+        rec.buf[rec.len++] = (id != 0U) ? (uint8_t)(b | 0x80U) : b;
+    } while (id != 0U);
+
+    if (_timestamp_enabled) {
+        _binPut(rec, _getTick(), 4);
+    }
+}
+
+// right after _binBegin(), before the arguments
+void ElegantDebug::_binSuppressed(BinRecord& rec, uint32_t n) {
+    rec.buf[2] |= BIN_FLAG_SUPPRESSED;
+    _binPut(rec, n, 4);
+}
+
+void ElegantDebug::_binArg(BinRecord& rec, const char* s) {
+    if (s == nullptr) s = "(null)";
+    if (!_binRoom(rec, 1)) return;
+
+    // copy as much as fits, always NUL-terminated
+    size_t room = sizeof(rec.buf) - 1U - rec.len - 1U;
+    size_t n = strlen(s);
+    if (n > room) {
+        n = room;
+        rec.buf[2] |= BIN_FLAG_TRUNCATED;
+    }
+    memcpy(&rec.buf[rec.len], s, n);
+    rec.len = (uint8_t)(rec.len + n);
+    rec.buf[rec.len++] = 0;
+}
+
+void ElegantDebug::_binArg(BinRecord& rec, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    _binPut(rec, bits, 8);
 }
 
-// #if __cplusplus >= 202002L
-// void ElegantDebug::logWithType(const char* type, const char* format, std::source_location loc, ...) {
-//     char msg[DEBUG_BUFFER_LEN];
-//     va_list args;
-//     va_start(args, loc);
-//     vsnprintf(msg, sizeof(msg), format, args);
-//     va_end(args);
+void ElegantDebug::_binEnd(BinRecord& rec) {
+    uint8_t sum = 0;
 
-//     char combined[DEBUG_BUFFER_LEN + 96];
-//     // if (_filename_line_enabled) {
-//     //     snprintf(combined, sizeof(combined), "\033[1m[%s]\033[0m [%s:%ld] %s", type, loc.file_name(), loc.line(), msg);
-//     // } else {
-//         snprintf(combined, sizeof(combined), "\033[1m[%s]\033[0m %s", type, msg);
-//     // }
-//     _send(combined);
-// }
-// #else
-void ElegantDebug::logWithType(const char* type, const char* style, const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
+    rec.buf[1] = (uint8_t)(rec.len - 2U);
+    for (size_t i = 2; i < rec.len; i++) {
+        sum = (uint8_t)(sum + rec.buf[i]);
+    }
+    rec.buf[rec.len++] = (uint8_t)~sum;
 
-    char combined[DEBUG_BUFFER_LEN + 32];
-    snprintf(combined, sizeof(combined), "\033[1m%s[%s]\033[0m %s", style, type, msg);
-    _send(combined);
+    #if DEBUG_CRASHLOG
+    _crashWrite((const char*)rec.buf, rec.len);
+    #endif
+    _writeRaw(rec.level, (const char*)rec.buf, rec.len);
+    #if DEBUG_STATS
+    if (rec.buf[2] & BIN_FLAG_TRUNCATED) {
+        _statsCount(_stats.truncated);
+    }
+    _statsCycles(_stats.log_cycles, rec.t0);
+    #endif
 }
-// #endif
+#endif
 
-#if __cplusplus >= 202002L
-void ElegantDebug::error(const char* format, std::source_location loc, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, loc);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
 
-    const char* prefix = _color_enabled ? ERROR_TYPE : ERROR_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 96];
+/*** Hexdump ************************************************************/
 
-    if (_filename_line_enabled) {
-        snprintf(combined, sizeof(combined), "%s[%s:%ld] %s", prefix, loc.file_name(), loc.line(), msg);
-    } else {
-        snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
+static constexpr size_t HEX_ROW = 16U;
+
+#if DEBUG_BINARY_MODE
+// Library-owned format entry: the decoder renders "H" records itself
+static const char _hexdump_fmt[] DEBUG_BIN_SECTION = "H\x1F\x1F" "0\x1F";
+
+// u32 offset | u8 count (bit7: 8-digit offset) | u16 changed mask | bytes
+void ElegantDebug::_hexRow(const uint8_t* p, size_t off, size_t n, uint32_t changed, bool wide) {
+    BinRecord rec;
+    _binBegin(rec, _hexdump_fmt, DEBUG_LEVEL_LOG);
+    _binPut(rec, off, 4);
+    _binPut(rec, n | (wide ? 0x80U : 0U), 1);
+    _binPut(rec, changed, 2);
+    if (_binRoom(rec, n)) {
+        memcpy(&rec.buf[rec.len], p, n);
+        rec.len = (uint8_t)(rec.len + n);
     }
-    _send(combined);
+    _binEnd(rec);
 }
 #else
-void ElegantDebug::error(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
-
-    const char* prefix = _color_enabled ? ERROR_TYPE : ERROR_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 32];
+static char* _hexByte(char* o, uint8_t b) {
+    memcpy(o, &_hex_lut[2U * b], 2);
+    return o + 2;
+}
 
-    snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
-    _send(combined);
+// Printable ASCII (0x20 ~ 0x7E) of 4 bytes at once, the others become '.'.
+// Each byte is compared with its high bit forced on, so no borrow crosses
+// into the next byte.
+static uint32_t _hexAscii4(uint32_t w) {
+    uint32_t lo = (w & 0x7F7F7F7FU) | 0x80808080U;
+    uint32_t ok = (lo - 0x20202020U) & ~(lo - 0x7F7F7F7FU) & ~w & 0x80808080U;
+    uint32_t keep = (ok >> 7) * 0xFFU;
+    return (w & keep) | (0x2E2E2E2EU & ~keep);
 }
-#endif
 
-#if __cplusplus >= 202002L
-void ElegantDebug::warning(const char* format, std::source_location loc, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, loc);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
+// "[ts] 0010  48 65 6C 6C 6F 20 57 6F  72 6C 64 0A 00 00 00 00  |Hello World.....|"
+// Changed bytes are wrapped in COLOR_RED ... CLR, one pair per run
+void ElegantDebug::_hexRow(const uint8_t* p, size_t off, size_t n, uint32_t changed, bool wide) {
+    Line l;
+    _lineBegin(l);
+    char* o = l.buf + l.len;
 
-    const char* prefix = _color_enabled ? WARNING_TYPE : WARNING_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 96];
+    if (wide) {
+        o = _hexByte(o, (uint8_t)(off >> 24));
+        o = _hexByte(o, (uint8_t)(off >> 16));
+    }
+    o = _hexByte(o, (uint8_t)(off >> 8));
+    o = _hexByte(o, (uint8_t)off);
+    *o++ = ' ';
 
-    if (_filename_line_enabled) {
-        snprintf(combined, sizeof(combined), "%s[%s:%ld] %s", prefix, loc.file_name(), loc.line(), msg);
-    } else {
-        snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
+    for (size_t i = 0; i < HEX_ROW; i++) {
+        if (i % 8U == 0U) *o++ = ' ';
+        if (i >= n) {
+            memcpy(o, "   ", 3);
+            o += 3;
+            continue;
+        }
+        uint32_t bit = 1UL << i;
+        if ((changed & bit) && !(changed & (bit >> 1))) {
+            memcpy(o, COLOR_RED, sizeof(COLOR_RED) - 1U);
+            o += sizeof(COLOR_RED) - 1U;
+        }
+        o = _hexByte(o, p[i]);
+        if ((changed & bit) && !(changed & (bit << 1))) {
+            memcpy(o, CLR, sizeof(CLR) - 1U);
+            o += sizeof(CLR) - 1U;
+        }
+        *o++ = ' ';
     }
 
-    _send(combined);
+    *o++ = ' ';
+    *o++ = '|';
+    size_t i = 0;
+    for (; i + 4U <= n; i += 4U) {
+        uint32_t w;
+        memcpy(&w, p + i, 4);
+        w = _hexAscii4(w);
+        memcpy(o, &w, 4);
+        o += 4;
+    }
+    for (; i < n; i++) {
+        *o++ = (p[i] >= 0x20U && p[i] < 0x7FU) ? (char)p[i] : '.';
+    }
+    *o++ = '|';
+    *o++ = '\n';
+
+    l.len = (size_t)(o - l.buf);
+    _lineEnd(l, DEBUG_LEVEL_LOG);
 }
-#else
-void ElegantDebug::warning(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
+#endif
 
-    const char* prefix = _color_enabled ? WARNING_TYPE : WARNING_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 32];
+void ElegantDebug::_hexdump(const void* data, size_t len, const void* prev) {
+    const uint8_t* p = (const uint8_t*)data;
+    const uint8_t* q = (const uint8_t*)prev;
+    bool wide = len > 0x10000U;     // 8-digit offsets
+    if (p == nullptr) return;
+    #if DEBUG_SINKS
+    if (DEBUG_LEVEL_LOG < _sink_level) return;   // no sink takes it, skip the formatting
+    #endif
 
-    snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
-    _send(combined);
+    for (size_t off = 0; off < len; off += HEX_ROW) {
+        size_t n = (len - off < HEX_ROW) ? len - off : HEX_ROW;
+        uint32_t changed = 0;
+        if (q != nullptr && _colorOn()) {
+            for (size_t i = 0; i < n; i++) {
+                if (p[off + i] != q[off + i]) changed |= 1UL << i;
+            }
+        }
+        _hexRow(p + off, off, n, changed, wide);
+    }
 }
-#endif
 
-void ElegantDebug::ok(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
 
-    const char* prefix = _color_enabled ? OK_TYPE : OK_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 32];
-    snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
-    _send(combined);
+
+#if DEBUG_TELEMETRY
+/*** Telemetry (see DEBUG_TELEMETRY in header) **************************/
+
+static constexpr uint8_t TLM_INT16 = 1U;
+static constexpr uint8_t TLM_INT32 = 2U;
+static constexpr uint8_t TLM_FLOAT = 3U;
+
+static size_t _tlmVarint(uint8_t* p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80U) {
+        p[n++] = (uint8_t)(v | 0x80U);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
 }
 
-void ElegantDebug::success(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
+struct ElegantDebug::TlmPacket {
+    uint8_t buf[DEBUG_TELEMETRY_LEN];
+    size_t len;
+    size_t count_at;    // index of the sample count
+    uint8_t count;
 
-    const char* prefix = _color_enabled ? SUCCESS_TYPE : SUCCESS_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 32];
-    snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
-    _send(combined);
+    void begin(uint8_t channel, uint8_t kind, uint32_t tick) {
+        buf[0] = channel;
+        buf[1] = kind;
+        len = 2U + _tlmVarint(&buf[2], tick);
+        count_at = len++;
+        count = 0;
+    }
+};
+
+// Checksum, COBS and the delimiters, then out in one _writeRaw(). Packets are
+// at most 254 bytes with the checksum, so COBS adds exactly one byte.
+void ElegantDebug::_tlmSend(TlmPacket& f) {
+    uint8_t out[DEBUG_TELEMETRY_LEN + 4];
+    uint8_t sum = 0;
+
+    f.buf[f.count_at] = f.count;
+    for (size_t i = 0; i < f.len; i++) {
+        sum = (uint8_t)(sum + f.buf[i]);
+    }
+    f.buf[f.len++] = (uint8_t)~sum;
+
+    size_t code_at = 1, o = 2;
+    uint8_t code = 1;
+    out[0] = 0;
+    for (size_t i = 0; i < f.len; i++) {
+        if (f.buf[i] == 0U) {
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        } else {
+            out[o++] = f.buf[i];
+            code++;
+        }
+    }
+    out[code_at] = code;
+    out[o++] = 0;
+
+    _writeRaw(_KIND_TELEMETRY, (const char*)out, o);
 }
 
-void ElegantDebug::info(const char* format, ...) {
-    char msg[DEBUG_BUFFER_LEN];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
+// Room for one more sample of `size` bytes at most, else send and start over
+void ElegantDebug::_tlmRoom(TlmPacket& f, size_t size) {
+    if (f.len + size + 1U > sizeof(f.buf) || f.count == 0xFFU) {
+        _tlmSend(f);
+        f.begin(f.buf[0], f.buf[1], _getTick());
+    }
+}
 
-    const char* prefix = _color_enabled ? INFO_TYPE : INFO_TYPE_PLAIN;
-    char combined[DEBUG_BUFFER_LEN + 32];
-    snprintf(combined, sizeof(combined), "%s%s", prefix, msg);
-    _send(combined);
+void ElegantDebug::_tlmInt(TlmPacket& f, int32_t v, uint32_t& last, size_t size) {
+    _tlmRoom(f, size);
+    uint32_t d = (f.count == 0U) ? (uint32_t)v : (uint32_t)v - last;
+    last = (uint32_t)v;
+    f.len += _tlmVarint(&f.buf[f.len], (d << 1) ^ (0U - (d >> 31)));    // zigzag
+    f.count++;
 }
 
+void ElegantDebug::streamSamples(uint8_t channel, const int16_t* samples, size_t n) {
+    if (samples == nullptr || n == 0U) return;
+    TlmPacket f;
+    uint32_t last = 0;
+    f.begin(channel, TLM_INT16, _getTick());
+    for (size_t i = 0; i < n; i++) {
+        _tlmInt(f, samples[i], last, 3);    // 17-bit deltas
+    }
+    _tlmSend(f);
+}
 
-// runtime helpers for 24‑bit ANSI colours; return a pointer to a static buffer
-const char* ElegantDebug::customTextColor(uint8_t r, uint8_t g, uint8_t b) {
-    static char ansi[24];
-    snprintf(ansi, sizeof(ansi), "\033[38;2;%u;%u;%um", (unsigned)r, (unsigned)g, (unsigned)b);
-    return ansi;
+void ElegantDebug::streamSamples(uint8_t channel, const int32_t* samples, size_t n) {
+    if (samples == nullptr || n == 0U) return;
+    TlmPacket f;
+    uint32_t last = 0;
+    f.begin(channel, TLM_INT32, _getTick());
+    for (size_t i = 0; i < n; i++) {
+        _tlmInt(f, samples[i], last, 5);
+    }
+    _tlmSend(f);
 }
 
-const char* ElegantDebug::customBgColor(uint8_t r, uint8_t g, uint8_t b) {
-    static char ansi[24];
-    snprintf(ansi, sizeof(ansi), "\033[48;2;%u;%u;%um", (unsigned)r, (unsigned)g, (unsigned)b);
-    return ansi;
+void ElegantDebug::streamSamples(uint8_t channel, const float* samples, size_t n) {
+    if (samples == nullptr || n == 0U) return;
+    TlmPacket f;
+    f.begin(channel, TLM_FLOAT, _getTick());
+    for (size_t i = 0; i < n; i++) {
+        uint32_t bits;
+        memcpy(&bits, &samples[i], 4);
+        _tlmRoom(f, 4);
+        for (size_t k = 0; k < 4U; k++) {
+            f.buf[f.len++] = (uint8_t)(bits >> (8U * k));
+        }
+        f.count++;
+    }
+    _tlmSend(f);
 }
+#endif
 
 
 
@@ -423,4 +2511,516 @@ void ElegantDebug::_info(const char* file, int line, const char* format, ...) {
     }
     _send(combined);
 }
-*********************************************************************************************/
\ No newline at end of file
+*********************************************************************************************/
+
+
+
+#if DEBUG_CRASHLOG
+/*** Crash log replay ***************************************************/
+
+size_t ElegantDebug::crashlogReplay() {
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    if (!_crash_started) _crashStart();
+    uint32_t end = _crash_prev;
+    uint32_t head = _crashlog.head;
+    _crash_prev = 0;                    // once
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+
+    // what this session's lines have left of the previous one's
+    uint32_t behind = head - end;
+    if (end == 0U || behind >= DEBUG_CRASHLOG_LEN) return 0;
+    uint32_t avail = DEBUG_CRASHLOG_LEN - behind;
+    if (avail > end) avail = end;
+    uint32_t start = end - avail;
+
+#if !DEBUG_BINARY_MODE
+    if (start != 0U) {                  // the oldest line may be cut
+        while (start != end && _crashlog.data[start++ & (DEBUG_CRASHLOG_LEN - 1U)] != '\n') {}
+    }
+    if (start == end) return 0;
+
+    _crash_replaying = true;
+    size_t sent = end - start;
+    char line[DEBUG_BUFFER_LEN + 128];
+    size_t n = _format(line, sizeof(line), "%s--- log before reset (%lu bytes) ---\n",
+                       _prefix(DEBUG_LEVEL_WARNING).text, (unsigned long)sent);
+    _write(DEBUG_LEVEL_WARNING, line, n);
+    n = 0;
+    for (uint32_t i = start; i != end; i++) {
+        char c = _crashlog.data[i & (DEBUG_CRASHLOG_LEN - 1U)];
+        line[n++] = c;
+        if (c == '\n' || n == sizeof(line) - 1U || i + 1U == end) {
+            if (c != '\n' && i + 1U == end) line[n++] = '\n';  // cut short by the reset
+            #if !DEBUG_SINKS
+            if (!_color_enabled) n = _ansiStrip(line, n);   // logged with colors on
+            #endif
+            _write(DEBUG_LEVEL_LOG, line, n);
+            n = 0;
+        }
+    }
+    n = _format(line, sizeof(line), "%s--- end of log before reset ---\n", _prefix(DEBUG_LEVEL_WARNING).text);
+    _write(DEBUG_LEVEL_WARNING, line, n);
+#else
+    _crash_replaying = true;
+    size_t sent = end - start;
+    // raw records, the decoder resyncs on the first whole one
+    for (uint32_t i = start; i != end; ) {
+        uint32_t pos = i & (DEBUG_CRASHLOG_LEN - 1U);
+        uint32_t n = DEBUG_CRASHLOG_LEN - pos;
+        if (n > end - i) n = end - i;
+        _writeRaw(DEBUG_LEVEL_LOG, &_crashlog.data[pos], n);
+        i += n;
+    }
+#endif
+    _crash_replaying = false;
+    return sent;
+}
+
+void ElegantDebug::crashlogClear() {
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    if (!_crash_started) _crashStart();
+    _crashCommit(0);
+    _crash_prev = 0;
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+}
+#endif
+
+
+
+#if DEBUG_FLASHLOG
+/*** Flash log (see DEBUG_FLASHLOG in header) ***************************/
+
+// Each sector starts with a header (magic, sequence number), followed by
+// records padded to whole program units:
+//   len (16-bit LE) | inverted 8-bit sum of data | _FL_TAG | data
+// Erased flash ends the records. A record cut by a power loss fails its
+// sum and is skipped; an empty record marks a flashlogInit().
+#define _FL_MAGIC   0x4C464445U                 // "EDFL"
+#define _FL_TAG     0x4CU
+#define _FL_STAGE   32U                         // the largest program unit
+#define _FL_REC_MAX (DEBUG_BUFFER_LEN + 128)    // a whole line
+
+bool ElegantDebug::_flTake() {
+    #if DEBUG_THREAD_SAFE
+    uint32_t key = _lock();
+    #endif
+    bool idle = !_fl_busy;
+    _fl_busy = true;
+    #if DEBUG_THREAD_SAFE
+    _unlock(key);
+    #endif
+    return idle;
+}
+
+// Program `a`, then `b`, from `addr` on, through a staging buffer so that
+// the driver only gets whole units; the last one is padded with 0xFF
+bool ElegantDebug::_flProgram(uint32_t addr, const uint8_t* a, size_t alen, const uint8_t* b, size_t blen) {
+    uint8_t st[_FL_STAGE];
+    size_t fill = 0;
+    for (int k = 0; k < 2; k++) {
+        const uint8_t* p = (k == 0) ? a : b;
+        size_t len = (k == 0) ? alen : blen;
+        while (len != 0U) {
+            size_t n = _FL_STAGE - fill;
+            if (n > len) n = len;
+            memcpy(&st[fill], p, n);
+            p += n;
+            len -= n;
+            fill += n;
+            if (fill == _FL_STAGE) {
+                if (!_fl->program(_fl->ctx, addr, st, fill)) return false;
+                addr += fill;
+                fill = 0;
+            }
+        }
+    }
+    if (fill == 0U) return true;
+    size_t end = _flRound((uint32_t)fill);
+    memset(&st[fill], 0xFF, end - fill);
+    return _fl->program(_fl->ctx, addr, st, end);
+}
+
+bool ElegantDebug::_flSectorValid(uint16_t sector, uint32_t& seq) {
+    uint32_t hdr[2];
+    if (!_fl->read(_fl->ctx, _flAddr(sector, 0), hdr, sizeof(hdr))) return false;
+    seq = hdr[1];
+    return hdr[0] == _FL_MAGIC;
+}
+
+// Header of the record at `off`: its data length, or -1 at the end of the
+// sector's records (erased flash, damage, or no room left)
+int32_t ElegantDebug::_flRecord(uint16_t sector, uint32_t off, uint8_t& sum) {
+    uint8_t h[4];
+    if (off + 4U > _fl->sector_size || !_fl->read(_fl->ctx, _flAddr(sector, off), h, 4)) return -1;
+    uint32_t len = h[0] | ((uint32_t)h[1] << 8);
+    if (h[3] != _FL_TAG || len > _FL_REC_MAX || off + _flRound(4U + len) > _fl->sector_size) return -1;
+    sum = h[2];
+    return (int32_t)len;
+}
+
+// Erase the sector after the active one and make it the active one. The
+// oldest records go with it.
+bool ElegantDebug::_flOpen() {
+    uint16_t s = (uint16_t)((_fl_sector + 1U) % _fl->sectors);
+    uint32_t hdr[2] = { _FL_MAGIC, _fl_seq + 1U };
+    _fl_sector = s;
+    _fl_off = _fl->sector_size;     // full until its header is in
+    if (!_fl->erase(_fl->ctx, s) || !_flProgram(_flAddr(s, 0), (const uint8_t*)hdr, sizeof(hdr), nullptr, 0)) {
+        return false;
+    }
+    _fl_seq++;
+    _fl_off = _flRound(sizeof(hdr));
+    return true;
+}
+
+void ElegantDebug::_flAppend(const uint8_t* data, size_t len) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < len; i++) {
+        sum = (uint8_t)(sum + data[i]);
+    }
+    uint8_t h[4] = { (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)~sum, _FL_TAG };
+    uint32_t size = _flRound(4U + (uint32_t)len);
+    if (_fl_off + size > _fl->sector_size && !_flOpen()) return;
+    if (!_flProgram(_flAddr(_fl_sector, _fl_off), h, 4, data, len)) {
+        _fl_off = _fl->sector_size;     // left half-written: go on in the next sector
+        return;
+    }
+    _fl_off += size;
+}
+
+// The newest sector and the end of its records. Anything but erased flash
+// after them (a record header cut by a power loss) closes the sector.
+void ElegantDebug::_flMount() {
+    bool found = false;
+    for (uint16_t s = 0; s < _fl->sectors; s++) {
+        uint32_t seq;
+        if (!_flSectorValid(s, seq)) continue;
+        if (!found || (int32_t)(seq - _fl_seq) > 0) {
+            _fl_seq = seq;
+            _fl_sector = s;
+            found = true;
+        }
+    }
+    _fl_off = _fl->sector_size;
+    if (!found) {                   // blank region: the first record opens sector 0
+        _fl_seq = 0;
+        _fl_sector = (uint16_t)(_fl->sectors - 1U);
+        return;
+    }
+
+    uint32_t off = _flRound(8);
+    uint8_t sum;
+    int32_t len;
+    while ((len = _flRecord(_fl_sector, off, sum)) >= 0) {
+        off += _flRound(4U + (uint32_t)len);
+    }
+    uint8_t h[4];
+    if (off + 4U <= _fl->sector_size && _fl->read(_fl->ctx, _flAddr(_fl_sector, off), h, 4) &&
+        (h[0] & h[1] & h[2] & h[3]) == 0xFFU) {
+        _fl_off = off;
+    }
+}
+
+void ElegantDebug::_flSink(void* ctx, const char* data, size_t len) {
+    ElegantDebug* self = (ElegantDebug*)ctx;
+    if (len > _FL_REC_MAX) len = _FL_REC_MAX;
+    if (!self->_flTake()) return;
+    self->_flAppend((const uint8_t*)data, len);
+    self->_fl_busy = false;
+}
+
+int ElegantDebug::flashlogInit(const Flash& flash, uint8_t level) {
+    if (_fl != nullptr || flash.sectors < 2U ||
+        flash.prog_size == 0U || flash.prog_size > _FL_STAGE ||
+        (flash.prog_size & (flash.prog_size - 1U)) != 0U ||
+        (flash.sector_size & (flash.prog_size - 1U)) != 0U ||
+        flash.sector_size < DEBUG_BUFFER_LEN + 256U) {
+        return -1;
+    }
+    _fl = &flash;
+    _flMount();
+    _flAppend(nullptr, 0);          // boot mark
+    int id = sinkAdd(_flSink, this, level, false);
+    if (id < 0) _fl = nullptr;
+    return id;
+}
+
+#if !DEBUG_BINARY_MODE
+// Export banner, for the port's color setting
+void ElegantDebug::_flNote(char* buf, const char* text, size_t records) {
+    size_t n = _format(buf, _FL_REC_MAX, text, _prefix(DEBUG_LEVEL_WARNING).text, (unsigned long)records);
+    if (!_color_enabled) n = _ansiStrip(buf, n);
+    _portSend(DEBUG_LEVEL_WARNING, buf, n);
+}
+#endif
+
+size_t ElegantDebug::flashlogExport() {
+    if (_fl == nullptr || !_flTake()) return 0;
+    char buf[_FL_REC_MAX];
+    size_t records = 0;
+
+    #if !DEBUG_BINARY_MODE
+    _flNote(buf, "%s--- flash log ---\n", 0);
+    #endif
+    // oldest sector first: the ring goes on after the active one
+    for (uint16_t k = 1; k <= _fl->sectors; k++) {
+        uint16_t s = (uint16_t)((_fl_sector + k) % _fl->sectors);
+        uint32_t seq;
+        if (!_flSectorValid(s, seq)) continue;
+        uint8_t sum;
+        int32_t len;
+        for (uint32_t off = _flRound(8); (len = _flRecord(s, off, sum)) >= 0; off += _flRound(4U + (uint32_t)len)) {
+            if (!_fl->read(_fl->ctx, _flAddr(s, off + 4U), buf, (size_t)len)) break;
+            for (int32_t i = 0; i < len; i++) {
+                sum = (uint8_t)(sum + (uint8_t)buf[i]);
+            }
+            if (sum != 0xFFU) continue;     // cut by a power loss
+            if (len == 0) {
+                #if !DEBUG_BINARY_MODE
+                _portSend(DEBUG_LEVEL_LOG, "--- boot ---\n", 13);
+                #endif
+                continue;
+            }
+            _portSend(DEBUG_LEVEL_LOG, buf, (size_t)len);
+            records++;
+        }
+    }
+    #if !DEBUG_BINARY_MODE
+    _flNote(buf, "%s--- end of flash log (%lu records) ---\n", records);
+    #endif
+
+    _fl_busy = false;
+    return records;
+}
+
+bool ElegantDebug::flashlogErase() {
+    if (_fl == nullptr || !_flTake()) return false;
+    bool ok = true;
+    for (uint16_t s = 0; s < _fl->sectors; s++) {
+        if (!_fl->erase(_fl->ctx, s)) ok = false;
+    }
+    // the next record opens sector 0; the sequence goes on
+    _fl_sector = (uint16_t)(_fl->sectors - 1U);
+    _fl_off = _fl->sector_size;
+    _fl_busy = false;
+    return ok;
+}
+#endif
+
+
+
+#if DEBUG_PANIC
+/*** Panic (see DEBUG_PANIC in header) **********************************/
+
+// Straight to the UART registers: ready for a byte, write it, all sent,
+// and stop the DMA/DTC from feeding it the ring behind our back
+#if (DEBUG_PLATFORM_STM32 && (USB_AS_DEBUG_PORT != 1))
+    #define _PANIC_PORT         (_huart != nullptr)
+    #if defined(USART_ISR_TXE_TXFNF)                    // G0, G4, H7, L5, U5...: TX FIFO
+        #define _PANIC_READY()  (_huart->Instance->ISR & USART_ISR_TXE_TXFNF)
+        #define _PANIC_PUT(c)   (_huart->Instance->TDR = (uint8_t)(c))
+        #define _PANIC_DONE()   (_huart->Instance->ISR & USART_ISR_TC)
+    #elif defined(USART_ISR_TXE)                        // F0, F3, F7, L0, L4...
+        #define _PANIC_READY()  (_huart->Instance->ISR & USART_ISR_TXE)
+        #define _PANIC_PUT(c)   (_huart->Instance->TDR = (uint8_t)(c))
+        #define _PANIC_DONE()   (_huart->Instance->ISR & USART_ISR_TC)
+    #else                                               // F1, F2, F4, L1
+        #define _PANIC_READY()  (_huart->Instance->SR & USART_SR_TXE)
+        #define _PANIC_PUT(c)   (_huart->Instance->DR = (uint8_t)(c))
+        #define _PANIC_DONE()   (_huart->Instance->SR & USART_SR_TC)
+    #endif
+    #define _PANIC_QUIET()      (_huart->Instance->CR3 = _huart->Instance->CR3 & ~USART_CR3_DMAT)
+#elif DEBUG_PLATFORM_RA
+    #define _PANIC_PORT         (_uart != nullptr)
+    #ifdef R_SCI_UART_H
+        #define _PANIC_SCI      (((sci_uart_instance_ctrl_t*)_uart->p_ctrl)->p_reg)
+        #define _PANIC_READY()  (_PANIC_SCI->SSR_b.TDRE)
+        #define _PANIC_PUT(c)   (_PANIC_SCI->TDR = (uint8_t)(c))
+        #define _PANIC_DONE()   (_PANIC_SCI->SSR_b.TEND)
+        #define _PANIC_QUIET()  (_PANIC_SCI->SCR_b.TIE = 0U)
+    #else
+        #define _PANIC_SCI      (((sci_b_uart_instance_ctrl_t*)_uart->p_ctrl)->p_reg)
+        #define _PANIC_READY()  (_PANIC_SCI->CSR_b.TDRE)
+        #define _PANIC_PUT(c)   (_PANIC_SCI->TDR_BY = (uint8_t)(c))
+        #define _PANIC_DONE()   (_PANIC_SCI->CSR_b.TEND)
+        #define _PANIC_QUIET()  (_PANIC_SCI->CCR0_b.TIE = 0U)
+    #endif
+#elif DEBUG_PLATFORM_TI
+    #define _PANIC_PORT         (_uart_inst != nullptr)
+    #define _PANIC_READY()      (!DL_UART_isTXFIFOFull(_uart_inst))
+    #define _PANIC_PUT(c)       DL_UART_transmitData(_uart_inst, (uint8_t)(c))
+    #define _PANIC_DONE()       (!DL_UART_isBusy(_uart_inst))
+    #define _PANIC_QUIET()      ((void)0)
+#else
+    #define _PANIC_PORT         false
+#endif
+
+// Polls of a TX register that stays full before the port is given up for
+// good, as one without its clock never empties
+#define _PANIC_SPIN     100000U
+
+void ElegantDebug::_panicPort(const char* s, size_t len) {
+#ifdef _PANIC_PUT
+    for (size_t i = 0; i < len && _panic_port; i++) {
+        uint32_t spin = _PANIC_SPIN;
+        while (!_PANIC_READY()) {
+            if (--spin == 0U) {
+                _panic_port = false;
+                return;
+            }
+        }
+        _PANIC_PUT(s[i]);
+    }
+#else
+    (void)s;
+    (void)len;
+#endif
+}
+
+void ElegantDebug::_panicWrite(const char* s, size_t len) {
+    #if DEBUG_CRASHLOG
+    _crashWrite(s, len);
+    #endif
+    _panicPort(s, len);
+}
+
+// Interrupts off, the port to ourselves, and out with what the ring still
+// holds. The chunk DMA was sending may show up twice.
+void ElegantDebug::_panicBegin() {
+    __disable_irq();
+    _panic_port = _PANIC_PORT;
+    if (!_panic_port) return;
+#ifdef _PANIC_PUT
+    _PANIC_QUIET();
+#endif
+#if DEBUG_TX_QUEUED
+    uint32_t head = _tx_head;       // writers still copying are cut off
+    uint32_t tail = _tx_tail;
+    while (tail != head) {
+        uint32_t start = tail & (DEBUG_TX_RING_LEN - 1U);
+        uint32_t len = (head - tail) & _TX_IDX_MASK;
+        if (len > DEBUG_TX_RING_LEN - start) len = DEBUG_TX_RING_LEN - start;
+        _panicPort((const char*)&_tx_ring[start], len);
+        tail = (tail + len) & _TX_IDX_MASK;
+    }
+    _tx_tail = tail;
+#endif
+}
+
+void ElegantDebug::_panicEnd() {
+#ifdef _PANIC_PUT
+    uint32_t spin = _PANIC_SPIN;
+    while (_panic_port && !_PANIC_DONE() && --spin != 0U) {}   // last byte out
+#endif
+#if DEBUG_PANIC_RESET
+    NVIC_SystemReset();
+#endif
+    for (;;) {}
+}
+
+// Lines are put together by hand: no vsnprintf() in fault context
+static size_t _panicAdd(char* line, size_t n, const char* s) {
+    while (*s != '\0' && n < 95U) line[n++] = *s++;
+    return n;
+}
+
+static size_t _panicHex(char* line, size_t n, const char* name, uint32_t v) {
+    n = _panicAdd(line, n, name);
+    n = _panicAdd(line, n, " 0x");
+    for (int shift = 28; shift >= 0 && n < 95U; shift -= 4) {
+        line[n++] = "0123456789ABCDEF"[(v >> shift) & 15U];
+    }
+    return _panicAdd(line, n, "  ");
+}
+
+void ElegantDebug::_panicLine(char* line, size_t n) {
+    while (n > 0U && line[n - 1] == ' ') n--;
+    line[n++] = '\n';
+    _panicWrite(line, n);
+}
+
+void ElegantDebug::_panicTitle(const char* title, const char* reason) {
+    char line[96];
+    size_t n = _panicAdd(line, 0, _prefixes[_color_enabled ? 1 : 0][DEBUG_LEVEL_ERROR].text);
+    n = _panicAdd(line, n, title);
+    if (reason != nullptr) n = _panicAdd(line, n, reason);
+    _panicLine(line, n);
+}
+
+void ElegantDebug::panic(const char* reason) {
+    _panicBegin();
+    _panicTitle("PANIC: ", reason);
+    char line[96];
+    line[0] = line[1] = ' ';
+    size_t n = _panicHex(line, 2, "caller", (uint32_t)(uintptr_t)__builtin_return_address(0));
+    _panicLine(line, n);
+    _panicEnd();
+}
+
+#if defined(SCB_CFSR_USGFAULTSR_Pos)
+// Fault status bits worth a name: CFSR bit, or 32 + HFSR bit
+static const struct {
+    uint8_t bit;
+    char name[12];
+} _panic_bits[] = {
+    {  0, "IACCVIOL" },   {  1, "DACCVIOL" },   {  3, "MUNSTKERR" },  {  4, "MSTKERR" },
+    {  5, "MLSPERR" },    {  8, "IBUSERR" },    {  9, "PRECISERR" },  { 10, "IMPRECISERR" },
+    { 11, "UNSTKERR" },   { 12, "STKERR" },     { 13, "LSPERR" },     { 16, "UNDEFINSTR" },
+    { 17, "INVSTATE" },   { 18, "INVPC" },      { 19, "NOCP" },       { 20, "STKOF" },
+    { 24, "UNALIGNED" },  { 25, "DIVBYZERO" },  { 33, "VECTTBL" },    { 62, "FORCED" },
+};
+#endif
+
+void ElegantDebug::fault(const FaultFrame* frame, uint32_t exc_return) {
+    _panicBegin();
+    _panicTitle("FAULT", nullptr);
+
+    char line[96];
+    line[0] = line[1] = ' ';     // indent, kept for every line below
+    size_t n = _panicHex(line, 2, "PC  ", frame->pc);
+    n = _panicHex(line, n, "LR  ", frame->lr);
+    n = _panicHex(line, n, "xPSR", frame->xpsr);
+    _panicLine(line, n);
+    n = _panicHex(line, 2, "R0  ", frame->r0);
+    n = _panicHex(line, n, "R1  ", frame->r1);
+    n = _panicHex(line, n, "R2  ", frame->r2);
+    _panicLine(line, n);
+    n = _panicHex(line, 2, "R3  ", frame->r3);
+    n = _panicHex(line, n, "R12 ", frame->r12);
+    n = _panicHex(line, n, "SP  ", (uint32_t)(uintptr_t)frame);
+    _panicLine(line, n);
+    n = _panicHex(line, 2, "EXC_RETURN", exc_return);
+    _panicLine(line, n);
+
+#if defined(SCB_CFSR_USGFAULTSR_Pos)
+    uint32_t cfsr = SCB->CFSR;
+    uint32_t hfsr = SCB->HFSR;
+    n = _panicHex(line, 2, "CFSR", cfsr);
+    n = _panicHex(line, n, "HFSR", hfsr);
+    _panicLine(line, n);
+    n = _panicHex(line, 2, "MMFAR", SCB->MMFAR);
+    n = _panicHex(line, n, "BFAR", SCB->BFAR);
+    _panicLine(line, n);
+    n = 2;
+    for (size_t i = 0; i < sizeof(_panic_bits) / sizeof(_panic_bits[0]); i++) {
+        uint8_t bit = _panic_bits[i].bit;
+        uint32_t reg = (bit < 32U) ? cfsr : hfsr;
+        if (reg & (1UL << (bit & 31U))) {
+            n = _panicAdd(line, n, _panic_bits[i].name);
+            n = _panicAdd(line, n, " ");
+        }
+    }
+    if (n > 2U) _panicLine(line, n);
+#endif
+
+    _panicEnd();
+}
+#endif
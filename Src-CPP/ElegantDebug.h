@@ -1,6 +1,6 @@
 /*******************************************************************************
  * @file    ElegantDebug.h
- * @version 1.5
+ * @version 1.6
  * @brief   ANSI-colored debug logging — STM32 HAL, Renesas RA FSP, TI MSPM0 DL.
  *
  * Cross-platform C++ debug logger supporting STM32Cube HAL, Renesas RA FSP,
@@ -26,7 +26,7 @@
  *   - See repository README for examples and integration instructions.
  *
  * @author:    WilliTourt <willitourt@foxmail.com>
- * @date:      2026-07-24
+ * @date:      2026-10-15
  * 
  * @changelog:
  * - 2025-12-10: Initial release.
@@ -42,6 +42,65 @@
  *               in the color values at runtime. Background colors too.
  * - 2026-07-16: Added uart support to Renesas RA family mcus (USE_RA_FSP).
  * - 2026-07-24: Added support for TI MSPM0 series.
+ * - 2026-10-15: Added non-blocking transmit (DEBUG_TX_NONBLOCKING). Lines are
+ *               copied into a TX ring and drained by DMA/IT on STM32 UART;
+ *               call `txCpltCallback()` from `HAL_UART_TxCpltCallback()`.
+ *             Added binary logging mode (DEBUG_BINARY_MODE) with `dbg_*` call-site
+ *               macros. Records carry a format ID + timestamp + raw args; format
+ *               strings live in a non-loaded section, see `Tools/ed_decode.py`.
+ *             Added compile-time level threshold (DEBUG_MIN_LEVEL). Log methods
+ *               are now inline templates, empty below it (arguments are still
+ *               evaluated; the dbg_* macros compile to nothing).
+ *               C++20 error()/warning() changed signature to
+ *               error(FormatLocation fmt, Args... args) and accept format
+ *               arguments; an explicit std::source_location is no longer taken.
+ *             Added per-module runtime levels (`moduleRegister()`,
+ *               `moduleInfo()` ...), filtered before any formatting.
+ *             Lines are assembled in a single buffer (no msg/combined/out
+ *               copies), less stack and time per call.
+ *             Added optional built-in printf engine (DEBUG_BUILTIN_PRINTF),
+ *               used instead of vsnprintf(); %f works without
+ *               `-u _printf_float`.
+ *             Timestamp text is cached and updated without division.
+ *             Added microsecond timestamps (DEBUG_TIMESTAMP_US) from DWT CYCCNT or
+ *               SysTick interpolation, and a pluggable clock (setClockSource()).
+ *             Added ISR/RTOS-safe logging (DEBUG_THREAD_SAFE). Lines are reserved
+ *               whole in the TX ring with one atomic step and never interleave.
+ *             USB-CDC output goes through the TX ring: busy retry, lines packed
+ *               into whole USB packets, dropped bytes counted (txDropped()).
+ *             Non-blocking transmit on TI MSPM0: TX FIFO filled in bursts and
+ *               refilled from the UART TX interrupt (txCpltCallback()).
+ *             Renesas RA output goes through the TX ring, chained from the SCI
+ *               UART callback (txCpltCallback(p_args)).
+ *             Added TX ring overflow policies (DEBUG_TX_OVERFLOW): drop, block with
+ *               timeout, keep room for warnings/errors, or overwrite the oldest
+ *               lines not being sent. Dropped lines are
+ *               counted per level (txDroppedLines()) and reported in one line.
+ *             Added logger statistics (DEBUG_STATS): lines, bytes and drops per
+ *               level, truncations, TX ring high-water mark and cycles spent
+ *               logging, in a debugger-readable struct (stats(), dumpStats()).
+ *             Added rate-limited call sites (dbg_once(), dbg_everyN(),
+ *               dbg_everyMs()); the next line tells how many calls were skipped.
+ *             Added repeated-line suppression (DEBUG_REPEAT_SUPPRESS): back-to-back
+ *               copies of a line become one "last message repeated N times".
+ *             Added hexdump(): offset/hex/ASCII rows built from a byte-to-hex
+ *               table, changed bytes highlighted against a previous snapshot.
+ *             Added binary telemetry (DEBUG_TELEMETRY, streamSamples()): delta/varint
+ *               sample packets, COBS-framed between the text lines.
+ *             Added output sinks (DEBUG_SINKS, sinkAdd()): one formatted line fans
+ *               out to the port, a RAM ring and user callbacks, each with its own
+ *               enable flag, level and color.
+ *             Added reset-surviving crash log (DEBUG_CRASHLOG): the latest output is
+ *               kept in a .noinit block with a magic/CRC header and replayed after
+ *               the reset by crashlogReplay().
+ *             Added flash log (DEBUG_FLASHLOG): a sink appending lines or binary
+ *               records to a wear-levelled ring of flash sectors behind a driver
+ *               interface, exported to the port by flashlogExport().
+ *             Added panic and fault dump (DEBUG_PANIC, panic(),
+ *               DEBUG_FAULT_HANDLER()): stacked frame and fault status registers
+ *               written through a polled register-level path, no HAL or heap.
+ *             Level prefixes come from a [colored][level] table with lengths
+ *               known at compile time, copied into the line with one memcpy.
  * 
  *******************************************************************************/
 
@@ -69,11 +128,263 @@
 
 /*** Buffer size settings ***********************************************/
 
+// Message length. The whole line (timestamp, prefix, [file:line], message) is
+// assembled in one stack buffer of DEBUG_BUFFER_LEN + 128 bytes.
 #define DEBUG_BUFFER_LEN 256
 
 /************************************************************************/
 
 
+/*** Formatter settings *************************************************/
+
+// Set to 1 to format with the library's own small printf engine instead of
+// vsnprintf(): no newlib printf code linked, no `-u _printf_float` needed.
+// Supports %d %i %u %x %X %o %c %s %p %f %%, flags "-0+ #", width and
+// precision (also '*'), length modifiers hh h l ll z t j.
+// Floats differ from vsnprintf(): %e / %g are printed like %f, at most 9
+// decimals are shown, and magnitudes above ~1.8e19 print "ovf".
+#define DEBUG_BUILTIN_PRINTF 0
+
+// Set to 0 to drop %f support from the built-in formatter (prints "?")
+#define DEBUG_PRINTF_FLOAT 1
+
+/************************************************************************/
+
+
+/*** Timestamp settings *************************************************/
+
+// Clock sources for microsecond timestamps
+#define DEBUG_CLOCK_AUTO     0  // DWT where the core has a cycle counter, else SysTick
+#define DEBUG_CLOCK_DWT      1  // DWT->CYCCNT at SystemCoreClock (M3/M4/M7/M33)
+#define DEBUG_CLOCK_SYSTICK  2  // ms tick + SysTick->VAL, SysTick must drive the 1 kHz tick
+#define DEBUG_CLOCK_TICK     3  // ms tick only, no core registers touched
+
+// Set to 1 for microsecond timestamps "[hh:mm:ss.mmmuuu]", 0 for milliseconds
+#define DEBUG_TIMESTAMP_US 0
+
+// Clock used when DEBUG_TIMESTAMP_US is 1. A clock installed at runtime with
+// `setClockSource()` takes precedence in both resolutions.
+#define DEBUG_CLOCK_SOURCE DEBUG_CLOCK_AUTO
+
+/************************************************************************/
+
+
+/*** Log level settings *************************************************/
+
+// Levels, lowest to highest
+#define DEBUG_LEVEL_LOG      0  // log() / logWithType()
+#define DEBUG_LEVEL_INFO     1
+#define DEBUG_LEVEL_OK       2
+#define DEBUG_LEVEL_SUCCESS  3
+#define DEBUG_LEVEL_WARNING  4
+#define DEBUG_LEVEL_ERROR    5
+#define DEBUG_LEVEL_NONE     6
+
+// Calls below this level compile to nothing and their format strings are not
+// linked. With the dbg_* macros their arguments are not evaluated either.
+// e.g. set to DEBUG_LEVEL_WARNING in release builds.
+#define DEBUG_MIN_LEVEL DEBUG_LEVEL_LOG
+
+// Number of modules (subsystems) with their own runtime level. Module IDs are
+// 0 ~ DEBUG_MODULE_COUNT - 1, typically an enum in your project.
+#define DEBUG_MODULE_COUNT 8
+
+// Set to 1 to collapse a line sent again and again at the same level into one
+// "last message repeated N times" line. The count is written before the next
+// different line of that level, or once DEBUG_REPEAT_TIMEOUT_MS have passed
+// since the first dropped copy. The timeout is only looked at when a line is
+// logged, of any level, or when `repeatPoll()` is called: call it from a
+// periodic task if the counts should not wait for the next line. Lines are
+// compared by length, a hash of their text after the timestamp and the first
+// DEBUG_REPEAT_KEEP_LEN bytes of it, kept per level (set it to
+// DEBUG_BUFFER_LEN to compare whole lines). On by default when compiled in,
+// see `setRepeatSuppressEnabled()`.
+#define DEBUG_REPEAT_SUPPRESS 0
+#define DEBUG_REPEAT_TIMEOUT_MS 1000
+#define DEBUG_REPEAT_KEEP_LEN 32
+
+/************************************************************************/
+
+
+/*** Transmit settings **************************************************/
+
+// Set to 1 to queue each line into a TX ring and return immediately;
+// the ring is drained in the background. 0 keeps the blocking transmit.
+// STM32 UART: drained with HAL_UART_Transmit_DMA (or _IT when no DMA channel
+// is linked to the handle). Call `txCpltCallback()` from
+// `HAL_UART_TxCpltCallback()` to chain the next chunk.
+// TI MSPM0: the UART TX FIFO is filled in bursts and refilled from the TX
+// interrupt. Call `txCpltCallback(UART_x_INST)` from the UART IRQ handler on
+// DL_UART_IIDX_TX and enable the UART interrupt in the NVIC.
+// Renesas RA: always queued, R_SCI_UART_Write() is asynchronous. The next
+// chunk starts on UART_EVENT_TX_COMPLETE: call `txCpltCallback(p_args)` from
+// the UART callback set in the FSP configurator.
+#define DEBUG_TX_NONBLOCKING 0
+
+// TX ring size in bytes. Must be a power of two, 64 ~ 32768.
+#define DEBUG_TX_RING_LEN 1024
+
+// USB-CDC (USB_AS_DEBUG_PORT = 1) always queues into the TX ring. Queued lines
+// are packed into transfers of whole packets of this size (64 for full speed,
+// 512 for high speed); a busy endpoint is retried on the next line, or right
+// away when `cdcTxCpltCallback()` is called from `CDC_TransmitCplt_FS()`.
+#define DEBUG_CDC_PACKET_LEN 64
+
+// Set to 1 to log safely from interrupts and RTOS tasks. Every line goes
+// through the TX ring: space for the whole line is reserved in one atomic
+// step (LDREX/STREX, or a few-instruction PRIMASK section on Cortex-M0/M0+),
+// so lines from different contexts never interleave. Without
+// DEBUG_TX_NONBLOCKING the caller that finds the port idle sends the ring;
+// a line logged meanwhile from an ISR or another task is sent by that caller
+// right after its own. The ring must hold at least one full line.
+#define DEBUG_THREAD_SAFE 0
+
+// What a line does when the TX ring has no room for it
+#define DEBUG_OVERFLOW_DROP      0  // the line is dropped
+#define DEBUG_OVERFLOW_BLOCK     1  // wait up to DEBUG_TX_BLOCK_MS for room, then drop
+#define DEBUG_OVERFLOW_PRIORITY  2  // drop; lines below warning leave the last
+                                    // DEBUG_TX_PRIORITY_RESERVE bytes to warnings/errors
+#define DEBUG_OVERFLOW_OVERWRITE 3  // the oldest whole lines not being sent make room
+
+// Only thread-mode callers with interrupts enabled wait; in an ISR the line
+// is dropped. Overwriting keeps the newest lines, e.g. while USB is unplugged,
+// but only lines no transfer is reading: while DMA/IT/USB still sends from
+// the ring, the new line is dropped instead. Dropped and overwritten lines
+// are counted per level and reported in one warning line
+// ("[WARNING] 12 lines dropped (1 warning, 11 info)") as soon as the ring
+// has room again. Overwriting marks what each queued line is (4 bits per
+// ring byte), so it works with binary records and telemetry packets too.
+#define DEBUG_TX_OVERFLOW DEBUG_OVERFLOW_DROP
+
+// Longest wait for DEBUG_OVERFLOW_BLOCK. A DMA transfer frees its room only
+// when it completes: a full 1 KB ring takes about 90 ms at 115200 baud.
+#define DEBUG_TX_BLOCK_MS 100
+
+// Bytes only warnings and errors may use, for DEBUG_OVERFLOW_PRIORITY
+#define DEBUG_TX_PRIORITY_RESERVE (DEBUG_TX_RING_LEN / 4)
+
+/************************************************************************/
+
+
+/*** Binary logging settings ********************************************/
+
+// Set to 1 to send compact binary records instead of rendered text. Log
+// through the `dbg_*` macros at the end of this file: they place the format
+// string in the `.elegant_debug_fmt` section (keep it out of flash in the
+// linker script, see README) and only the string's address, the timestamp
+// and the raw argument bytes go over the wire. Decode on the host with
+// `Tools/ed_decode.py firmware.elf`. Format strings must be literals.
+#define DEBUG_BINARY_MODE 0
+
+// Max size of one binary record in bytes, 16 ~ 255.
+#define DEBUG_BIN_RECORD_LEN 64
+
+/************************************************************************/
+
+
+/*** Statistics settings ************************************************/
+
+// Set to 1 to count what the logger does: lines and bytes per level,
+// truncated and dropped lines, the TX ring high-water mark and the CPU cycles
+// spent in log calls and in the transmit path. The counters are a plain
+// member struct (`_stats`), readable from a debugger without touching the
+// port; see `stats()` and `dumpStats()`. Cycles come from DWT CYCCNT and stay
+// 0 on cores without it (Cortex-M0/M0+).
+#define DEBUG_STATS 0
+
+/************************************************************************/
+
+
+/*** Telemetry settings *************************************************/
+
+// Set to 1 for the binary telemetry channel (`streamSamples()`). Sample
+// blocks are delta/varint encoded and COBS-framed between 0x00 bytes, which
+// never occur in text lines, so they share the port with the logs without
+// corrupting them. `Tools/ed_demux.py` splits a capture into the log text and
+// one CSV file per channel. Text logs only: binary mode records may contain
+// 0x00, so DEBUG_BINARY_MODE cannot be combined with it. Packets are counted
+// apart from the log lines (stats, drops).
+#define DEBUG_TELEMETRY 0
+
+// Max size of one packet before framing in bytes, 16 ~ 254. Longer sample
+// blocks are sent as several packets.
+#define DEBUG_TELEMETRY_LEN 128
+
+/************************************************************************/
+
+
+/*** Sink settings ******************************************************/
+
+// Set to 1 to send each line to several sinks at once: the debug port
+// (DEBUG_SINK_PORT), the RAM ring below (DEBUG_SINK_RAM) and callbacks added
+// with `sinkAdd()`, e.g. USB-CDC next to the UART. Each sink has its own
+// enable flag, minimum level and color setting. The line is formatted once
+// and every sink gets the same buffer; for sinks without color the ANSI
+// sequences are taken out of it in place, after the colored sinks are done.
+#define DEBUG_SINKS 0
+
+// Sinks, the debug port and the RAM ring included, 2 ~ 8
+#define DEBUG_SINK_MAX 4
+
+// RAM ring sink size in bytes, 0 for none, else a power of two 64 ~ 65536.
+// It keeps the latest lines for post-mortem reading, from a debugger or with
+// `sinkRamRead()`.
+#define DEBUG_SINK_RAM_LEN 0
+
+/************************************************************************/
+
+
+/*** Crash log settings *************************************************/
+
+// Set to 1 to keep a copy of the latest output in a RAM block that survives
+// a reset (watchdog, fault handler, NVIC_SystemReset(); not a power cycle).
+// The block sits in DEBUG_CRASHLOG_SECTION, which the startup code must
+// neither zero nor initialize: add it to the linker script as NOLOAD, see
+// README. A magic number and a CRC-32 of its header tell a block left by
+// the previous session from power-up garbage; `crashlogReplay()` sends
+// what it holds after the reset.
+#define DEBUG_CRASHLOG 0
+
+// Crash log size in bytes, a power of two 256 ~ 65536
+#define DEBUG_CRASHLOG_LEN 1024
+
+// Output section of the crash log block
+#define DEBUG_CRASHLOG_SECTION ".noinit"
+
+/************************************************************************/
+
+
+/*** Flash log settings *************************************************/
+
+// Set to 1 for a flash log: a sink that appends each line (each record in
+// binary mode) to a reserved flash region, so that logs outlive a power
+// cycle. The region is a ring of erase sectors filled one after the other,
+// which erases every sector as often as the others. The flash is reached
+// through a small driver (ElegantDebug::Flash), and `flashlogExport()` sends
+// the stored log to the port on demand. Needs DEBUG_SINKS.
+#define DEBUG_FLASHLOG 0
+
+/************************************************************************/
+
+
+/*** Panic settings *****************************************************/
+
+// Set to 1 for `panic()` and the fault dump (DEBUG_FAULT_HANDLER). With
+// interrupts off, they send what the TX ring still holds and then the fault
+// state straight to the UART data register, polling: no HAL call, no DMA,
+// no vsnprintf() and no heap, so they work when none of these can be
+// trusted any more. With DEBUG_CRASHLOG the dump also goes to the crash log.
+// USB-CDC (USB_AS_DEBUG_PORT = 1) cannot be polled: there the dump only goes
+// to the crash log.
+#define DEBUG_PANIC 0
+
+// After the dump: 1 resets the MCU (NVIC_SystemReset()), 0 stops in a loop
+// for the debugger
+#define DEBUG_PANIC_RESET 1
+
+/************************************************************************/
+
+
 #if defined(USE_STM32_HAL)
     #define DEBUG_PLATFORM_STM32  1
     #define DEBUG_PLATFORM_RA     0
@@ -90,6 +401,80 @@
     #error "Please define USE_STM32_HAL / USE_RA_FSP / USE_TI_MSPM0_DL macro before including ElegantDebug.h"
 #endif
 
+// The ring is drained by the port's own DMA/interrupts (always on RA, whose writes are asynchronous)
+#if ((DEBUG_TX_NONBLOCKING && ((DEBUG_PLATFORM_STM32 && (USB_AS_DEBUG_PORT != 1)) || DEBUG_PLATFORM_TI)) || DEBUG_PLATFORM_RA)
+    #define DEBUG_TX_RING_ENABLED 1
+#else
+    #define DEBUG_TX_RING_ENABLED 0
+#endif
+
+#if (DEBUG_PLATFORM_STM32 && (USB_AS_DEBUG_PORT == 1))
+    #define DEBUG_TX_CDC_ENABLED 1
+#else
+    #define DEBUG_TX_CDC_ENABLED 0
+#endif
+
+// Lines are queued in the TX ring, drained by DMA/IT, USB or by the caller that owns the port
+#if (DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED || DEBUG_THREAD_SAFE)
+    #define DEBUG_TX_QUEUED 1
+#else
+    #define DEBUG_TX_QUEUED 0
+#endif
+
+#if (DEBUG_BUFFER_LEN < 64)
+    #error "DEBUG_BUFFER_LEN must be at least 64"
+#endif
+
+#if DEBUG_TX_QUEUED
+    #if ((DEBUG_TX_RING_LEN & (DEBUG_TX_RING_LEN - 1)) != 0) || (DEBUG_TX_RING_LEN < 64) || (DEBUG_TX_RING_LEN > 32768)
+    #error "DEBUG_TX_RING_LEN must be a power of two between 64 and 32768"
+    #endif
+    #if (DEBUG_THREAD_SAFE && !DEBUG_TX_RING_ENABLED && !DEBUG_TX_CDC_ENABLED && \
+         (DEBUG_TX_RING_LEN < DEBUG_BUFFER_LEN + 128))
+    #error "DEBUG_THREAD_SAFE: DEBUG_TX_RING_LEN must hold one full line (DEBUG_BUFFER_LEN + 128)"
+    #endif
+    #if (DEBUG_TX_OVERFLOW < DEBUG_OVERFLOW_DROP) || (DEBUG_TX_OVERFLOW > DEBUG_OVERFLOW_OVERWRITE)
+    #error "DEBUG_TX_OVERFLOW must be one of the DEBUG_OVERFLOW_* policies"
+    #endif
+    #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_PRIORITY) && (DEBUG_TX_PRIORITY_RESERVE >= DEBUG_TX_RING_LEN)
+    #error "DEBUG_TX_PRIORITY_RESERVE must be smaller than DEBUG_TX_RING_LEN"
+    #endif
+#endif
+
+#if DEBUG_BINARY_MODE
+    #if (DEBUG_BIN_RECORD_LEN < 16) || (DEBUG_BIN_RECORD_LEN > 255)
+    #error "DEBUG_BIN_RECORD_LEN must be between 16 and 255"
+    #endif
+#endif
+
+#if DEBUG_TELEMETRY
+    #if DEBUG_BINARY_MODE
+    #error "DEBUG_TELEMETRY frames packets between 0x00 bytes, which binary records contain: not with DEBUG_BINARY_MODE"
+    #endif
+    #if (DEBUG_TELEMETRY_LEN < 16) || (DEBUG_TELEMETRY_LEN > 254)
+    #error "DEBUG_TELEMETRY_LEN must be between 16 and 254"
+    #endif
+#endif
+
+#if DEBUG_SINKS
+    #if (DEBUG_SINK_MAX < 2) || (DEBUG_SINK_MAX > 8)
+    #error "DEBUG_SINK_MAX must be between 2 and 8"
+    #endif
+    #if (DEBUG_SINK_RAM_LEN != 0) && (((DEBUG_SINK_RAM_LEN & (DEBUG_SINK_RAM_LEN - 1)) != 0) || \
+         (DEBUG_SINK_RAM_LEN < 64) || (DEBUG_SINK_RAM_LEN > 65536))
+    #error "DEBUG_SINK_RAM_LEN must be 0 or a power of two between 64 and 65536"
+    #endif
+#endif
+
+#if DEBUG_CRASHLOG && (((DEBUG_CRASHLOG_LEN & (DEBUG_CRASHLOG_LEN - 1)) != 0) || \
+                       (DEBUG_CRASHLOG_LEN < 256) || (DEBUG_CRASHLOG_LEN > 65536))
+    #error "DEBUG_CRASHLOG_LEN must be a power of two between 256 and 65536"
+#endif
+
+#if DEBUG_FLASHLOG && !DEBUG_SINKS
+    #error "DEBUG_FLASHLOG needs DEBUG_SINKS"
+#endif
+
 /*** Platform-specific includes *****************************************/
 
 #if DEBUG_PLATFORM_STM32
@@ -146,6 +531,30 @@
     #endif
 #endif
 
+// Clock actually used for microsecond timestamps
+#if DEBUG_TIMESTAMP_US
+    #if (DEBUG_CLOCK_SOURCE != DEBUG_CLOCK_AUTO)
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_SOURCE
+    #elif defined(DWT_CTRL_CYCCNTENA_Msk)
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_DWT
+    #else
+        #define DEBUG_CLOCK_USED DEBUG_CLOCK_SYSTICK
+    #endif
+#else
+    #define DEBUG_CLOCK_USED DEBUG_CLOCK_TICK
+#endif
+
+#if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT) && !defined(DWT_CTRL_CYCCNTENA_Msk)
+    #error "DEBUG_CLOCK_DWT: this core has no DWT cycle counter, use DEBUG_CLOCK_SYSTICK"
+#endif
+
+// Cycle counters of DEBUG_STATS
+#if (DEBUG_STATS && defined(DWT_CTRL_CYCCNTENA_Msk))
+    #define DEBUG_STATS_CYCLES 1
+#else
+    #define DEBUG_STATS_CYCLES 0
+#endif
+
 
 
 #include <cstdio>
@@ -157,6 +566,12 @@
 #include <source_location>
 #endif
 
+#if __cplusplus >= 201703L
+    #define _DEBUG_IF_CONSTEXPR if constexpr
+#else
+    #define _DEBUG_IF_CONSTEXPR if  // constant condition, folded by the optimizer
+#endif
+
 /* ANSI escape codes for output *****************************************/
 
 // Colors for texts
@@ -234,6 +649,12 @@
 extern volatile uint32_t _debug_tick_ms;
 #endif
 
+#if DEBUG_SINKS
+// Sink IDs, see ElegantDebug::sinkAdd()
+#define DEBUG_SINK_PORT 0   // the instance's UART / USB-CDC port
+#define DEBUG_SINK_RAM  1   // the RAM ring, when DEBUG_SINK_RAM_LEN is not 0
+#endif
+
 class ElegantDebug {
     public:
 
@@ -274,29 +695,406 @@ class ElegantDebug {
         // RA FSP tick provider (User must feed from timer ISR)
         #if (DEBUG_PLATFORM_RA || DEBUG_PLATFORM_TI)
         static inline void tick() {
-            _debug_tick_ms++;
+            _debug_tick_ms = _debug_tick_ms + 1;   // no ++ on volatile (deprecated in C++20)
         }
         #endif
 
+        #if (DEBUG_TX_RING_ENABLED && DEBUG_PLATFORM_STM32)
+        // Call from `HAL_UART_TxCpltCallback()` when DEBUG_TX_NONBLOCKING is 1:
+        // releases the chunk that has just been sent and starts the next one.
+        // Handles that are not this instance's port are ignored.
+        void txCpltCallback(UART_HandleTypeDef *huart);
+        #elif DEBUG_PLATFORM_RA
+        // Call from the SCI UART callback (set in the FSP configurator) with
+        // its arguments: on UART_EVENT_TX_COMPLETE the next queued chunk is
+        // started. Other events and channels are ignored.
+        void txCpltCallback(uart_callback_args_t *p_args);
+        #elif (DEBUG_TX_RING_ENABLED && DEBUG_PLATFORM_TI)
+        // Call from the UART IRQ handler on DL_UART_IIDX_TX when
+        // DEBUG_TX_NONBLOCKING is 1: refills the TX FIFO from the ring.
+        // Other UARTs are ignored.
+        void txCpltCallback(UART_Regs *uart_inst);
+        #endif
+
+        #if DEBUG_TX_CDC_ENABLED
+        // Optional, call from `CDC_TransmitCplt_FS()` in usbd_cdc_if.c: starts
+        // the next USB transfer as soon as the previous one is done instead of
+        // on the next line.
+        void cdcTxCpltCallback();
+        #endif
+
+        #if DEBUG_TX_QUEUED
+        // Bytes dropped so far because the TX ring was full
+        inline uint32_t txDropped() const { return _tx_dropped; }
+        // Lines of one level (DEBUG_LEVEL_*) dropped so far, see DEBUG_TX_OVERFLOW
+        inline uint32_t txDroppedLines(uint8_t level) const {
+            return (level < DEBUG_LEVEL_NONE) ? _tx_drop_lines[level] : 0U;
+        }
+        #if DEBUG_TELEMETRY
+        // Telemetry packets dropped so far
+        inline uint32_t txDroppedPackets() const { return _tx_drop_lines[_KIND_TELEMETRY]; }
+        #endif
+        #endif
+
+        #if DEBUG_STATS
+        // Counters since construction or the last statsReset(), see DEBUG_STATS
+        struct Stats {
+            uint32_t lines[DEBUG_LEVEL_NONE];   // lines (binary records) sent or queued, per level
+            uint32_t bytes[DEBUG_LEVEL_NONE];   // ... and their bytes
+            uint32_t dropped[DEBUG_LEVEL_NONE]; // lines dropped on a full TX ring, per level
+            uint32_t truncated;                 // lines cut at the line buffer (or record) size
+            uint32_t ring_high_water;           // most bytes ever held by the TX ring (0 without one)
+            #if DEBUG_TELEMETRY
+            uint32_t tlm_packets;               // telemetry packets sent or queued, not in lines[]
+            uint32_t tlm_bytes;                 // ... and their bytes
+            uint32_t tlm_dropped;               // ... dropped on a full TX ring
+            #endif
+            uint64_t log_cycles;                // CPU cycles inside log calls, transmit included
+            uint64_t tx_cycles;                 // ... of which in the transmit path
+        };
+
+        // The counters themselves; updated in place, so a debugger can watch them
+        inline const Stats& stats() const { return _stats; }
+        // Zero the counters. Lines being logged meanwhile may be counted or not.
+        void statsReset();
+        // Print the counters as info lines, as they were before the first one
+        void dumpStats();
+        #endif
+
+        // Compile-time level filter, see DEBUG_MIN_LEVEL
+        static constexpr bool levelEnabled(int level) { return level >= DEBUG_MIN_LEVEL; }
+
+        // The log methods below are inline templates so that a call below
+        // DEBUG_MIN_LEVEL is a no-op the compiler removes together with its
+        // format string. Arguments with side effects are still evaluated;
+        // use the dbg_* macros when that matters.
+
         // Basic formatted log
-        void log(const char* format, ...);
+        template <typename... Args>
+        inline void log(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_LOG)) _emit(DEBUG_LEVEL_LOG, format, args...);
+        }
 
         // Log with a type prefix
-        void logWithType(const char* type, const char* style, const char* format, ...);
+        template <typename... Args>
+        inline void logWithType(const char* type, const char* style, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_LOG)) _emitWithType(type, style, format, args...);
+        }
 
         // Convenience helpers
-        void ok(const char* format, ...);
-        void success(const char* format, ...);
-        void info(const char* format, ...);
+        template <typename... Args>
+        inline void ok(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_OK)) _emit(DEBUG_LEVEL_OK, format, args...);
+        }
+
+        template <typename... Args>
+        inline void success(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_SUCCESS)) _emit(DEBUG_LEVEL_SUCCESS, format, args...);
+        }
+
+        template <typename... Args>
+        inline void info(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_INFO)) _emit(DEBUG_LEVEL_INFO, format, args...);
+        }
+
+        #if __cplusplus < 202002L
+        template <typename... Args>
+        inline void error(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_ERROR)) _emit(DEBUG_LEVEL_ERROR, format, args...);
+        }
+
+        template <typename... Args>
+        inline void warning(const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_WARNING)) _emit(DEBUG_LEVEL_WARNING, format, args...);
+        }
+        #else
+        // Format string that also records where it was written: converting the
+        // literal at the call site fills in the caller's location, so error()
+        // and warning() can take arguments after the format. Up to 1.5 they
+        // were error(const char* format, std::source_location loc = ..., ...);
+        // a location passed explicitly is no longer accepted.
+        struct FormatLocation {
+            const char* format;
+            std::source_location loc;
+
+            FormatLocation(const char* f, std::source_location l = std::source_location::current()) :
+                format(f), loc(l) {}
+        };
+
+        template <typename... Args>
+        inline void error(FormatLocation fmt, Args... args) {
+            if constexpr (levelEnabled(DEBUG_LEVEL_ERROR)) {
+                _emitLocation(DEBUG_LEVEL_ERROR, fmt.loc.file_name(), fmt.loc.line(), fmt.format, args...);
+            }
+        }
+
+        template <typename... Args>
+        inline void warning(FormatLocation fmt, Args... args) {
+            if constexpr (levelEnabled(DEBUG_LEVEL_WARNING)) {
+                _emitLocation(DEBUG_LEVEL_WARNING, fmt.loc.file_name(), fmt.loc.line(), fmt.format, args...);
+            }
+        }
+        #endif
+
+        // Per-module runtime levels. Messages from a module below its level
+        // are dropped before any formatting: the check is one load and one
+        // compare. Modules start at DEBUG_LEVEL_LOG (everything passes) with
+        // no name; the name is printed as "[name] " after the type prefix.
+        void moduleRegister(uint8_t module, const char* name, uint8_t level = DEBUG_LEVEL_LOG) {
+            if (module >= DEBUG_MODULE_COUNT) return;
+            _module_names[module] = name;
+            _module_levels[module] = level;
+        }
+        void moduleSetLevel(uint8_t module, uint8_t level) {
+            if (module < DEBUG_MODULE_COUNT) _module_levels[module] = level;
+        }
+        uint8_t moduleGetLevel(uint8_t module) const {
+            return (module < DEBUG_MODULE_COUNT) ? _module_levels[module] : DEBUG_LEVEL_LOG;
+        }
+        const char* moduleName(uint8_t module) const {
+            const char* name = (module < DEBUG_MODULE_COUNT) ? _module_names[module] : nullptr;
+            return (name != nullptr) ? name : "";
+        }
+        inline bool moduleEnabled(uint8_t module, uint8_t level) const {
+            return (module >= DEBUG_MODULE_COUNT) || (level >= _module_levels[module]);
+        }
+
+        template <typename... Args>
+        inline void moduleLog(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_LOG)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_LOG)) _emitModule(module, DEBUG_LEVEL_LOG, nullptr, 0, format, args...);
+            }
+        }
+
+        template <typename... Args>
+        inline void moduleInfo(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_INFO)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_INFO)) _emitModule(module, DEBUG_LEVEL_INFO, nullptr, 0, format, args...);
+            }
+        }
+
+        template <typename... Args>
+        inline void moduleOk(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_OK)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_OK)) _emitModule(module, DEBUG_LEVEL_OK, nullptr, 0, format, args...);
+            }
+        }
+
+        template <typename... Args>
+        inline void moduleSuccess(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_SUCCESS)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_SUCCESS)) _emitModule(module, DEBUG_LEVEL_SUCCESS, nullptr, 0, format, args...);
+            }
+        }
 
         #if __cplusplus < 202002L
-        // void logWithType(const char* type, const char* format, ...);
-        void error(const char* format, ...);
-        void warning(const char* format, ...);
+        template <typename... Args>
+        inline void moduleWarning(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_WARNING)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_WARNING)) _emitModule(module, DEBUG_LEVEL_WARNING, nullptr, 0, format, args...);
+            }
+        }
+
+        template <typename... Args>
+        inline void moduleError(uint8_t module, const char* format, Args... args) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_ERROR)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_ERROR)) _emitModule(module, DEBUG_LEVEL_ERROR, nullptr, 0, format, args...);
+            }
+        }
         #else
-        // void logWithType(const char* type, const char* format, std::source_location loc = std::source_location::current(), ...);
-        void error(const char* format, std::source_location loc = std::source_location::current(), ...);
-        void warning(const char* format, std::source_location loc = std::source_location::current(), ...);
+        template <typename... Args>
+        inline void moduleWarning(uint8_t module, FormatLocation fmt, Args... args) {
+            if constexpr (levelEnabled(DEBUG_LEVEL_WARNING)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_WARNING)) {
+                    _emitModule(module, DEBUG_LEVEL_WARNING, fmt.loc.file_name(), fmt.loc.line(), fmt.format, args...);
+                }
+            }
+        }
+
+        template <typename... Args>
+        inline void moduleError(uint8_t module, FormatLocation fmt, Args... args) {
+            if constexpr (levelEnabled(DEBUG_LEVEL_ERROR)) {
+                if (moduleEnabled(module, DEBUG_LEVEL_ERROR)) {
+                    _emitModule(module, DEBUG_LEVEL_ERROR, fmt.loc.file_name(), fmt.loc.line(), fmt.format, args...);
+                }
+            }
+        }
+        #endif
+
+        // Per-call-site state of dbg_once() / dbg_everyN() / dbg_everyMs(),
+        // zero-initialized as a static (no constructor, so no init guard).
+        // The checks return 0 to skip the call, else 1 + the calls skipped
+        // since the site last logged.
+        struct Limit {
+            uint32_t mark;      // every N: calls left to skip; every ms: tick of the last line
+            uint32_t skipped;   // calls skipped since the last line
+            bool     started;   // false until the first call
+
+            uint32_t once() {
+                return !started ? _pass(0) : _skip();
+            }
+            uint32_t everyN(uint32_t n) {
+                if (started && mark != 0U) {
+                    mark--;
+                    return _skip();
+                }
+                return _pass((n != 0U) ? n - 1U : 0U);
+            }
+            uint32_t everyMs(uint32_t ms) {
+                uint32_t now = _getTick();
+                if (started && now - mark < ms) return _skip();
+                return _pass(now);
+            }
+
+            uint32_t _pass(uint32_t next_mark) {
+                uint32_t pass = skipped + 1U;
+                started = true;
+                mark = next_mark;
+                skipped = 0;
+                return pass;
+            }
+            uint32_t _skip() {
+                if (skipped < 0xFFFFFFFEU) skipped++;
+                return 0;
+            }
+        };
+
+        // Rate-limited variant behind the dbg_once/everyN/everyMs macros:
+        // "[N suppressed] " is added after the prefix when `suppressed` is not 0.
+        template <typename... Args>
+        inline void logLimited(uint8_t level, uint32_t suppressed, const char* file, uint32_t line,
+                               const char* format, Args... args) {
+            _emitLimited(level, suppressed, file, line, format, args...);
+        }
+
+        // Hex dump of `len` bytes at `data`, 16 per row with offset, hex and
+        // ASCII columns, one line per row at DEBUG_LEVEL_LOG. With `prev` (a
+        // snapshot of the same length) and colors on, bytes that differ from
+        // it are shown in red. In binary mode the rows are sent as raw bytes
+        // and rendered by `Tools/ed_decode.py`.
+        inline void hexdump(const void* data, size_t len, const void* prev = nullptr) {
+            _DEBUG_IF_CONSTEXPR (levelEnabled(DEBUG_LEVEL_LOG)) _hexdump(data, len, prev);
+        }
+
+        #if DEBUG_TELEMETRY
+        // Binary telemetry, see DEBUG_TELEMETRY. `n` samples of one channel go
+        // out in one or more packets, each written whole like a log line:
+        //   0x00 | COBS(channel | kind | varint ms | count | samples... | checksum) | 0x00
+        // kind: 1 int16, 2 int32, 3 float. Integer samples are zigzag varints,
+        // the first of a packet as is and the others as the difference to the
+        // previous one; floats are 4 raw bytes (little-endian). checksum is the
+        // inverted 8-bit sum of the bytes before it.
+        void streamSamples(uint8_t channel, const int16_t* samples, size_t n);
+        void streamSamples(uint8_t channel, const int32_t* samples, size_t n);
+        void streamSamples(uint8_t channel, const float* samples, size_t n);
+        #endif
+
+        #if DEBUG_SINKS
+        // Output sinks, see DEBUG_SINKS. DEBUG_SINK_PORT is this instance's
+        // port, its color is setColorEnabled(); DEBUG_SINK_RAM is the RAM
+        // ring when DEBUG_SINK_RAM_LEN is not 0.
+        //
+        // `write` is called with each line (or binary record / telemetry
+        // packet) of at least the sink's level, in the context of the log
+        // call. `data` is only valid during the call: send or copy it before
+        // returning. With DEBUG_THREAD_SAFE it may be called from several
+        // contexts at once.
+        typedef void (*SinkFn)(void* ctx, const char* data, size_t len);
+
+        // Add a sink, enabled. Returns its ID, or -1 when all DEBUG_SINK_MAX
+        // are in use. Set sinks up before logging from other contexts; the
+        // table is not locked.
+        int sinkAdd(SinkFn write, void* ctx, uint8_t level = DEBUG_LEVEL_LOG, bool color = false);
+        void sinkEnable(uint8_t sink, bool enabled);
+        void sinkSetLevel(uint8_t sink, uint8_t level);
+        void sinkSetColor(uint8_t sink, bool color);
+
+        #if DEBUG_SINK_RAM_LEN
+        // Copy the latest lines of the RAM ring into `dst`, oldest first,
+        // starting at a whole line. Returns the bytes copied; the ring is left
+        // as it is.
+        size_t sinkRamRead(char* dst, size_t size);
+        inline void sinkRamClear() { _ram_head = 0; }
+        #endif
+        #endif
+
+        #if DEBUG_CRASHLOG
+        // Crash log block, see DEBUG_CRASHLOG. Text lines (binary records in
+        // binary mode) of every instance are copied into `data` as they are
+        // written; telemetry is not kept.
+        struct CrashLog {
+            uint32_t magic;     // set once the block is in use
+            uint32_t size;      // DEBUG_CRASHLOG_LEN
+            uint32_t head;      // bytes ever written, `data` holds the last of them
+            uint32_t crc;       // CRC-32 of size and head
+            char data[DEBUG_CRASHLOG_LEN];
+        };
+
+        // The block itself, readable from a debugger after a crash
+        static CrashLog _crashlog;
+
+        // Send what the previous session left in the crash log through this
+        // instance, at DEBUG_LEVEL_LOG between two warning lines, starting at
+        // a whole line. Call once at start-up, before logging much: lines
+        // logged first may already have overwritten the oldest ones. Returns
+        // the bytes replayed, 0 when the block held nothing valid.
+        size_t crashlogReplay();
+        // Forget what the crash log holds
+        static void crashlogClear();
+        #endif
+
+        #if DEBUG_FLASHLOG
+        // Flash driver for the flash log, see DEBUG_FLASHLOG. Addresses are
+        // offsets into the log region: sector i spans i * sector_size ~
+        // (i + 1) * sector_size. program() only gets whole, aligned program
+        // units of erased flash; erase() leaves a sector all 0xFF. Each
+        // returns false on failure.
+        struct Flash {
+            bool (*read)(void* ctx, uint32_t addr, void* dst, size_t len);
+            bool (*program)(void* ctx, uint32_t addr, const void* src, size_t len);
+            bool (*erase)(void* ctx, uint32_t sector);
+            void* ctx;
+            uint32_t sector_size;   // erase unit in bytes, at least DEBUG_BUFFER_LEN + 256
+            uint16_t sectors;       // sectors in the region, at least 2
+            uint8_t prog_size;      // program unit in bytes: 1, 2, 4, 8, 16 or 32
+        };
+
+        // Mount the flash log in the region `flash` describes (kept by
+        // reference) and add its sink for lines of `level` and above. Returns
+        // the sink ID, or -1 when the geometry is not supported or all sinks
+        // are in use.
+        // Each line is programmed in the log call, and opening a new sector
+        // erases it there: keep the level high and the log calls out of ISRs.
+        // With DEBUG_THREAD_SAFE, a line logged while another is being
+        // written is dropped rather than waited for.
+        int flashlogInit(const Flash& flash, uint8_t level = DEBUG_LEVEL_WARNING);
+        // Send the stored records to this instance's port, oldest first,
+        // "--- boot ---" marking each flashlogInit(). Lines for the flash log
+        // are dropped meanwhile. Returns the records sent.
+        size_t flashlogExport();
+        // Erase the whole region; false when an erase failed
+        bool flashlogErase();
+        #endif
+
+        #if DEBUG_PANIC
+        // Exception frame the core stacks on fault entry
+        struct FaultFrame {
+            uint32_t r0, r1, r2, r3, r12;
+            uint32_t lr;        // of the faulting code
+            uint32_t pc;        // faulting instruction (or the one after it)
+            uint32_t xpsr;
+        };
+
+        // Send `reason` and the caller's address, after what the TX ring
+        // still holds, through the polled path (see DEBUG_PANIC), then reset
+        // or stop. For states the code cannot go on from; usable from any
+        // context.
+        [[noreturn]] void panic(const char* reason);
+        // The same for a fault: the stacked frame, the stack pointer it was
+        // found at, EXC_RETURN and the fault status registers (CFSR, HFSR,
+        // MMFAR, BFAR; not on Cortex-M0/M0+). Called by the handler that
+        // DEBUG_FAULT_HANDLER() defines.
+        [[noreturn]] void fault(const FaultFrame* frame, uint32_t exc_return);
         #endif
 
         static const char* customTextColor(uint8_t r, uint8_t g, uint8_t b);
@@ -309,8 +1107,91 @@ class ElegantDebug {
         inline void setFilenameLineEnabled(bool enabled) { _filename_line_enabled = enabled; }
         #endif
 
+        #if DEBUG_REPEAT_SUPPRESS
+        // Enable/disable collapsing repeated lines; disabling reports pending counts
+        void setRepeatSuppressEnabled(bool enabled);
+        // Report the counts whose DEBUG_REPEAT_TIMEOUT_MS has passed, without
+        // waiting for the next line. Not from an ISR: it may log.
+        void repeatPoll();
+        #endif
+
+        // Install a microsecond clock for timestamps, e.g. a free-running
+        // hardware timer or a fake counter in host tests. nullptr restores
+        // DEBUG_CLOCK_SOURCE.
+        inline void setClockSource(uint64_t (*now_us)()) { _clock_us = now_us; }
+
+        #if DEBUG_BINARY_MODE
+        // Binary record, see "Binary logging" at the end of this file
+        struct BinRecord {
+            uint8_t len;
+            uint8_t level;      // DEBUG_LEVEL_*, for DEBUG_TX_OVERFLOW
+            #if DEBUG_STATS
+            uint32_t t0;        // cycle count at _binBegin()
+            #endif
+            uint8_t buf[DEBUG_BIN_RECORD_LEN];
+        };
+
+        // Record builders used by the dbg_* macros. `format` is the same literal
+        // that went into the format section; it is only there to keep the macro
+        // simple and is dropped once this is inlined.
+        template <typename... Args>
+        void binRecord(const char* fmt_id, uint8_t level, const char* format, Args... args) {
+            (void)format;
+            BinRecord rec;
+            _binBegin(rec, fmt_id, level);
+            int expand[] = {0, (_binArg(rec, args), 0)...};
+            (void)expand;
+            _binEnd(rec);
+        }
+
+        template <typename... Args>
+        void binRecordWithType(const char* fmt_id, const char* type, const char* style,
+                               const char* format, Args... args) {
+            (void)format;
+            BinRecord rec;
+            _binBegin(rec, fmt_id, DEBUG_LEVEL_LOG);
+            _binArg(rec, type);
+            _binArg(rec, style);
+            int expand[] = {0, (_binArg(rec, args), 0)...};
+            (void)expand;
+            _binEnd(rec);
+        }
+
+        // Module variant: the module name goes first, the dbg_module* macros
+        // have already checked the module level.
+        template <typename... Args>
+        void binRecordWithModule(const char* fmt_id, uint8_t module, uint8_t level,
+                                 const char* format, Args... args) {
+            (void)format;
+            BinRecord rec;
+            _binBegin(rec, fmt_id, level);
+            _binArg(rec, moduleName(module));
+            int expand[] = {0, (_binArg(rec, args), 0)...};
+            (void)expand;
+            _binEnd(rec);
+        }
+
+        // Rate-limited variant, see dbg_once()
+        template <typename... Args>
+        void binRecordLimited(const char* fmt_id, uint8_t level, uint32_t suppressed,
+                              const char* format, Args... args) {
+            (void)format;
+            BinRecord rec;
+            _binBegin(rec, fmt_id, level);
+            if (suppressed != 0U) _binSuppressed(rec, suppressed);
+            int expand[] = {0, (_binArg(rec, args), 0)...};
+            (void)expand;
+            _binEnd(rec);
+        }
+        #endif
+
     private:
 
+        // What the port sends, for the counters: a line of one level, or a
+        // telemetry packet in the slot after them
+        static constexpr uint8_t _KIND_TELEMETRY = DEBUG_LEVEL_NONE;
+        static constexpr uint8_t _KINDS = DEBUG_LEVEL_NONE + DEBUG_TELEMETRY;
+
         #if DEBUG_PLATFORM_STM32
         UART_HandleTypeDef *    _huart;
         #elif DEBUG_PLATFORM_RA
@@ -326,8 +1207,253 @@ class ElegantDebug {
         bool _filename_line_enabled;
         #endif
 
-        void _send(const char* text);
-        uint32_t _getTick();
+        uint8_t     _module_levels[DEBUG_MODULE_COUNT] = {};
+        const char* _module_names[DEBUG_MODULE_COUNT] = {};
+
+        #if DEBUG_REPEAT_SUPPRESS
+        // Last line of each level, identified by the length, a hash and the
+        // first bytes of the text after the timestamp, and the back-to-back
+        // copies of it not shown yet
+        struct Repeat {
+            uint32_t hash;
+            uint32_t len;
+            uint32_t count;     // copies dropped since the line was shown
+            uint32_t since;     // tick of the first of them
+            char     head[DEBUG_REPEAT_KEEP_LEN];
+        };
+        Repeat  _repeat[DEBUG_LEVEL_NONE] = {};
+        uint8_t _repeat_pending = 0;     // levels with count != 0
+        bool    _repeat_enabled = true;
+
+        void _repeatExpire(uint32_t now, uint32_t* report);
+        bool _repeatFilter(uint8_t level, const char* text, size_t n);
+        void _repeatSend(uint8_t level, uint32_t count);
+        #endif
+
+        #if DEBUG_TX_QUEUED
+        // Indices run freely modulo 2^17, see _txReserve()
+        uint8_t _tx_ring[DEBUG_TX_RING_LEN];
+        volatile uint32_t _tx_claim = 0;     // reserve index | writers still copying
+        volatile uint32_t _tx_head = 0;      // end of the committed lines
+        volatile uint32_t _tx_tail = 0;      // read index
+        volatile uint32_t _tx_dropped = 0;   // bytes of lines that did not fit
+        volatile uint32_t _tx_drop_lines[_KINDS] = {};  // lines dropped, per level, then packets
+        volatile uint32_t _tx_drop_shown[_KINDS] = {};  // ... already reported
+        volatile uint32_t _tx_drop_new = 0;  // 1 when there are drops to report
+        volatile uint32_t _tx_reporting = 0; // 1 while a caller writes the report
+        #if ((DEBUG_TX_RING_ENABLED && !DEBUG_PLATFORM_TI) || DEBUG_TX_CDC_ENABLED)
+        volatile uint16_t _tx_inflight = 0;  // bytes handed to DMA/IT/USB, released on TX complete
+        #elif !DEBUG_TX_RING_ENABLED
+        volatile uint32_t _tx_busy = 0;      // 1 while a caller is sending the ring
+        #endif
+
+        // What a queued line is, marked at its first byte: a line of a level
+        // (or a telemetry packet), or a drop report and the slot that holds
+        // its counts
+        static constexpr uint32_t _TX_MARK_LINE = 1U;
+        static constexpr uint32_t _TX_MARK_REPORT = _TX_MARK_LINE + _KINDS;
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+        static constexpr uint8_t _TX_REPORTS = 4U;
+        volatile uint32_t _tx_marks[DEBUG_TX_RING_LEN / 8U] = {};  // 4 bits a byte, 0 inside a line
+        uint32_t _tx_report_counts[_TX_REPORTS][_KINDS] = {};       // what each queued report counts
+        uint32_t _tx_report_at[_TX_REPORTS] = {};                   // ... and where it starts
+        #endif
+
+        int32_t _txReserve(size_t len, size_t keep);
+        void _txCommit(uint32_t start, size_t len, uint32_t mark);
+        void _txCopy(uint32_t start, const char* data, size_t len);
+        void _txDrop(uint8_t level, uint32_t lines, size_t len);
+        void _txReport(size_t room);
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_OVERWRITE)
+        void _txMark(uint32_t start, size_t len, uint32_t mark);
+        uint32_t _txMarkAt(uint32_t i);
+        uint32_t _txNextLine(uint32_t i, uint32_t end);
+        int _txReportSlot();
+        bool _txEvict(size_t need);
+        #endif
+        #if (DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED)
+        void _txKick();
+        #else
+        void _txDrain();
+        #endif
+        void _txPush();
+        #if (DEBUG_TX_OVERFLOW == DEBUG_OVERFLOW_BLOCK)
+        int32_t _txReserveWait(size_t len);
+        #endif
+        #endif
+
+        #if DEBUG_STATS
+        Stats _stats = {};
+        void _statsLine(uint8_t level, size_t len);
+        void _statsCount(uint32_t& counter);
+        void _statsCycles(uint64_t& sum, uint32_t t0);
+        #if DEBUG_TX_QUEUED
+        void _statsHighWater(uint32_t used);
+        #endif
+        #endif
+
+        #if !(DEBUG_TX_RING_ENABLED || DEBUG_TX_CDC_ENABLED)
+        void _portWrite(const char* data, size_t len);
+        #endif
+        void _portSend(uint8_t level, const char* data, size_t len);
+        void _write(uint8_t level, char* data, size_t len);
+        void _writeRaw(uint8_t level, const char* data, size_t len);
+        #if (DEBUG_SINKS || (DEBUG_CRASHLOG && !DEBUG_BINARY_MODE))
+        static size_t _ansiStrip(char* s, size_t len);
+        #endif
+
+        #if DEBUG_SINKS
+        struct Sink {
+            SinkFn  write;      // nullptr for the port and the RAM ring
+            void*   ctx;
+            uint8_t level;      // lines below it are not sent
+            bool    enabled;
+            bool    color;      // the port's is _color_enabled
+        };
+        Sink    _sinks[DEBUG_SINK_MAX] = {
+            { nullptr, nullptr, DEBUG_LEVEL_LOG, true, false },     // DEBUG_SINK_PORT
+        #if DEBUG_SINK_RAM_LEN
+            { nullptr, nullptr, DEBUG_LEVEL_LOG, true, false },     // DEBUG_SINK_RAM
+        #endif
+        };
+        uint8_t _sink_count = (DEBUG_SINK_RAM_LEN != 0) ? 2 : 1;
+        bool    _sink_color = false;                // a sink other than the port wants colors
+        uint8_t _sink_level = DEBUG_LEVEL_LOG;      // lowest level any enabled sink takes
+
+        #if DEBUG_SINK_RAM_LEN
+        // Overwritten oldest first; _ram_head counts every byte ever written
+        char     _ram_ring[DEBUG_SINK_RAM_LEN];
+        uint32_t _ram_head = 0;
+        void _ramWrite(const char* data, size_t len);
+        #endif
+
+        void _sinkUpdate();
+        inline bool _sinkTakes(uint8_t i, uint8_t level) const {
+            return _sinks[i].enabled && level >= _sinks[i].level;
+        }
+        void _sinkSend(uint8_t i, uint8_t level, const char* data, size_t len);
+
+        #if DEBUG_FLASHLOG
+        const Flash* _fl = nullptr;     // nullptr until flashlogInit()
+        uint32_t _fl_seq = 0;           // sequence number of the active sector
+        uint32_t _fl_off = 0;           // write offset in it
+        uint16_t _fl_sector = 0;        // active sector, the newest one
+        bool     _fl_busy = false;      // a record or export in progress
+
+        inline uint32_t _flRound(uint32_t n) const {
+            uint32_t u = _fl->prog_size;
+            return (n + u - 1U) & ~(u - 1U);
+        }
+        inline uint32_t _flAddr(uint16_t sector, uint32_t off) const {
+            return (uint32_t)sector * _fl->sector_size + off;
+        }
+        bool _flTake();
+        bool _flProgram(uint32_t addr, const uint8_t* a, size_t alen, const uint8_t* b, size_t blen);
+        bool _flSectorValid(uint16_t sector, uint32_t& seq);
+        int32_t _flRecord(uint16_t sector, uint32_t off, uint8_t& sum);
+        bool _flOpen();
+        void _flAppend(const uint8_t* data, size_t len);
+        void _flMount();
+        static void _flSink(void* ctx, const char* data, size_t len);
+        #if !DEBUG_BINARY_MODE
+        void _flNote(char* buf, const char* text, size_t records);
+        #endif
+        #endif
+
+        // Lines are formatted with colors when any sink shows them
+        inline bool _colorOn() const { return _color_enabled || _sink_color; }
+        #else
+        inline bool _colorOn() const { return _color_enabled; }
+        #endif
+
+        #if DEBUG_PANIC
+        bool _panic_port = false;       // port still taking bytes
+        void _panicPort(const char* s, size_t len);
+        void _panicWrite(const char* s, size_t len);
+        void _panicBegin();
+        [[noreturn]] void _panicEnd();
+        void _panicLine(char* line, size_t n);
+        void _panicTitle(const char* title, const char* reason);
+        #endif
+
+        static uint32_t _getTick();
+        #if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT)
+        static uint64_t _clockDwt();
+        #elif (DEBUG_CLOCK_USED == DEBUG_CLOCK_SYSTICK)
+        static uint64_t _clockSysTick();
+        #endif
+
+        #if DEBUG_TIMESTAMP_US
+        typedef uint64_t TsTime;        // microseconds
+        #else
+        typedef uint32_t TsTime;        // milliseconds
+        #endif
+
+        uint64_t (*_clock_us)() = nullptr;
+
+        // Rendered "[hh:mm:ss.mmm] ", see _tsUpdate()
+        char     _ts_text[32] = {};
+        uint8_t  _ts_len = 0;           // 0 until the first line
+        TsTime   _ts_time = 0;          // time the text was rendered for
+        TsTime   _ts_sec_start = 0;     // time at the start of the rendered second
+        uint32_t _ts_hours = 0;
+        uint8_t  _ts_minutes = 0;
+        uint8_t  _ts_seconds = 0;
+
+        TsTime _clockNow();
+        void _tsRenderSecond();
+        void _tsUpdate(TsTime now);
+        size_t _tsCopy(char* dst);
+
+        struct Line;    // line under assembly, see ElegantDebug.cpp
+        void _lineBegin(Line& l);
+        void _lineEnd(Line& l, uint8_t level);
+        void _vemit(uint8_t level, const char* name, const char* file, uint32_t line,
+                    uint32_t suppressed, const char* format, va_list args);
+
+        struct Prefix;  // level prefix and its length, see ElegantDebug.cpp
+        template <size_t N>
+        static constexpr Prefix _prefixOf(const char (&s)[N]);
+        static const Prefix _prefixes[2][DEBUG_LEVEL_NONE];     // [colored][level]
+        const Prefix& _prefix(uint8_t level) const;
+        void _emit(uint8_t level, const char* format, ...);
+        void _emitWithType(const char* type, const char* style, const char* format, ...);
+        #if __cplusplus >= 202002L
+        void _emitLocation(uint8_t level, const char* file, uint32_t line, const char* format, ...);
+        #endif
+        void _emitModule(uint8_t module, uint8_t level, const char* file, uint32_t line, const char* format, ...);
+        void _emitLimited(uint8_t level, uint32_t suppressed, const char* file, uint32_t line, const char* format, ...);
+        void _hexdump(const void* data, size_t len, const void* prev);
+        void _hexRow(const uint8_t* p, size_t off, size_t n, uint32_t changed, bool wide);
+
+        #if DEBUG_TELEMETRY
+        struct TlmPacket;   // packet under assembly, see ElegantDebug.cpp
+        void _tlmSend(TlmPacket& f);
+        void _tlmRoom(TlmPacket& f, size_t size);
+        void _tlmInt(TlmPacket& f, int32_t v, uint32_t& last, size_t size);
+        #endif
+
+        #if DEBUG_BINARY_MODE
+        void _binBegin(BinRecord& rec, const char* fmt_id, uint8_t level);
+        void _binEnd(BinRecord& rec);
+        static bool _binRoom(BinRecord& rec, size_t n);
+        static void _binPut(BinRecord& rec, uint64_t v, size_t n);
+        static void _binSuppressed(BinRecord& rec, uint32_t n);
+
+        // Argument encoders: integers as 4 bytes (8 for long long), floating
+        // point as an 8-byte double, strings inline with NUL, pointers as 4 bytes.
+        // Narrower integers and float reach these through promotion.
+        static void _binArg(BinRecord& rec, int v)                { _binPut(rec, (uint32_t)v, 4); }
+        static void _binArg(BinRecord& rec, unsigned int v)       { _binPut(rec, v, 4); }
+        static void _binArg(BinRecord& rec, long v)               { _binPut(rec, (unsigned long)v, sizeof(long)); }
+        static void _binArg(BinRecord& rec, unsigned long v)      { _binPut(rec, v, sizeof(long)); }
+        static void _binArg(BinRecord& rec, long long v)          { _binPut(rec, (uint64_t)v, 8); }
+        static void _binArg(BinRecord& rec, unsigned long long v) { _binPut(rec, v, 8); }
+        static void _binArg(BinRecord& rec, const void* p)        { _binPut(rec, (uint32_t)(uintptr_t)p, 4); }
+        static void _binArg(BinRecord& rec, char* s)              { _binArg(rec, (const char*)s); }
+        static void _binArg(BinRecord& rec, const char* s);
+        static void _binArg(BinRecord& rec, double v);
+        #endif
 
     // #if !__cpp_lib_source_location
     //     // If compiler doesn't support c++20 source_location, use macro to log with file and line number
@@ -341,14 +1467,222 @@ class ElegantDebug {
     // #endif
 };
 
-// #if !__cpp_lib_source_location
+#if DEBUG_PANIC
+/*** Fault handler *****************************************************/
+//
+// DEBUG_FAULT_HANDLER(HardFault_Handler, dbg) defines fault handler `name`
+// (HardFault_Handler, MemManage_Handler, ...) to pass the frame of the stack
+// in use to dbg.fault(). Remove the generated handler of the same name,
+// e.g. in stm32xxxx_it.c.
+
+#define DEBUG_FAULT_HANDLER(name, dbg_inst)                                     \
+    extern "C" void name##_dump(const ElegantDebug::FaultFrame* frame,          \
+                                uint32_t exc_return) {                          \
+        (dbg_inst).fault(frame, exc_return);                                    \
+    }                                                                           \
+    extern "C" __attribute__((naked)) void name(void) {                         \
+        __asm volatile(                                                         \
+            "movs r0, #4            \n"                                         \
+            "mov  r1, lr            \n"                                         \
+            "tst  r0, r1            \n"   /* EXC_RETURN bit 2: PSP in use */    \
+            "beq  1f                \n"                                         \
+            "mrs  r0, psp           \n"                                         \
+            "b    2f                \n"                                         \
+            "1:                     \n"                                         \
+            "mrs  r0, msp           \n"                                         \
+            "2:                     \n"                                         \
+            "ldr  r2, =" #name "_dump \n"                                       \
+            "bx   r2                \n"                                         \
+            ".ltorg                 \n");                                       \
+    }
+
+/************************************************************************/
+#endif
+
+/*** Call-site macros **************************************************/
+//
+// dbg_info(dbg, "fmt", ...) and friends. In text mode they forward to the
+// methods of the same name. In binary mode they are the way to log: the
+// format string has to be placed in the format section at the call site.
+
+#if !DEBUG_BINARY_MODE
+
+#define dbg_log(dbg_inst, ...)                          (dbg_inst).log(__VA_ARGS__)
+#define dbg_info(dbg_inst, ...)                         (dbg_inst).info(__VA_ARGS__)
+#define dbg_ok(dbg_inst, ...)                           (dbg_inst).ok(__VA_ARGS__)
+#define dbg_success(dbg_inst, ...)                      (dbg_inst).success(__VA_ARGS__)
+#define dbg_warning(dbg_inst, ...)                      (dbg_inst).warning(__VA_ARGS__)
+#define dbg_error(dbg_inst, ...)                        (dbg_inst).error(__VA_ARGS__)
+#define dbg_logWithType(dbg_inst, type, style, ...)     (dbg_inst).logWithType((type), (style), __VA_ARGS__)
+
+#define dbg_moduleLog(dbg_inst, module, ...)            (dbg_inst).moduleLog((module), __VA_ARGS__)
+#define dbg_moduleInfo(dbg_inst, module, ...)           (dbg_inst).moduleInfo((module), __VA_ARGS__)
+#define dbg_moduleOk(dbg_inst, module, ...)             (dbg_inst).moduleOk((module), __VA_ARGS__)
+#define dbg_moduleSuccess(dbg_inst, module, ...)        (dbg_inst).moduleSuccess((module), __VA_ARGS__)
+#define dbg_moduleWarning(dbg_inst, module, ...)        (dbg_inst).moduleWarning((module), __VA_ARGS__)
+#define dbg_moduleError(dbg_inst, module, ...)          (dbg_inst).moduleError((module), __VA_ARGS__)
+
+#else
+
+/*** Binary logging *****************************************************/
+//
+// Record on the wire (little-endian):
+//   0xED | len | flags | varint fmt address | [u32 ms] | [u32 suppressed] | args... | checksum
+// `len` counts the bytes between itself and the checksum; checksum is the
+// inverted 8-bit sum of those bytes. flags: bit0 timestamp, bit1 color,
+// bit2 filename/line, bit3 suppressed count (rate-limited call sites),
+// bit7 arguments truncated.
+//
+// Format section entry: "<tag>\x1F<file>\x1F<line>\x1F<format>", tag is one
+// of L(og) T(ype) I(nfo) O(k) S(uccess) W(arning) E(rror); lower case for
+// the module variants, whose first argument is the module name. H(exdump)
+// rows have an empty format and carry u32 offset | u8 count (bit7: 8-digit
+// offset) | u16 changed-byte mask | the bytes.
+
+#define DEBUG_BIN_SYNC 0xEDU
+
+#define DEBUG_BIN_SECTION   __attribute__((section(".elegant_debug_fmt"), used))
+
+#define _DEBUG_STR_(x)      #x
+#define _DEBUG_STR(x)       _DEBUG_STR_(x)
+#define _DEBUG_BIN_FIRST(...) _DEBUG_BIN_FIRST_(__VA_ARGS__, ~)
+#define _DEBUG_BIN_FIRST_(f, ...) f
+
+#define _DEBUG_BIN_FMT(tag, ...)                                                \
+        static const char _debug_fmt[] DEBUG_BIN_SECTION =                      \
+            tag "\x1F" __FILE__ "\x1F" _DEBUG_STR(__LINE__) "\x1F"             \
+            _DEBUG_BIN_FIRST(__VA_ARGS__)
+
+// DEBUG_LEVEL_* of a record tag, folded at compile time (the format section
+// itself is not readable at run time)
+#define _DEBUG_BIN_LEVEL(tag)                                                   \
+        ((((tag)[0] | 0x20) == 'e') ? DEBUG_LEVEL_ERROR :                       \
+         (((tag)[0] | 0x20) == 'w') ? DEBUG_LEVEL_WARNING :                     \
+         (((tag)[0] | 0x20) == 's') ? DEBUG_LEVEL_SUCCESS :                     \
+         (((tag)[0] | 0x20) == 'o') ? DEBUG_LEVEL_OK :                          \
+         (((tag)[0] | 0x20) == 'i') ? DEBUG_LEVEL_INFO : DEBUG_LEVEL_LOG)
+
+#define _DEBUG_BIN_RECORD(dbg_inst, tag, ...) do {                              \
+        _DEBUG_BIN_FMT(tag, __VA_ARGS__);                                       \
+        (dbg_inst).binRecord(_debug_fmt, _DEBUG_BIN_LEVEL(tag), __VA_ARGS__);   \
+    } while (0)
+
+#define dbg_log(dbg_inst, ...)                          _DEBUG_BIN_RECORD(dbg_inst, "L", __VA_ARGS__)
+#define dbg_info(dbg_inst, ...)                         _DEBUG_BIN_RECORD(dbg_inst, "I", __VA_ARGS__)
+#define dbg_ok(dbg_inst, ...)                           _DEBUG_BIN_RECORD(dbg_inst, "O", __VA_ARGS__)
+#define dbg_success(dbg_inst, ...)                      _DEBUG_BIN_RECORD(dbg_inst, "S", __VA_ARGS__)
+#define dbg_warning(dbg_inst, ...)                      _DEBUG_BIN_RECORD(dbg_inst, "W", __VA_ARGS__)
+#define dbg_error(dbg_inst, ...)                        _DEBUG_BIN_RECORD(dbg_inst, "E", __VA_ARGS__)
+#define dbg_logWithType(dbg_inst, type, style, ...) do {                        \
+        _DEBUG_BIN_FMT("T", __VA_ARGS__);                                       \
+        (dbg_inst).binRecordWithType(_debug_fmt, (type), (style), __VA_ARGS__); \
+    } while (0)
+
+#define _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, level, tag, ...) do {        \
+        if ((dbg_inst).moduleEnabled((module), (level))) {                      \
+            _DEBUG_BIN_FMT(tag, __VA_ARGS__);                                   \
+            (dbg_inst).binRecordWithModule(_debug_fmt, (module), (level),       \
+                                           __VA_ARGS__);                        \
+        }                                                                       \
+    } while (0)
+
+#define dbg_moduleLog(dbg_inst, module, ...)            _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_LOG, "l", __VA_ARGS__)
+#define dbg_moduleInfo(dbg_inst, module, ...)           _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_INFO, "i", __VA_ARGS__)
+#define dbg_moduleOk(dbg_inst, module, ...)             _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_OK, "o", __VA_ARGS__)
+#define dbg_moduleSuccess(dbg_inst, module, ...)        _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_SUCCESS, "s", __VA_ARGS__)
+#define dbg_moduleWarning(dbg_inst, module, ...)        _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_WARNING, "w", __VA_ARGS__)
+#define dbg_moduleError(dbg_inst, module, ...)          _DEBUG_BIN_MODULE_RECORD(dbg_inst, module, DEBUG_LEVEL_ERROR, "e", __VA_ARGS__)
 
-// #define dbg_log(dbg_inst, ...)           (dbg_inst)._log(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_info(dbg_inst, ...)          (dbg_inst)._info(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_error(dbg_inst, ...)         (dbg_inst)._error(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_warning(dbg_inst, ...)       (dbg_inst)._warning(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_ok(dbg_inst, ...)            (dbg_inst)._ok(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_success(dbg_inst, ...)       (dbg_inst)._success(__FILE__, __LINE__, __VA_ARGS__)
-// #define dbg_logtype(dbg_inst, type, ...) (dbg_inst)._logWithType(__FILE__, __LINE__, type, __VA_ARGS__)
+/************************************************************************/
 
-// #endif
+#endif // !DEBUG_BINARY_MODE
+
+// Rate-limited call sites. `lvl` is a level name without DEBUG_LEVEL_: LOG,
+// INFO, OK, SUCCESS, WARNING or ERROR. Each call site keeps a few bytes of
+// static state; a skipped call is a compare and an increment, its arguments
+// are not evaluated and nothing is formatted. The next line from the site
+// tells how many calls were skipped:
+//   "[ERROR] [adc.cpp:88] [1234 suppressed] ADC timeout"
+//
+//   dbg_once(dbg, lvl, format, ...)            only the first call
+//   dbg_everyN(dbg, lvl, n, format, ...)       the 1st, (n+1)th, (2n+1)th ... call
+//   dbg_everyMs(dbg, lvl, ms, format, ...)     at most one line per `ms`
+//
+// The state is not locked: from several contexts at once the counts are
+// approximate.
+#define dbg_once(dbg_inst, lvl, ...)        _DEBUG_LIMIT(dbg_inst, DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                         _debug_lim.once(), __VA_ARGS__)
+#define dbg_everyN(dbg_inst, lvl, n, ...)   _DEBUG_LIMIT(dbg_inst, DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                         _debug_lim.everyN(n), __VA_ARGS__)
+#define dbg_everyMs(dbg_inst, lvl, ms, ...) _DEBUG_LIMIT(dbg_inst, DEBUG_LEVEL_##lvl, _DEBUG_BIN_TAG_##lvl, \
+                                                         _debug_lim.everyMs(ms), __VA_ARGS__)
+
+#define _DEBUG_BIN_TAG_LOG      "L"
+#define _DEBUG_BIN_TAG_INFO     "I"
+#define _DEBUG_BIN_TAG_OK       "O"
+#define _DEBUG_BIN_TAG_SUCCESS  "S"
+#define _DEBUG_BIN_TAG_WARNING  "W"
+#define _DEBUG_BIN_TAG_ERROR    "E"
+
+// Levels below DEBUG_MIN_LEVEL fold to nothing, state included
+#define _DEBUG_LIMIT(dbg_inst, level, tag, check, ...) do {                     \
+        if (ElegantDebug::levelEnabled(level)) {                                \
+            static ElegantDebug::Limit _debug_lim;                              \
+            uint32_t _debug_pass = (check);                                     \
+            if (_debug_pass != 0U) {                                            \
+                _DEBUG_LIMIT_EMIT(dbg_inst, level, tag, _debug_pass - 1U, __VA_ARGS__); \
+            }                                                                   \
+        }                                                                       \
+    } while (0)
+
+#if !DEBUG_BINARY_MODE
+    #define _DEBUG_LIMIT_EMIT(dbg_inst, level, tag, n, ...)                     \
+        (dbg_inst).logLimited((level), (n), ((level) >= DEBUG_LEVEL_WARNING) ? __FILE__ : nullptr, \
+                              __LINE__, __VA_ARGS__)
+#else
+    #define _DEBUG_LIMIT_EMIT(dbg_inst, level, tag, n, ...) do {                \
+        _DEBUG_BIN_FMT(tag, __VA_ARGS__);                                       \
+        (dbg_inst).binRecordLimited(_debug_fmt, (level), (n), __VA_ARGS__);     \
+    } while (0)
+#endif
+
+// Compile-time level filter (DEBUG_MIN_LEVEL): filtered macros expand to an
+// empty expression, so their arguments are never evaluated.
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_LOG)
+    #undef  dbg_log
+    #undef  dbg_logWithType
+    #define dbg_log(...)                ((void)0)
+    #define dbg_logWithType(...)        ((void)0)
+    #undef  dbg_moduleLog
+    #define dbg_moduleLog(...)          ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_INFO)
+    #undef  dbg_info
+    #define dbg_info(...)               ((void)0)
+    #undef  dbg_moduleInfo
+    #define dbg_moduleInfo(...)         ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_OK)
+    #undef  dbg_ok
+    #define dbg_ok(...)                 ((void)0)
+    #undef  dbg_moduleOk
+    #define dbg_moduleOk(...)           ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_SUCCESS)
+    #undef  dbg_success
+    #define dbg_success(...)            ((void)0)
+    #undef  dbg_moduleSuccess
+    #define dbg_moduleSuccess(...)      ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_WARNING)
+    #undef  dbg_warning
+    #define dbg_warning(...)            ((void)0)
+    #undef  dbg_moduleWarning
+    #define dbg_moduleWarning(...)      ((void)0)
+#endif
+#if (DEBUG_MIN_LEVEL > DEBUG_LEVEL_ERROR)
+    #undef  dbg_error
+    #define dbg_error(...)              ((void)0)
+    #undef  dbg_moduleError
+    #define dbg_moduleError(...)        ((void)0)
+#endif
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * @file        bench.c
+ * @brief       Cost of the C API calls on one platform: ns per call, bytes
+ *              per call and peak stack, colors off and on. Run with --quick
+ *              for a short run.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "bench.h"
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #define BENCH_PORT (&huart1)
+#elif defined(USE_RA_FSP)
+    #define BENCH_PORT (&g_uart0)
+#elif defined(USE_TI_MSPM0_DL)
+    #define BENCH_PORT UART_0_INST
+#endif
+
+// Versions before the RA TX ring wrote from the line buffer and had no
+// callback to forward
+#if defined(USE_RA_FSP) && DEBUG_TX_RING_ENABLED
+void user_uart_callback(uart_callback_args_t* p_args) {
+    debug_txCpltCallback(p_args);
+}
+#endif
+
+static void _log(unsigned i) {
+    debug_log("sensor %u: %d mV, state %s\n", i, 3300, "idle");
+}
+
+static void _logWithType(unsigned i) {
+    debug_logWithType("[ADC] ", COLOR_CYAN, "sensor %u: %d mV, state %s", i, 3300, "idle");
+}
+
+static void _info(unsigned i) {
+    debug_info("sensor %u: %d mV, state %s", i, 3300, "idle");
+}
+
+static void _error(unsigned i) {
+    debug_error("sensor %u: %d mV, state %s", i, 3300, "idle");
+}
+
+int main(int argc, char** argv) {
+    unsigned n = bench_iterations(argc, argv);
+
+    mock_reset();
+    mock_capture = false;
+    mock_tick_base = 3723456U;      // 01:02:03.456
+    debug_init(BENCH_PORT, true, false, false);
+
+    bench_header("C API");
+    for (int color = 0; color <= 1; color++) {
+        debug_setColorEnabled(color);
+
+        debug_setFilenameLineEnabled(false);
+        bench_row("debug_log", color, bench_run(_log, n));
+        bench_row("debug_logWithType", color, bench_run(_logWithType, n));
+        bench_row("debug_info", color, bench_run(_info, n));
+        bench_row("debug_error", color, bench_run(_error, n));
+        debug_setFilenameLineEnabled(true);
+        bench_row("debug_error, file:line", color, bench_run(_error, n));
+    }
+    return 0;
+}
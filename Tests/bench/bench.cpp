@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * @file        bench.cpp
+ * @brief       Cost of the C++ API calls on one platform: ns per call, bytes
+ *              per call and peak stack, colors off and on. Built as C++20 so
+ *              error() can take its location. Run with --quick for a short
+ *              run.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "bench.h"
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #define BENCH_PORT (&huart1)
+#elif defined(USE_RA_FSP)
+    #define BENCH_PORT (&g_uart0)
+#elif defined(USE_TI_MSPM0_DL)
+    #define BENCH_PORT UART_0_INST
+#endif
+
+static ElegantDebug dbg(BENCH_PORT, true, false, false);
+
+// Versions before the RA TX ring wrote from the line buffer and had no
+// callback to forward
+#if defined(USE_RA_FSP) && DEBUG_TX_RING_ENABLED
+void user_uart_callback(uart_callback_args_t* p_args) {
+    dbg.txCpltCallback(p_args);
+}
+#endif
+
+static void _log(unsigned i) {
+    dbg.log("sensor %u: %d mV, state %s\n", i, 3300, "idle");
+}
+
+static void _logWithType(unsigned i) {
+    dbg.logWithType("[ADC] ", COLOR_CYAN, "sensor %u: %d mV, state %s", i, 3300, "idle");
+}
+
+static void _info(unsigned i) {
+    dbg.info("sensor %u: %d mV, state %s", i, 3300, "idle");
+}
+
+static void _error(unsigned i) {
+#ifndef DEBUG_MIN_LEVEL
+    // Versions before FormatLocation took the location as a defaulted
+    // parameter ahead of the arguments
+    dbg.error("sensor %u: %d mV, state %s", std::source_location::current(), i, 3300, "idle");
+#else
+    dbg.error("sensor %u: %d mV, state %s", i, 3300, "idle");
+#endif
+}
+
+int main(int argc, char** argv) {
+    unsigned n = bench_iterations(argc, argv);
+
+    // dbg was constructed before main(); start the wire from here
+    mock_reset();
+    mock_capture = false;
+    mock_tick_base = 3723456U;      // 01:02:03.456
+
+    bench_header("C++ API");
+    for (int color = 0; color <= 1; color++) {
+        dbg.setColorEnabled(color);
+
+        dbg.setFilenameLineEnabled(false);
+        bench_row("log", color, bench_run(_log, n));
+        bench_row("logWithType", color, bench_run(_logWithType, n));
+        bench_row("info", color, bench_run(_info, n));
+        bench_row("error", color, bench_run(_error, n));
+        dbg.setFilenameLineEnabled(true);
+        bench_row("error, file:line", color, bench_run(_error, n));
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * @file        bench.h
+ * @brief       Measuring one log call: wall time per call, bytes sent per
+ *              call and peak stack. Shared by bench.c (C API) and bench.cpp
+ *              (C++ API), which run it on the port mocks with no wire time,
+ *              so the time is formatting and port handling alone. Where the
+ *              port is written from the call (blocking UART, MSPM0 FIFO) it
+ *              includes the mock driver's cost, a few ns per byte.
+ ******************************************************************************/
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "mock_port.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(USE_STM32_HAL)
+    #define BENCH_PLATFORM "STM32 HAL"
+#elif defined(USE_RA_FSP)
+    #define BENCH_PLATFORM "RA FSP"
+#elif defined(USE_TI_MSPM0_DL)
+    #define BENCH_PLATFORM "TI MSPM0 DL"
+#endif
+
+#define BENCH_STACK_LEN (64U * 1024U)
+#define BENCH_PAINT     0xA5U
+
+typedef void (*bench_call_t)(unsigned i);
+
+typedef struct {
+    double ns;          // per call
+    double bytes;       // per call
+    size_t stack;       // peak, bytes
+} bench_result_t;
+
+static inline uint64_t bench_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+static void bench_nop(unsigned i) {
+    (void)i;
+}
+
+// Each call is timed alone and the port is drained between calls, outside
+// the timed part. The cost of reading the clock is measured on an empty call
+// and taken off.
+static inline double bench_ns(bench_call_t call, unsigned n) {
+    uint64_t total = 0;
+    for (unsigned i = 0; i < n; i++) {
+        uint64_t t0 = bench_clock();
+        call(i);
+        total += bench_clock() - t0;
+        mock_flush();
+    }
+    return (double)total / n;
+}
+
+static bench_call_t _bench_stack_call;
+static unsigned char _bench_stack[BENCH_STACK_LEN] __attribute__((aligned(64)));
+
+static void* _benchStackRun(void* arg) {
+    (void)arg;
+    _bench_stack_call(0);
+    return NULL;
+}
+
+// Run one call on a painted thread stack and see how deep it wrote
+static inline size_t bench_stackUsed(bench_call_t call) {
+    memset(_bench_stack, BENCH_PAINT, sizeof(_bench_stack));
+    _bench_stack_call = call;
+
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, _bench_stack, sizeof(_bench_stack));
+    if (pthread_create(&thread, &attr, _benchStackRun, NULL) != 0) {
+        perror("pthread_create");
+        exit(1);
+    }
+    pthread_join(thread, NULL);
+    pthread_attr_destroy(&attr);
+    mock_flush();
+
+    size_t untouched = 0;
+    while (untouched < sizeof(_bench_stack) && _bench_stack[untouched] == BENCH_PAINT) untouched++;
+    return sizeof(_bench_stack) - untouched;
+}
+
+static inline bench_result_t bench_run(bench_call_t call, unsigned n) {
+    static double clock_ns = -1.0;
+    static size_t thread_stack = 0;
+    if (clock_ns < 0.0) {
+        clock_ns = bench_ns(bench_nop, n);
+        thread_stack = bench_stackUsed(bench_nop);
+    }
+
+    bench_result_t r;
+    call(0);                                // warm up: first-use setup, caches
+    mock_flush();
+
+    r.stack = bench_stackUsed(call) - thread_stack;
+
+    uint64_t bytes = mock_wire_bytes;
+    r.ns = bench_ns(call, n) - clock_ns;
+    r.bytes = (double)(mock_wire_bytes - bytes) / n;
+    if (r.ns < 0.0) r.ns = 0.0;
+    return r;
+}
+
+// --quick: a short run, for ctest
+static inline unsigned bench_iterations(int argc, char** argv) {
+    return (argc > 1 && strcmp(argv[1], "--quick") == 0) ? 2000U : 200000U;
+}
+
+#ifdef ED_BASELINE
+    #define BENCH_VARIANT " (baseline)"
+#else
+    #define BENCH_VARIANT ""
+#endif
+
+#if DEBUG_BUILTIN_PRINTF
+    #define BENCH_PRINTF ", built-in printf"
+#else
+    #define BENCH_PRINTF ""
+#endif
+
+static inline void bench_header(const char* api) {
+    printf("%s, %s%s%s\n", api, BENCH_PLATFORM, BENCH_PRINTF, BENCH_VARIANT);
+    printf("%-24s %-7s %10s %12s %9s\n", "call", "colors", "ns/call", "bytes/call", "stack B");
+}
+
+static inline void bench_row(const char* name, int color, bench_result_t r) {
+    printf("%-24s %-7s %10.1f %12.1f %9zu\n", name, color ? "on" : "off", r.ns, r.bytes, r.stack);
+    if (r.bytes <= 0.0) {
+        fprintf(stderr, "%s: nothing reached the port\n", name);
+        exit(1);
+    }
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * @file        check.h
+ * @brief       Assertions for the host tests: report the failing line and
+ *              exit non-zero, so ctest marks the test failed
+ ******************************************************************************/
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        unsigned long long _a = (unsigned long long)(a);                        \
+        unsigned long long _b = (unsigned long long)(b);                        \
+        if (_a != _b) {                                                         \
+            fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %llu != %llu\n",   \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                        \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_STR(a, b)                                                         \
+    do {                                                                        \
+        const char* _a = (a);                                                   \
+        const char* _b = (b);                                                   \
+        if (strcmp(_a, _b) != 0) {                                              \
+            fprintf(stderr, "%s:%d: CHECK_STR(%s, %s) failed:\n--- got\n%s\n--- expected\n%s\n", \
+                    __FILE__, __LINE__, #a, #b, _a, _b);                        \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+#endif
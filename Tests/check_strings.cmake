@@ -0,0 +1,19 @@
+# check_strings.cmake - which string literals a built executable holds
+#
+#   cmake -DFILE=<executable> -DABSENT=<prefix> -DPRESENT=<prefix> -P check_strings.cmake
+#
+# Fails if any string in FILE starts with ABSENT, or if none starts with
+# PRESENT. test_minlevel uses it to show that the format literals of the
+# calls below DEBUG_MIN_LEVEL are not in the program at all.
+
+file(STRINGS ${FILE} absent REGEX "${ABSENT}")
+file(STRINGS ${FILE} present REGEX "${PRESENT}")
+if(absent)
+    list(JOIN absent "\n  " absent)
+    message(FATAL_ERROR "${FILE} still holds:\n  ${absent}")
+endif()
+if(NOT present)
+    message(FATAL_ERROR "${FILE} holds no '${PRESENT}' string: the check sees nothing")
+endif()
+list(LENGTH present n)
+message(STATUS "${FILE}: no '${ABSENT}' string, ${n} '${PRESENT}'")
@@ -0,0 +1,27 @@
+/*******************************************************************************
+ * @file        mock_internal.h
+ * @brief       Between the shared part of the mocks (mock_port.c) and the
+ *              platform part (mock_stm32.c, mock_ra.c, mock_ti.c)
+ ******************************************************************************/
+
+#ifndef MOCK_INTERNAL_H
+#define MOCK_INTERNAL_H
+
+#include "mock_port.h"
+
+// Provided by the platform part
+uint64_t mock_portNext(void);       // virtual time of the next port event, UINT64_MAX: none
+void mock_portRun(void);            // run the events due at mock_now()
+bool mock_portIdle(void);
+void mock_portReset(void);
+void mock_portTime(uint64_t now);   // time moved on
+
+// Provided by mock_port.c. The lock guards the mock state only; the platform
+// part drops it before calling into the application (TX-complete interrupt).
+void mock_lock(void);
+void mock_unlock(void);
+void mock_setNow(uint64_t now);
+bool mock_xfer(uint32_t len);       // log a transfer request, false: refuse it busy
+void mock_land(const uint8_t* data, size_t len, uint64_t ns);
+
+#endif
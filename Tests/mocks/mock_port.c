@@ -0,0 +1,162 @@
+/*******************************************************************************
+ * @file        mock_port.c
+ * @brief       Shared part of the port mocks: wire capture, virtual time and
+ *              the core registers. See mock_port.h.
+ ******************************************************************************/
+
+#include "mock_internal.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The platform header, for the core registers (cmsis_core.h)
+#if defined(USE_STM32_HAL)
+    #include "main.h"
+#elif defined(USE_RA_FSP)
+    #include "hal_data.h"
+#elif defined(USE_TI_MSPM0_DL)
+    #include "ti_msp_dl_config.h"
+#endif
+
+char mock_wire[MOCK_WIRE_LEN + 1U];
+size_t mock_wire_len;
+uint64_t mock_wire_bytes;
+uint32_t mock_transfers;
+bool mock_capture = true;
+
+uint64_t mock_byte_ns;
+uint32_t mock_busy_every;
+bool mock_stalled;
+
+uint32_t mock_tick_base;
+uint32_t mock_ipsr;
+uint32_t mock_resets;
+jmp_buf* mock_reset_point;
+
+void (*mock_wire_hook)(const uint8_t* data, size_t len, uint64_t ns);
+
+uint32_t mock_xfer_len[MOCK_XFER_LOG];
+
+uint32_t SystemCoreClock = 168000000U;
+SysTick_Type mock_SysTick;
+SCB_Type mock_SCB;
+#if (STUB_CORE_M >= 3)
+DWT_Type mock_DWT;
+CoreDebug_Type mock_CoreDebug;
+#endif
+
+static uint64_t _now;               // virtual time, ns; __atomic
+static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t _wire_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+void mock_lock(void) {
+    pthread_mutex_lock(&_mutex);
+}
+
+void mock_unlock(void) {
+    pthread_mutex_unlock(&_mutex);
+}
+
+uint64_t mock_now(void) {
+    return __atomic_load_n(&_now, __ATOMIC_ACQUIRE);
+}
+
+// SysTick runs the 1 kHz tick, DWT counts core cycles; both follow the time
+static void _setTime(uint64_t now) {
+    __atomic_store_n(&_now, now, __ATOMIC_RELEASE);
+
+    uint32_t per_ms = SystemCoreClock / 1000U;
+    uint64_t cycles = now / 1000000000U * SystemCoreClock
+                    + now % 1000000000U * SystemCoreClock / 1000000000U;
+    SysTick->VAL = (per_ms - 1U) - (uint32_t)(cycles % per_ms);
+    #if (STUB_CORE_M >= 3)
+    DWT->CYCCNT = (uint32_t)cycles;
+    #endif
+
+    mock_portTime(now);
+}
+
+void mock_setNow(uint64_t now) {
+    if (now > mock_now()) _setTime(now);
+}
+
+bool mock_xfer(uint32_t len) {
+    uint32_t n = ++mock_transfers;
+    mock_xfer_len[(n - 1U) % MOCK_XFER_LOG] = len;
+    return mock_busy_every == 0U || n % mock_busy_every != 0U;
+}
+
+void mock_land(const uint8_t* data, size_t len, uint64_t ns) {
+    pthread_mutex_lock(&_wire_mutex);
+    mock_wire_bytes += len;
+    if (mock_capture && mock_wire_len < MOCK_WIRE_LEN) {
+        size_t n = len;
+        if (n > MOCK_WIRE_LEN - mock_wire_len) n = MOCK_WIRE_LEN - mock_wire_len;
+        memcpy(&mock_wire[mock_wire_len], data, n);
+        mock_wire_len += n;
+        mock_wire[mock_wire_len] = '\0';
+    }
+    pthread_mutex_unlock(&_wire_mutex);
+
+    if (mock_wire_hook != NULL) mock_wire_hook(data, len, ns);
+}
+
+void mock_reset(void) {
+    mock_lock();
+    mock_portReset();
+    mock_wire_len = 0;
+    mock_wire[0] = '\0';
+    mock_wire_bytes = 0;
+    mock_transfers = 0;
+    mock_capture = true;
+    mock_byte_ns = 0;
+    mock_busy_every = 0;
+    mock_stalled = false;
+    mock_tick_base = 0;
+    mock_ipsr = 0;
+    mock_resets = 0;
+    mock_reset_point = NULL;
+    mock_wire_hook = NULL;
+    mock_unlock();
+
+    SysTick->LOAD = SystemCoreClock / 1000U - 1U;
+    SysTick->CTRL = 0x7U;
+    _setTime(0);
+}
+
+void mock_advance(uint64_t ns) {
+    uint64_t until = mock_now() + ns;
+    for (;;) {
+        uint64_t t = mock_portNext();
+        if (t > until) break;
+        mock_setNow(t);
+        mock_portRun();
+    }
+    mock_setNow(until);
+}
+
+void mock_flush(void) {
+    for (;;) {
+        uint64_t t = mock_portNext();
+        if (t == UINT64_MAX) break;
+        mock_setNow(t);
+        mock_portRun();
+    }
+}
+
+bool mock_idle(void) {
+    return mock_portIdle();
+}
+
+uint32_t __get_IPSR(void) {
+    return mock_ipsr;
+}
+
+void NVIC_SystemReset(void) {
+    mock_resets++;
+    if (mock_reset_point != NULL) longjmp(*mock_reset_point, 1);
+    fprintf(stderr, "NVIC_SystemReset() with no mock_reset_point\n");
+    abort();
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * @file        mock_port.h
+ * @brief       Host mocks of the ElegantDebug ports: STM32 HAL UART and USB
+ *              CDC (mock_stm32.c), RA FSP r_sci_uart (mock_ra.c) and MSPM0
+ *              DriverLib UART (mock_ti.c). One is linked per executable.
+ *
+ *              Every byte that reaches the "wire" is counted and the first
+ *              MOCK_WIRE_LEN are kept. Time is virtual: blocking writes pass
+ *              it by the wire time of their bytes, transfers the driver runs
+ *              in the background (DMA, IT, USB, TX FIFO) finish when a test
+ *              lets time pass with mock_advance() or mock_flush(), which then
+ *              runs the TX-complete interrupt the application would get.
+ *
+ *              mock_stm32.c may be driven from several threads: one thread
+ *              advancing time as the "hardware", others logging.
+ ******************************************************************************/
+
+#ifndef MOCK_PORT_H
+#define MOCK_PORT_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_WIRE_LEN (1U << 20)
+
+extern char mock_wire[MOCK_WIRE_LEN + 1U];  // bytes on the wire, NUL-terminated
+extern size_t mock_wire_len;                // bytes kept in mock_wire
+extern uint64_t mock_wire_bytes;            // all bytes that reached the wire
+extern uint32_t mock_transfers;             // driver calls that moved bytes
+extern bool mock_capture;                   // false: only count (benchmarks)
+
+extern uint64_t mock_byte_ns;       // wire time of one byte, 0: no time
+extern uint32_t mock_busy_every;    // every Nth transfer request is refused busy, 0: none
+extern bool mock_stalled;           // the port takes nothing (UART owned elsewhere, USB unplugged)
+
+extern uint32_t mock_tick_base;     // ms tick at virtual time 0
+extern uint32_t mock_ipsr;          // __get_IPSR(), non-zero: "in an ISR"
+extern uint32_t mock_resets;        // NVIC_SystemReset() calls
+extern jmp_buf* mock_reset_point;   // where NVIC_SystemReset() longjmps to, NULL: abort
+
+// Called for each run of bytes reaching the wire, with the virtual time of
+// the first one. Runs in the thread that advanced time.
+extern void (*mock_wire_hook)(const uint8_t* data, size_t len, uint64_t ns);
+
+void mock_reset(void);              // clear the wire, counters, settings and time
+uint64_t mock_now(void);            // virtual time, ns
+void mock_advance(uint64_t ns);     // let ns pass: finish due transfers, run their interrupts
+void mock_flush(void);              // let time pass until the port is idle
+bool mock_idle(void);               // nothing in flight on the port
+
+// Length of transfer i (DMA/IT/USB/FSP write or FIFO fill) is
+// mock_xfer_len[i % MOCK_XFER_LOG], i < mock_transfers
+#define MOCK_XFER_LOG 256U
+extern uint32_t mock_xfer_len[MOCK_XFER_LOG];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * @file        mock_ra.c
+ * @brief       RA FSP r_sci_uart mock: g_uart0 on SCI channel 0. One write
+ *              can be in flight; it ends len * mock_byte_ns after it started
+ *              and then calls the instance callback with
+ *              UART_EVENT_TX_DATA_EMPTY and UART_EVENT_TX_COMPLETE.
+ *              The ms tick (_debug_tick_ms) follows the virtual time.
+ ******************************************************************************/
+
+#include "mock_internal.h"
+#include "hal_data.h"
+
+extern volatile uint32_t _debug_tick_ms;
+
+R_SCI0_Type mock_SCI0;
+sci_uart_instance_ctrl_t g_uart0_ctrl = { 1U, &g_uart0_cfg, &mock_SCI0 };
+const uart_cfg_t g_uart0_cfg = { 0U, user_uart_callback, NULL };
+static const uart_api_t _api;
+const uart_instance_t g_uart0 = { &g_uart0_ctrl, &g_uart0_cfg, &_api };
+
+static struct {
+    const uint8_t* data;
+    uint32_t len;
+    uint64_t end;
+    bool active;
+} _write;
+
+__attribute__((weak)) void user_uart_callback(uart_callback_args_t* p_args) {
+    (void)p_args;
+}
+
+fsp_err_t R_SCI_UART_Write(uart_ctrl_t* const p_api_ctrl, uint8_t const* const p_src, uint32_t const bytes) {
+    if (p_api_ctrl != &g_uart0_ctrl || g_uart0_ctrl.open == 0U) return -1;
+
+    mock_lock();
+    bool ok = !_write.active && !mock_stalled && mock_xfer(bytes);
+    if (ok) {
+        _write.data = p_src;
+        _write.len = bytes;
+        _write.end = mock_now() + bytes * mock_byte_ns;
+        _write.active = true;
+    }
+    mock_unlock();
+    return ok ? FSP_SUCCESS : FSP_ERR_IN_USE;
+}
+
+fsp_err_t R_SCI_UART_Close(uart_ctrl_t* const p_api_ctrl) {
+    if (p_api_ctrl != &g_uart0_ctrl) return -1;
+    g_uart0_ctrl.open = 0U;
+    return FSP_SUCCESS;
+}
+
+uint64_t mock_portNext(void) {
+    mock_lock();
+    uint64_t t = _write.active ? _write.end : UINT64_MAX;
+    mock_unlock();
+    return t;
+}
+
+void mock_portRun(void) {
+    mock_lock();
+    bool due = _write.active && _write.end <= mock_now();
+    if (due) _write.active = false;
+    mock_unlock();
+    if (!due) return;
+
+    mock_land(_write.data, _write.len, _write.end - _write.len * mock_byte_ns);
+
+    uart_callback_args_t args = { g_uart0_cfg.channel, UART_EVENT_TX_DATA_EMPTY, 0U, g_uart0_cfg.p_context };
+    g_uart0_cfg.p_callback(&args);
+    args.event = UART_EVENT_TX_COMPLETE;
+    g_uart0_cfg.p_callback(&args);
+}
+
+bool mock_portIdle(void) {
+    mock_lock();
+    bool idle = !_write.active;
+    mock_unlock();
+    return idle;
+}
+
+void mock_portReset(void) {
+    _write.active = false;
+    g_uart0_ctrl.open = 1U;
+    mock_SCI0.SSR = 0x84U;      // TDRE | TEND
+}
+
+void mock_portTime(uint64_t now) {
+    _debug_tick_ms = mock_tick_base + (uint32_t)(now / 1000000U);
+}
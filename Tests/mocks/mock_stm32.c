@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * @file        mock_stm32.c
+ * @brief       STM32 HAL UART (USART1, DMA linked) and USB CDC mocks. One
+ *              UART transfer and one USB transfer can be in flight; each ends
+ *              len * mock_byte_ns after it started and then runs
+ *              HAL_UART_TxCpltCallback() / CDC_TransmitCplt_FS().
+ ******************************************************************************/
+
+#include "mock_internal.h"
+#include "usart.h"
+#include "usbd_cdc_if.h"
+
+typedef struct {
+    const uint8_t* data;
+    uint32_t len;
+    uint64_t end;
+    bool active;
+} _xfer_t;
+
+USART_TypeDef mock_USART1;
+DMA_HandleTypeDef mock_hdma_usart1_tx;
+UART_HandleTypeDef huart1 = { &mock_USART1, &mock_hdma_usart1_tx };
+
+static _xfer_t _uart;
+static _xfer_t _cdc;
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    (void)huart;
+}
+
+__attribute__((weak)) int8_t CDC_TransmitCplt_FS(uint8_t* Buf, uint32_t* Len, uint8_t epnum) {
+    (void)Buf; (void)Len; (void)epnum;
+    return 0;
+}
+
+uint32_t HAL_GetTick(void) {
+    return mock_tick_base + (uint32_t)(mock_now() / 1000000U);
+}
+
+// Queue a background transfer, false: the port is busy
+static bool _start(_xfer_t* x, const uint8_t* data, uint32_t len) {
+    mock_lock();
+    bool ok = !x->active && !mock_stalled && mock_xfer(len);
+    if (ok) {
+        x->data = data;
+        x->len = len;
+        x->end = mock_now() + len * mock_byte_ns;
+        x->active = true;
+    }
+    mock_unlock();
+    return ok;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size, uint32_t Timeout) {
+    (void)Timeout;
+    if (huart != &huart1) return HAL_ERROR;
+
+    mock_lock();
+    bool ok = !_uart.active && !mock_stalled && mock_xfer(Size);
+    mock_unlock();
+    if (!ok) return HAL_BUSY;
+
+    uint64_t start = mock_now();
+    mock_land(pData, Size, start);
+    mock_setNow(start + Size * mock_byte_ns);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size) {
+    if (huart != &huart1 || huart->hdmatx == NULL) return HAL_ERROR;
+    return _start(&_uart, pData, Size) ? HAL_OK : HAL_BUSY;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size) {
+    if (huart != &huart1) return HAL_ERROR;
+    return _start(&_uart, pData, Size) ? HAL_OK : HAL_BUSY;
+}
+
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len) {
+    return _start(&_cdc, Buf, Len) ? USBD_OK : USBD_BUSY;
+}
+
+uint64_t mock_portNext(void) {
+    mock_lock();
+    uint64_t t = UINT64_MAX;
+    if (_uart.active) t = _uart.end;
+    if (_cdc.active && _cdc.end < t) t = _cdc.end;
+    mock_unlock();
+    return t;
+}
+
+// Take the transfer off the port if it is done. Its bytes land after the
+// lock is dropped but before the completion interrupt, so they are still
+// reserved in the caller's buffer.
+static bool _finish(_xfer_t* x, _xfer_t* done) {
+    mock_lock();
+    bool due = x->active && x->end <= mock_now();
+    if (due) {
+        *done = *x;
+        x->active = false;
+    }
+    mock_unlock();
+    if (due) mock_land(done->data, done->len, done->end - done->len * mock_byte_ns);
+    return due;
+}
+
+void mock_portRun(void) {
+    _xfer_t done;
+    if (_finish(&_uart, &done)) {
+        HAL_UART_TxCpltCallback(&huart1);
+    }
+    if (_finish(&_cdc, &done)) {
+        CDC_TransmitCplt_FS((uint8_t*)done.data, &done.len, 0x81U);
+    }
+}
+
+bool mock_portIdle(void) {
+    mock_lock();
+    bool idle = !_uart.active && !_cdc.active;
+    mock_unlock();
+    return idle;
+}
+
+void mock_portReset(void) {
+    _uart.active = false;
+    _cdc.active = false;
+    huart1.hdmatx = &mock_hdma_usart1_tx;
+    mock_USART1.SR = USART_SR_TXE | USART_SR_TC;
+    mock_USART1.CR3 = USART_CR3_DMAT;
+}
+
+void mock_portTime(uint64_t now) {
+    (void)now;
+}
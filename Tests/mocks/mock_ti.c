@@ -0,0 +1,136 @@
+/*******************************************************************************
+ * @file        mock_ti.c
+ * @brief       MSPM0 DriverLib UART mock: UART0 with a 4-byte TX FIFO in front
+ *              of the shift register. A byte leaves the FIFO when the shifter
+ *              is free and takes mock_byte_ns on the wire. The TX interrupt
+ *              is raised when the FIFO runs empty and taken, through
+ *              UART0_IRQHandler(), while DL_UART_INTERRUPT_TX is enabled.
+ *              Polling the FIFO or busy flag lets time pass up to the next
+ *              byte, as the CPU would spin. The ms tick (_debug_tick_ms)
+ *              follows the virtual time.
+ ******************************************************************************/
+
+#include "mock_internal.h"
+#include "ti_msp_dl_config.h"
+
+#define _FIFO_LEN 4U
+
+extern volatile uint32_t _debug_tick_ms;
+
+UART_Regs mock_UART0;
+
+static uint8_t _fifo[_FIFO_LEN];
+static uint32_t _fifo_n;
+static struct {
+    uint8_t byte;
+    uint64_t end;
+    bool active;
+} _shift;
+
+__attribute__((weak)) void UART0_IRQHandler(void) {
+    DL_UART_getPendingInterrupt(UART0);
+}
+
+static void _push(uint8_t data) {
+    _fifo[_fifo_n++] = data;
+}
+
+// Let time pass to the next port event, as a CPU polling the UART would
+static void _spin(void) {
+    uint64_t t = mock_portNext();
+    if (t == UINT64_MAX) return;
+    mock_setNow(t);
+    mock_portRun();
+}
+
+void DL_UART_transmitData(UART_Regs* uart, uint8_t data) {
+    if (uart != UART0 || _fifo_n == _FIFO_LEN) return;      // lost, as on the part
+    mock_xfer(1U);
+    _push(data);
+}
+
+void DL_UART_transmitDataBlocking(UART_Regs* uart, uint8_t data) {
+    while (_fifo_n == _FIFO_LEN && !mock_stalled) _spin();
+    DL_UART_transmitData(uart, data);
+}
+
+uint32_t DL_UART_fillTXFIFO(UART_Regs* uart, const uint8_t* buffer, uint32_t count) {
+    if (uart != UART0) return 0U;
+    uint32_t n = 0;
+    while (n < count && _fifo_n < _FIFO_LEN) _push(buffer[n++]);
+    if (n != 0U) mock_xfer(n);
+    return n;
+}
+
+bool DL_UART_isTXFIFOFull(const UART_Regs* uart) {
+    (void)uart;
+    if (_fifo_n == _FIFO_LEN) _spin();
+    return _fifo_n == _FIFO_LEN;
+}
+
+bool DL_UART_isBusy(const UART_Regs* uart) {
+    (void)uart;
+    if (_fifo_n != 0U || _shift.active) _spin();
+    return _fifo_n != 0U || _shift.active;
+}
+
+void DL_UART_enableInterrupt(UART_Regs* uart, uint32_t interruptMask) {
+    uart->IMASK |= interruptMask;
+}
+
+void DL_UART_disableInterrupt(UART_Regs* uart, uint32_t interruptMask) {
+    uart->IMASK &= ~interruptMask;
+}
+
+uint32_t DL_UART_getPendingInterrupt(const UART_Regs* uart) {
+    if (uart != UART0 || (mock_UART0.RIS & mock_UART0.IMASK & DL_UART_INTERRUPT_TX) == 0U) {
+        return DL_UART_IIDX_NO_INTERRUPT;
+    }
+    mock_UART0.RIS &= ~DL_UART_INTERRUPT_TX;
+    return DL_UART_IIDX_TX;
+}
+
+static bool _irqPending(void) {
+    return (mock_UART0.RIS & mock_UART0.IMASK & DL_UART_INTERRUPT_TX) != 0U;
+}
+
+uint64_t mock_portNext(void) {
+    if (_irqPending()) return mock_now();
+    if (_shift.active) return _shift.end;
+    if (_fifo_n != 0U && !mock_stalled) return mock_now();
+    return UINT64_MAX;
+}
+
+void mock_portRun(void) {
+    uint64_t now = mock_now();
+    for (;;) {
+        if (_shift.active && _shift.end <= now) {
+            _shift.active = false;
+            mock_land(&_shift.byte, 1U, _shift.end - mock_byte_ns);
+        }
+        if (_shift.active || _fifo_n == 0U || mock_stalled) break;
+
+        _shift.byte = _fifo[0];
+        _shift.end = now + mock_byte_ns;
+        _shift.active = true;
+        for (uint32_t i = 1; i < _fifo_n; i++) _fifo[i - 1U] = _fifo[i];
+        if (--_fifo_n == 0U) mock_UART0.RIS |= DL_UART_INTERRUPT_TX;
+    }
+
+    if (_irqPending()) UART0_IRQHandler();
+}
+
+bool mock_portIdle(void) {
+    return _fifo_n == 0U && !_shift.active;
+}
+
+void mock_portReset(void) {
+    _fifo_n = 0;
+    _shift.active = false;
+    mock_UART0.IMASK = 0;
+    mock_UART0.RIS = 0;
+}
+
+void mock_portTime(uint64_t now) {
+    _debug_tick_ms = mock_tick_base + (uint32_t)(now / 1000000U);
+}
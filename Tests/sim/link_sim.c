@@ -0,0 +1,231 @@
+/*******************************************************************************
+ * @file        link_sim.c
+ * @brief       UART/USB link simulator: runs workloads through the library
+ *              on a port mock that drains at a set bit rate in virtual time,
+ *              and reports per line the time from the log call to its last
+ *              byte leaving the wire (p50, p99, max), the throughput and the
+ *              lines dropped. Built once per backend; see CMakeLists.txt.
+ *
+ *              link_sim [--quick] [baud...]     (default 115200 921600)
+ *
+ *              Workloads, 10 bits per byte (8N1):
+ *                steady    one line every 5 ms
+ *                burst     40 lines back to back every 500 ms
+ *                burst80   80 lines back to back every 500 ms
+ *                flood     one line every 300 us
+ *                isr       steady, plus a 1 kHz timer ISR logging an error
+ *                          line on every 10th tick
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "mock_port.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #include "usbd_cdc_if.h"
+    #define SIM_PORT (&huart1)
+#elif defined(USE_RA_FSP)
+    #define SIM_PORT (&g_uart0)
+#elif defined(USE_TI_MSPM0_DL)
+    #define SIM_PORT UART_0_INST
+#endif
+
+#if DEBUG_TX_CDC_ENABLED
+    #define SIM_BACKEND "STM32 USB-CDC"
+#elif defined(USE_STM32_HAL) && DEBUG_TX_NONBLOCKING
+    #define SIM_BACKEND "STM32 UART DMA"
+#elif defined(USE_STM32_HAL)
+    #define SIM_BACKEND "STM32 UART blocking"
+#elif defined(USE_RA_FSP)
+    #define SIM_BACKEND "RA SCI UART"
+#elif DEBUG_TX_NONBLOCKING
+    #define SIM_BACKEND "MSPM0 UART TX FIFO"
+#else
+    #define SIM_BACKEND "MSPM0 UART blocking"
+#endif
+
+#define MAX_LINES 40000U
+#define MS        1000000ULL
+
+// The completion interrupts, forwarded as the README shows
+#if DEBUG_TX_CDC_ENABLED
+int8_t CDC_TransmitCplt_FS(uint8_t* Buf, uint32_t* Len, uint8_t epnum) {
+    (void)Buf; (void)Len; (void)epnum;
+    debug_cdcTxCpltCallback();
+    return USBD_OK;
+}
+#elif defined(USE_STM32_HAL) && DEBUG_TX_NONBLOCKING
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+#elif defined(USE_RA_FSP)
+void user_uart_callback(uart_callback_args_t* p_args) {
+    debug_txCpltCallback(p_args);
+}
+#elif defined(USE_TI_MSPM0_DL) && DEBUG_TX_NONBLOCKING
+void UART_0_INST_IRQHandler(void) {
+    if (DL_UART_getPendingInterrupt(UART_0_INST) == DL_UART_IIDX_TX) {
+        debug_txCpltCallback(UART_0_INST);
+    }
+}
+#endif
+
+typedef struct {
+    const char* name;
+    uint64_t period_ns;     // main loop
+    uint32_t burst;         // lines per period
+    uint64_t isr_ns;        // timer ISR line period, 0: none
+} sim_workload_t;
+
+static const sim_workload_t _workloads[] = {
+    { "steady", 5U * MS,     1U,  0U },
+    { "burst",  500U * MS,   40U, 0U },
+    { "burst80", 500U * MS,  80U, 0U },
+    { "flood",  300000U,     1U,  0U },
+    { "isr",    5U * MS,     1U,  10U * MS },
+};
+
+static uint64_t _logged_at[MAX_LINES];      // by line number
+static uint64_t _latency[MAX_LINES];
+static uint32_t _arrived;
+
+// Line being received: bytes so far, enough to read its number
+static char _rx[64];
+static size_t _rx_len;
+
+// Each byte leaves the wire mock_byte_ns after the one before it
+static void _onWire(const uint8_t* data, size_t len, uint64_t ns) {
+    for (size_t i = 0; i < len; i++) {
+        if (_rx_len < sizeof(_rx) - 1U) _rx[_rx_len++] = (char)data[i];
+        if (data[i] != '\n') continue;
+
+        _rx[_rx_len] = '\0';
+        _rx_len = 0;
+        unsigned long n;
+        if (sscanf(_rx, "[%*[A-Z]] #%lu ", &n) != 1 || n >= MAX_LINES) continue;   // drop report
+        _latency[_arrived++] = ns + (i + 1U) * mock_byte_ns - _logged_at[n];
+    }
+}
+
+static int _cmp(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double _ms(uint64_t ns) {
+    return (double)ns / 1e6;
+}
+
+// Blocking transmit drops nothing: the caller waits
+static uint32_t _dropped(void) {
+    uint32_t n = 0;
+#if DEBUG_TX_QUEUED
+    for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) n += debug_txDroppedLines(level);
+#endif
+    return n;
+}
+
+static void _run(const sim_workload_t* w, uint32_t baud, uint64_t duration) {
+    mock_reset();
+    mock_capture = false;
+    mock_byte_ns = 10U * 1000000000ULL / baud;
+    mock_wire_hook = _onWire;
+    _arrived = 0;
+    _rx_len = 0;
+
+    uint32_t dropped0 = _dropped();
+    uint32_t lines = 0;
+    uint64_t bytes = 0;
+    uint64_t next = 0;
+    uint64_t next_isr = w->isr_ns;
+    uint64_t end;
+    for (;;) {
+        bool isr = w->isr_ns != 0U && next_isr < next;
+        uint64_t t = isr ? next_isr : next;
+        if (t >= duration || lines == MAX_LINES) {
+            end = t < duration ? t : duration;
+            break;
+        }
+        if (t > mock_now()) mock_advance(t - mock_now());
+
+        // A blocking call returns late: the next line is logged as soon as
+        // it can, and counted from when it was due
+        _logged_at[lines] = t;
+        if (isr) {
+            mock_ipsr = 16U + 15U;      // SysTick
+            debug_error("#%lu tick\n", (unsigned long)lines);
+            mock_ipsr = 0U;
+            bytes += (uint64_t)snprintf(NULL, 0, "[ERROR] #%lu tick\n", (unsigned long)lines);
+            next_isr += w->isr_ns;
+        } else {
+            int v = 1000 + (int)(lines % 9000U);
+            debug_info("#%lu v=%d\n", (unsigned long)lines, v);
+            bytes += (uint64_t)snprintf(NULL, 0, "[INFO] #%lu v=%d\n", (unsigned long)lines, v);
+            if ((lines + 1U) % w->burst == 0U) next += w->period_ns;
+        }
+        lines++;
+    }
+    mock_flush();
+    uint64_t drained = mock_now();
+    uint32_t dropped = _dropped() - dropped0;
+
+    // Whatever drop report is pending goes out now, not in the next run
+    mock_wire_hook = NULL;
+    debug_log("\n");
+    mock_flush();
+
+    if (_arrived + dropped != lines) {
+        fprintf(stderr, "%s: %lu lines logged, %lu arrived, %lu counted as dropped\n", w->name,
+                (unsigned long)lines, (unsigned long)_arrived, (unsigned long)dropped);
+        exit(1);
+    }
+
+    qsort(_latency, _arrived, sizeof(_latency[0]), _cmp);
+    uint64_t p50 = _arrived ? _latency[_arrived / 2U] : 0U;
+    uint64_t p99 = _arrived ? _latency[_arrived * 99U / 100U] : 0U;
+    uint64_t max = _arrived ? _latency[_arrived - 1U] : 0U;
+    double offered = (double)bytes / ((double)end / 1e9) / 1000.0;
+    double sent = (double)mock_wire_bytes / ((double)drained / 1e9) / 1000.0;
+    printf("%-8s %7lu %9.1f %9.1f %9.1f %9.1f %9.1f %7.1f%%\n", w->name, (unsigned long)baud,
+           offered, sent, _ms(p50), _ms(p99), _ms(max),
+           lines ? 100.0 * dropped / lines : 0.0);
+}
+
+int main(int argc, char** argv) {
+    uint64_t duration = 10000U * MS;
+    uint32_t bauds[8];
+    int n = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            duration = 1000U * MS;
+        } else if (n < 8) {
+            bauds[n++] = (uint32_t)strtoul(argv[i], NULL, 10);
+        }
+    }
+    if (n == 0) {
+        bauds[n++] = 115200U;
+        bauds[n++] = 921600U;
+    }
+
+    mock_reset();
+    debug_init(SIM_PORT, false, false, false);
+
+#if DEBUG_TX_QUEUED
+    printf("%s, %u-byte ring\n", SIM_BACKEND, (unsigned)DEBUG_TX_RING_LEN);
+#else
+    printf("%s\n", SIM_BACKEND);
+#endif
+    printf("%-8s %7s %9s %9s %9s %9s %9s %8s\n",
+           "workload", "baud", "in kB/s", "out kB/s", "p50 ms", "p99 ms", "max ms", "dropped");
+    for (int b = 0; b < n; b++) {
+        for (size_t i = 0; i < sizeof(_workloads) / sizeof(_workloads[0]); i++) {
+            _run(&_workloads[i], bauds[b], duration);
+        }
+    }
+    return 0;
+}
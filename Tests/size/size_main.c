@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * @file        size_main.c
+ * @brief       Smallest STM32 program that logs integers, strings and (with
+ *              SIZE_FLOAT) floats, linked for Cortex-M4 to compare firmware
+ *              size with vsnprintf() and with the built-in printf engine.
+ *              The HAL and core registers are stubs: only the size matters.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "usart.h"
+
+uint32_t SystemCoreClock = 168000000U;
+SysTick_Type mock_SysTick;
+SCB_Type mock_SCB;
+DWT_Type mock_DWT;
+CoreDebug_Type mock_CoreDebug;
+USART_TypeDef mock_USART1;
+UART_HandleTypeDef huart1 = { &mock_USART1, NULL };
+
+static volatile uint32_t _sink;
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size, uint32_t Timeout) {
+    (void)huart; (void)Timeout;
+    for (uint16_t i = 0; i < Size; i++) _sink = pData[i];
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size) {
+    return HAL_UART_Transmit(huart, pData, Size, 0U);
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size) {
+    return HAL_UART_Transmit(huart, pData, Size, 0U);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    (void)huart;
+}
+
+uint32_t HAL_GetTick(void) {
+    return _sink;
+}
+
+uint32_t __get_IPSR(void) {
+    return 0U;
+}
+
+void NVIC_SystemReset(void) {
+    for (;;) {}
+}
+
+int main(void) {
+    debug_init(&huart1, true, true, true);
+    debug_info("boot %d, %s, 0x%08lx", 3, "ok", (unsigned long)_sink);
+    debug_error("code %u", (unsigned)_sink);
+#if SIZE_FLOAT
+    debug_log("%.2f V\n", (double)_sink * 0.001);
+#endif
+    for (;;) {}
+}
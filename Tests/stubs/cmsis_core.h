@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * @file        cmsis_core.h
+ * @brief       Host stand-in for the CMSIS core registers and intrinsics that
+ *              ElegantDebug touches. The registers are plain structs, kept in
+ *              step with the virtual time of the mocks (mocks/mock_port.c).
+ *
+ *              Included by the platform stubs, which set STUB_CORE_M first:
+ *              0 for Cortex-M0/M0+ (no DWT, no fault status registers), 3 and
+ *              up for cores that have them.
+ ******************************************************************************/
+
+#ifndef STUB_CMSIS_CORE_H
+#define STUB_CMSIS_CORE_H
+
+#include <stdint.h>
+
+#ifndef STUB_CORE_M
+    #error "Set STUB_CORE_M before including cmsis_core.h"
+#endif
+
+#define __CORTEX_M (STUB_CORE_M)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint32_t SystemCoreClock;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t LOAD;
+    volatile uint32_t VAL;
+    volatile uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+    volatile uint32_t CPUID;
+    volatile uint32_t ICSR;
+    volatile uint32_t VTOR;
+    volatile uint32_t AIRCR;
+    volatile uint32_t SCR;
+    volatile uint32_t CCR;
+    volatile uint8_t  SHP[12];
+    volatile uint32_t SHCSR;
+    volatile uint32_t CFSR;
+    volatile uint32_t HFSR;
+    volatile uint32_t DFSR;
+    volatile uint32_t MMFAR;
+    volatile uint32_t BFAR;
+    volatile uint32_t AFSR;
+} SCB_Type;
+
+extern SysTick_Type mock_SysTick;
+extern SCB_Type mock_SCB;
+#define SysTick (&mock_SysTick)
+#define SCB     (&mock_SCB)
+
+#define SCB_ICSR_PENDSTSET_Msk (1UL << 26)
+
+#if (STUB_CORE_M >= 3)
+#define SCB_CFSR_USGFAULTSR_Pos 16U
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t DHCSR;
+    volatile uint32_t DCRSR;
+    volatile uint32_t DCRDR;
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+extern DWT_Type mock_DWT;
+extern CoreDebug_Type mock_CoreDebug;
+#define DWT       (&mock_DWT)
+#define CoreDebug (&mock_CoreDebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk      (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1UL << 24)
+#endif
+
+// Interrupts never preempt host code; the library's host builds take a
+// spinlock instead of masking them (see Atomics in ElegantDebug.c)
+static inline uint32_t __get_PRIMASK(void) { return 0U; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) {}
+static inline void __enable_irq(void) {}
+static inline void __DMB(void) {}
+
+// Active exception number, mock_ipsr; non-zero makes the caller an "ISR"
+uint32_t __get_IPSR(void);
+
+// Longjmps to mock_reset_point when a test set one, else aborts
+void NVIC_SystemReset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
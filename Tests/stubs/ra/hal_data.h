@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * @file        hal_data.h
+ * @brief       Host stand-in for the FSP-generated hal_data.h: the r_sci_uart
+ *              driver API ElegantDebug uses and one configured instance,
+ *              g_uart0 (channel 0, callback user_uart_callback), on an RA6M5
+ *              (Cortex-M33). Implemented by mocks/mock_ra.c.
+ ******************************************************************************/
+
+#ifndef HAL_DATA_H_
+#define HAL_DATA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STUB_CORE_M 33
+#include "cmsis_core.h"
+
+#define R_SCI_UART_H                // driver check in ElegantDebug.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int fsp_err_t;
+#define FSP_SUCCESS     0
+#define FSP_ERR_IN_USE  2
+
+typedef enum {
+    UART_EVENT_RX_COMPLETE   = (1UL << 0),
+    UART_EVENT_TX_COMPLETE   = (1UL << 1),
+    UART_EVENT_TX_DATA_EMPTY = (1UL << 9),
+} uart_event_t;
+
+typedef struct st_uart_callback_arg {
+    uint32_t channel;
+    uart_event_t event;
+    uint32_t data;
+    void const* p_context;
+} uart_callback_args_t;
+
+typedef void uart_ctrl_t;
+
+typedef struct st_uart_cfg {
+    uint8_t channel;
+    void (*p_callback)(uart_callback_args_t* p_args);
+    void const* p_context;
+} uart_cfg_t;
+
+typedef struct st_uart_api {
+    int unused;
+} uart_api_t;
+
+typedef struct st_uart_instance {
+    uart_ctrl_t* p_ctrl;
+    uart_cfg_t const* p_cfg;
+    uart_api_t const* p_api;
+} uart_instance_t;
+
+// SCI registers, the bits the panic path polls
+typedef struct {
+    volatile uint8_t TDR;
+    union {
+        volatile uint8_t SSR;
+        struct {
+            volatile uint8_t : 2;
+            volatile uint8_t TEND : 1;
+            volatile uint8_t : 4;
+            volatile uint8_t TDRE : 1;
+        } SSR_b;
+    };
+    union {
+        volatile uint8_t SCR;
+        struct {
+            volatile uint8_t : 7;
+            volatile uint8_t TIE : 1;
+        } SCR_b;
+    };
+} R_SCI0_Type;
+
+typedef struct st_sci_uart_instance_ctrl {
+    uint32_t open;
+    uart_cfg_t const* p_cfg;
+    R_SCI0_Type* p_reg;
+} sci_uart_instance_ctrl_t;
+
+fsp_err_t R_SCI_UART_Write(uart_ctrl_t* const p_api_ctrl, uint8_t const* const p_src, uint32_t const bytes);
+fsp_err_t R_SCI_UART_Close(uart_ctrl_t* const p_api_ctrl);
+
+extern sci_uart_instance_ctrl_t g_uart0_ctrl;
+extern const uart_cfg_t g_uart0_cfg;
+extern const uart_instance_t g_uart0;
+
+// Weak in the mock; a test overrides it like an application
+void user_uart_callback(uart_callback_args_t* p_args);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
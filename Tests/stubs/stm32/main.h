@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * @file        main.h
+ * @brief       Host stand-in for the CubeMX-generated main.h: the parts of the
+ *              STM32 HAL that ElegantDebug uses (UART blocking/DMA/IT
+ *              transmit, tick) on an STM32F4 (Cortex-M4). Implemented by
+ *              mocks/mock_stm32.c.
+ ******************************************************************************/
+
+#ifndef MAIN_H
+#define MAIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STUB_CORE_M 4
+#include "cmsis_core.h"
+
+#define __STM32F4xx_HAL_H           // family check in ElegantDebug.h
+#define HAL_UART_MODULE_ENABLED
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+// USART registers, F4 layout (SR/DR)
+typedef struct {
+    volatile uint32_t SR;
+    volatile uint32_t DR;
+    volatile uint32_t BRR;
+    volatile uint32_t CR1;
+    volatile uint32_t CR2;
+    volatile uint32_t CR3;
+    volatile uint32_t GTPR;
+} USART_TypeDef;
+
+#define USART_SR_TC     (1U << 6)
+#define USART_SR_TXE    (1U << 7)
+#define USART_CR3_DMAT  (1U << 7)
+
+typedef struct {
+    void* Instance;
+} DMA_HandleTypeDef;
+
+typedef struct __UART_HandleTypeDef {
+    USART_TypeDef* Instance;
+    DMA_HandleTypeDef* hdmatx;      // NULL when no DMA channel is linked
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Transmit_IT(UART_HandleTypeDef* huart, const uint8_t* pData, uint16_t Size);
+
+// Weak in the HAL and in the mock; a test overrides it like an application
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart);
+
+uint32_t HAL_GetTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
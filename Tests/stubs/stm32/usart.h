@@ -0,0 +1,21 @@
+/*******************************************************************************
+ * @file        usart.h
+ * @brief       Host stand-in for the CubeMX-generated usart.h
+ ******************************************************************************/
+
+#ifndef USART_H
+#define USART_H
+
+#include "main.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern UART_HandleTypeDef huart1;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
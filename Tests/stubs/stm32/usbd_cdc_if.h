@@ -0,0 +1,30 @@
+/*******************************************************************************
+ * @file        usbd_cdc_if.h
+ * @brief       Host stand-in for the CubeMX-generated USB-CDC interface.
+ *              CDC_Transmit_FS() is mocked in mocks/mock_stm32.c.
+ ******************************************************************************/
+
+#ifndef USBD_CDC_IF_H
+#define USBD_CDC_IF_H
+
+#include <stdint.h>
+
+#define USBD_OK     0U
+#define USBD_BUSY   1U
+#define USBD_FAIL   3U
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
+
+// Static in the generated usbd_cdc_if.c. Here it is weak: the mock calls it
+// when a transfer completes and a test overrides it like an application.
+int8_t CDC_TransmitCplt_FS(uint8_t* Buf, uint32_t* Len, uint8_t epnum);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
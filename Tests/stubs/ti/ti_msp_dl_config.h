@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * @file        ti_msp_dl_config.h
+ * @brief       Host stand-in for the SysConfig-generated ti_msp_dl_config.h:
+ *              the DriverLib UART calls ElegantDebug uses and one instance,
+ *              UART_0_INST, on an MSPM0G3507 (Cortex-M0+). The UART has the
+ *              4-byte TX FIFO of the real part; see mocks/mock_ti.c.
+ *
+ *              Define STUB_CORE_M to 3 or more to build as a core with fault
+ *              status registers, which the panic test uses to cover them.
+ ******************************************************************************/
+
+#ifndef ti_msp_dl_config_h
+#define ti_msp_dl_config_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef STUB_CORE_M
+#define STUB_CORE_M 0
+#endif
+#include "cmsis_core.h"
+
+#define DL_UART_Main_init DL_UART_init     // driver check in ElegantDebug.h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    volatile uint32_t TXDATA;
+    volatile uint32_t STAT;
+    volatile uint32_t IMASK;
+    volatile uint32_t RIS;
+} UART_Regs;
+
+extern UART_Regs mock_UART0;
+#define UART0 (&mock_UART0)
+
+#define UART_0_INST                 UART0
+#define UART_0_INST_IRQHandler      UART0_IRQHandler
+
+#define DL_UART_INTERRUPT_TX        (1U << 11)
+#define DL_UART_IIDX_NO_INTERRUPT   0U
+#define DL_UART_IIDX_TX             12U
+
+void DL_UART_transmitData(UART_Regs* uart, uint8_t data);
+void DL_UART_transmitDataBlocking(UART_Regs* uart, uint8_t data);
+uint32_t DL_UART_fillTXFIFO(UART_Regs* uart, const uint8_t* buffer, uint32_t count);
+bool DL_UART_isTXFIFOFull(const UART_Regs* uart);
+bool DL_UART_isBusy(const UART_Regs* uart);
+void DL_UART_enableInterrupt(UART_Regs* uart, uint32_t interruptMask);
+void DL_UART_disableInterrupt(UART_Regs* uart, uint32_t interruptMask);
+uint32_t DL_UART_getPendingInterrupt(const UART_Regs* uart);
+
+// Weak in the mock; a test overrides it like an application
+void UART0_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * @file        test_binary.c
+ * @brief       The same calls built in text mode and in DEBUG_BINARY_MODE.
+ *              Each build writes what reached the wire to the file given on
+ *              the command line; test_binary.py decodes the binary capture
+ *              with Tools/ed_decode.py against this executable's
+ *              `.elegant_debug_fmt` section and compares it with the text
+ *              capture, byte for byte.
+ *
+ *              With MISMATCH defined, the binary build also logs arguments
+ *              whose C type does not match their conversion, which the
+ *              decoder must report instead of rendering.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define MOD_ADC 1
+
+static void _calls(void) {
+    long long big = -1234567890123LL;
+    unsigned long long ubig = 18446744073709551615ULL;
+    const char* s = "text";
+
+    debug_log("plain %d %u %x %X %o %c %%\n", -42, 42U, 0xBEEFU, 0xBEEFU, 8U, 'z');
+    debug_info("long long %lld %llu %llx\n", big, ubig, 0x123456789ABCULL);
+    debug_ok("long %ld %lu\n", -7L, 7UL);
+    debug_success("float %f %.2f %e %g %.3f\n", 3.14159, -2.5, 12345.678, 0.0001, (double)1.5f);
+    debug_warning("string '%s' '%10s' '%-6s|' '%.2s'\n", s, s, s, s);
+    debug_error("width %*d|%-*d|%.*f\n", 6, 42, 5, -3, 2, 2.71828);
+    debug_info("short %hd %hhu char %c\n", (short)-3, (unsigned char)250, 'A');
+    debug_logWithType("BOOT", "\033[95m", "stage %d of %d\n", 2, 3);
+    debug_info("no arguments\n");
+
+    debug_moduleRegister(MOD_ADC, "adc", DEBUG_LEVEL_LOG);
+    debug_moduleInfo(MOD_ADC, "channel %d = %ld mV\n", 3, 1650L);
+    debug_moduleWarning(MOD_ADC, "overrun on %s\n", "dma");
+    debug_moduleError(MOD_ADC, "%d errors\n", 5);
+
+    for (int i = 0; i < 7; i++) {
+        debug_everyN(INFO, 3, "every third %d\n", i);
+    }
+    for (int i = 0; i < 3; i++) {
+        debug_everyN(ERROR, 2, "error every second %d\n", i);
+    }
+
+    uint8_t data[40];
+    uint8_t prev[40];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 7U + 0x1BU);
+        prev[i] = data[i];
+    }
+    prev[3] ^= 1U;
+    prev[4] ^= 1U;
+    prev[17] ^= 1U;
+    debug_hexdump(data, 20, NULL);
+    debug_hexdump(data, sizeof(data), prev);
+}
+
+int main(int argc, char** argv) {
+    CHECK(argc == 2);
+    mock_reset();
+    mock_tick_base = 3723004U;      // 01:02:03.004
+
+    for (int pass = 0; pass < 4; pass++) {
+        bool color = (pass & 1) != 0;
+        bool fileline = (pass & 2) != 0;
+        debug_init(&huart1, pass != 0, color, fileline);
+        _calls();
+    }
+    // past 64 KB the offsets have 8 digits
+    static uint8_t wide[0x10000 + 20];
+    for (size_t i = 0; i < sizeof(wide); i++) wide[i] = (uint8_t)(i ^ (i >> 8));
+    debug_hexdump(wide, sizeof(wide), NULL);
+#if defined(MISMATCH) && DEBUG_BINARY_MODE
+    debug_init(&huart1, false, false, false);
+    debug_info("int as long long %d\n", 5LL);
+    debug_info("int as double %f\n", 5);
+    debug_info("two for one %d %d\n", 5);
+#endif
+
+    FILE* f = fopen(argv[1], "wb");
+    CHECK(f != NULL);
+    CHECK(fwrite(mock_wire, 1, mock_wire_len, f) == mock_wire_len);
+    fclose(f);
+    printf("%s mode: %lu bytes written to %s\n", DEBUG_BINARY_MODE ? "binary" : "text",
+           (unsigned long)mock_wire_len, argv[1]);
+    return 0;
+}
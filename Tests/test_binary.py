@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+test_binary.py - binary records decoded back into the text mode's lines.
+
+    test_binary.py <text executable> <binary executable> <work dir>
+
+Both executables are test_binary.c, built in text mode and in
+DEBUG_BINARY_MODE (the latter with MISMATCH and without PIE, so the format
+addresses in the records are those of the ELF section). Each writes its
+wire to a file; the binary one is decoded with Tools/ed_decode.py and must
+give the text one byte for byte, followed by one report per record whose
+arguments do not match their format.
+"""
+
+import ctypes
+import io
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Tools"))
+import ed_decode  # noqa: E402
+
+
+def capture(exe, path):
+    subprocess.run([exe, path], check=True)
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def main():
+    text_exe, bin_exe, work = sys.argv[1:4]
+    text = capture(text_exe, os.path.join(work, "test_binary_text.out")).decode()
+    records = capture(bin_exe, os.path.join(work, "test_binary_bin.out"))
+
+    base, blob = ed_decode.load_formats(bin_exe)
+    out = io.StringIO()
+    dec = ed_decode.Decoder(base, blob, out, ctypes.sizeof(ctypes.c_long))
+    for i in range(0, len(records), 7):     # in pieces, as a serial port delivers them
+        dec.feed(records[i:i + 7])
+    decoded = out.getvalue()
+
+    mismatches = [
+        "[INFO] <arguments do not match 'int as long long %d\\n': it reads 4 bytes, the record has 8>\n",
+        "[INFO] <arguments do not match 'int as double %f\\n': it reads 8 bytes, the record has 4>\n",
+        "[INFO] <arguments do not match 'two for one %d %d\\n': it reads 8 bytes, the record has 4>\n",
+    ]
+    expected = text + "".join(mismatches)
+    if decoded != expected:
+        a, b = decoded.splitlines(True), expected.splitlines(True)
+        for i, (x, y) in enumerate(zip(a, b)):
+            if x != y:
+                print("line %d differs:\n  decoded:  %r\n  expected: %r" % (i + 1, x, y))
+                break
+        else:
+            print("decoded %d lines, expected %d" % (len(a), len(b)))
+        sys.exit(1)
+
+    print("binary mode: %d bytes of records decoded into the %d bytes of text mode, %d mismatches reported"
+          % (len(records), len(text), len(mismatches)))
+
+
+if __name__ == "__main__":
+    main()
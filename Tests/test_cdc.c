@@ -0,0 +1,144 @@
+/*******************************************************************************
+ * @file        test_cdc.c
+ * @brief       USB-CDC port (USB_AS_DEBUG_PORT): lines logged while a USB
+ *              transfer runs are queued, not lost; a busy endpoint is
+ *              retried; queued lines go out as whole 64-byte packets; with
+ *              the cable unplugged the ring fills and the lines that did not
+ *              fit are counted and reported.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usbd_cdc_if.h"
+
+#define BYTE_NS 1000U
+#define LINES   200
+
+static bool _chain = true;
+
+// The application's usbd_cdc_if.c
+int8_t CDC_TransmitCplt_FS(uint8_t* Buf, uint32_t* Len, uint8_t epnum) {
+    (void)Buf; (void)Len; (void)epnum;
+    if (_chain) debug_cdcTxCpltCallback();
+    return USBD_OK;
+}
+
+static char _expected[LINES * 64];
+
+static void _log(int i) {
+    debug_info("usb %d: %.*s\n", i, i % 37, "0123456789abcdefghijklmnopqrstuvwxyz");
+}
+
+// LINES lines, `every` back to back then `gap_ns` of time; returns what
+// the wire should show
+static const char* _burst(int every, uint64_t gap_ns) {
+    size_t n = 0;
+    for (int i = 0; i < LINES; i++) {
+        _log(i);
+        n += (size_t)snprintf(&_expected[n], sizeof(_expected) - n, "[INFO] usb %d: %.*s\n",
+                              i, i % 37, "0123456789abcdefghijklmnopqrstuvwxyz");
+        if ((i + 1) % every == 0) mock_advance(gap_ns);
+    }
+    mock_flush();
+    return _expected;
+}
+
+// Whole packets, or a short one when less was queued
+static void _checkPackets(void) {
+    uint32_t n = mock_transfers < MOCK_XFER_LOG ? mock_transfers : MOCK_XFER_LOG;
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK(mock_xfer_len[i] % DEBUG_CDC_PACKET_LEN == 0U || mock_xfer_len[i] < DEBUG_CDC_PACKET_LEN);
+    }
+}
+
+static void _setup(bool chain) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    _chain = chain;
+}
+
+int main(void) {
+    debug_init(NULL, false, false, false);
+
+    // Bursts of 10 lines logged while the first one is being sent, every
+    // third transfer refused busy: none is lost, and they are packed into
+    // fewer transfers
+    _setup(true);
+    mock_busy_every = 3U;
+    const char* expected = _burst(10, 2000U * BYTE_NS);
+    size_t sent = strlen(mock_wire);
+    CHECK(strncmp(mock_wire, expected, sent) == 0);
+    CHECK_EQ(debug_txDropped(), 0U);
+    _checkPackets();
+    uint32_t transfers = mock_transfers;
+
+    // What a refused transfer left queued goes out with the next line
+    mock_busy_every = 0U;
+    debug_info("done\n");
+    mock_flush();
+    CHECK_EQ(mock_wire_len, strlen(expected) + strlen("[INFO] done\n"));
+    CHECK(strncmp(mock_wire, expected, strlen(expected)) == 0);
+    CHECK_STR(&mock_wire[strlen(expected)], "[INFO] done\n");
+    CHECK(transfers < LINES / 2);
+    printf("%d lines in %lu USB transfers (every 3rd refused busy)\n", LINES, (unsigned long)transfers);
+
+    // Without the completion callback the queue moves on the next line: the
+    // remainder short of a whole packet waits for it
+    _setup(false);
+    expected = _burst(1, 200U * BYTE_NS);
+    sent = strlen(mock_wire);
+    CHECK(strncmp(mock_wire, expected, sent) == 0);
+    CHECK(strlen(expected) - sent < DEBUG_CDC_PACKET_LEN);
+    CHECK_EQ(debug_txDropped(), 0U);
+    _checkPackets();
+    _chain = true;
+    debug_cdcTxCpltCallback();
+    mock_flush();
+    CHECK_STR(mock_wire, expected);
+
+    // Unplugged: the ring fills, the rest is dropped and counted. Plugged
+    // back, the next line restarts the transfers and the one after it
+    // reports the loss first.
+    _setup(true);
+    mock_stalled = true;
+    expected = _burst(LINES, 0U);
+    CHECK_EQ(mock_wire_len, 0U);
+    uint32_t dropped = debug_txDroppedLines(DEBUG_LEVEL_INFO);
+    CHECK(dropped > 0U);
+
+    // Each line that still fits is kept, also a short one after a longer
+    // one was dropped
+    static char kept[DEBUG_TX_RING_LEN + 128];
+    size_t room = DEBUG_TX_RING_LEN, lost = 0;
+    uint32_t fit = 0;
+    for (const char* p = expected; *p != '\0'; ) {
+        size_t len = (size_t)(strchr(p, '\n') + 1 - p);
+        if (len <= room) {
+            memcpy(&kept[DEBUG_TX_RING_LEN - room], p, len);
+            room -= len;
+            fit++;
+        } else {
+            lost += len;
+        }
+        p += len;
+    }
+    CHECK_EQ(dropped, LINES - fit);
+    CHECK_EQ(debug_txDropped(), lost);
+
+    mock_stalled = false;
+    debug_info("plugged\n");        // no room yet: dropped, restarts the queue
+    mock_flush();
+    debug_info("back\n");
+    mock_flush();
+
+    char tail[128];
+    snprintf(tail, sizeof(tail), "[WARNING] %lu lines dropped (%lu info)\n[INFO] back\n",
+             (unsigned long)(dropped + 1U), (unsigned long)(dropped + 1U));
+    strcat(kept, tail);
+    CHECK_STR(mock_wire, kept);
+    _checkPackets();
+
+    printf("USB-CDC queue: no line lost while the endpoint is busy\n");
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*******************************************************************************
+ * @file        test_clock.c
+ * @brief       Timestamps from a clock installed with debug_setClockSource()
+ *              (a fake counter the test sets), and from the built-in sources
+ *              driven by virtual time: DWT->CYCCNT on STM32 (Cortex-M4, also
+ *              at core clocks that are not a whole number of MHz) and
+ *              HAL tick + SysTick->VAL on STM32 (DEBUG_CLOCK_SYSTICK) and
+ *              MSPM0 (Cortex-M0+, no cycle counter).
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #define TEST_PORT (&huart1)
+#elif defined(USE_TI_MSPM0_DL)
+    #define TEST_PORT UART_0_INST
+#endif
+
+#define TICK_BASE 3723456U      // ms tick at virtual time 0: 01:02:03.456
+
+static uint64_t _fake_us;
+
+static uint64_t _fake(void) {
+    return _fake_us;
+}
+
+// Timestamp of the next line, in microseconds. Checks the text after it.
+static uint64_t _stamp(void) {
+    size_t at = mock_wire_len;
+    debug_log("t\n");
+    mock_flush();
+
+    unsigned long h, m, s, frac;
+    int n = 0;
+    CHECK(sscanf(&mock_wire[at], "[%lu:%2lu:%2lu.%lu] %n", &h, &m, &s, &frac, &n) == 4 && n > 0);
+    CHECK_STR(&mock_wire[at + (size_t)n], "t\n");
+    CHECK(m < 60U && s < 60U);
+
+    size_t digits = (size_t)n - 2U - (size_t)(strchr(&mock_wire[at], '.') - &mock_wire[at]) - 1U;
+#if DEBUG_TIMESTAMP_US
+    CHECK_EQ(digits, 6U);
+    return ((h * 60U + m) * 60U + s) * 1000000ULL + frac;
+#else
+    CHECK_EQ(digits, 3U);
+    return (((h * 60U + m) * 60U + s) * 1000U + frac) * 1000ULL;
+#endif
+}
+
+// What a timestamp shows for us microseconds
+static uint64_t _shown(uint64_t us) {
+#if DEBUG_TIMESTAMP_US
+    return us;
+#else
+    return us / 1000U * 1000U;
+#endif
+}
+
+static void _fakeClock(void) {
+    static const uint64_t jumps[] = {
+        0U, 1U, 999999U, 1000000U, 59999999U, 60000000U,
+        3599999999ULL, 3600000000ULL,           // hour
+        360000123456ULL,                        // 100 h: three hour digits
+        5000000U,                               // clock went back
+        66000001U,                              // a gap over a minute
+    };
+
+    debug_setClockSource(_fake);
+    for (size_t i = 0; i < sizeof(jumps) / sizeof(jumps[0]); i++) {
+        _fake_us = jumps[i];
+        CHECK_EQ(_stamp(), _shown(_fake_us));
+    }
+
+    // Small steps: the rendered second is stepped forward, not recomputed
+    _fake_us = 0;
+    for (int i = 0; i < 400; i++) {
+        _fake_us += 777777U;
+        CHECK_EQ(_stamp(), _shown(_fake_us));
+        CHECK_EQ(_stamp(), _shown(_fake_us));   // same time: cached text
+    }
+    debug_setClockSource(NULL);
+}
+
+#if DEBUG_TIMESTAMP_US
+static uint64_t _virtualUs(void) {
+    return TICK_BASE * 1000ULL + mock_now() / 1000U;
+}
+
+#if (DEBUG_CLOCK_USED == DEBUG_CLOCK_DWT)
+// CYCCNT (168 MHz) wraps every 25.6 s; steps under half of that are exact
+static void _hardwareClock(void) {
+    CHECK_EQ(_stamp(), _virtualUs());
+    CHECK(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk);
+    CHECK(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk);
+
+    for (uint32_t i = 0; i < 200U; i++) {
+        mock_advance((uint64_t)(i * 7919U % 1000U) * 1000003U + 333U);
+        CHECK_EQ(_stamp(), _virtualUs());
+    }
+
+    // Nothing logged for longer than half a wrap: restarts from the ms tick
+    mock_advance(20000000000ULL + 500000U);
+    CHECK_EQ(_stamp(), _virtualUs() / 1000U * 1000U);
+
+    // Core clocks that are not a whole number of MHz, or under 1 MHz: the
+    // change of SystemCoreClock restarts the count, which then stays within
+    // a cycle of the virtual time however long it runs
+    static const uint32_t clocks[] = { 2097000U, 32768U, 168000000U };
+    for (size_t c = 0; c < sizeof(clocks) / sizeof(clocks[0]); c++) {
+        SystemCoreClock = clocks[c];
+        uint64_t slack = 1000000U / clocks[c] + 1U;
+        mock_advance(1000000U - mock_now() % 1000000U);     // restart on a tick
+        CHECK_EQ(_stamp(), _virtualUs());
+        uint64_t last = 0;
+        for (uint32_t i = 0; i < 300U; i++) {
+            mock_advance((uint64_t)(i * 7919U % 1000U) * 1000003U + 333U);
+            uint64_t got = _stamp();
+            uint64_t want = _virtualUs();
+            CHECK(got + slack >= want && got <= want + slack);
+            CHECK(got >= last);
+            last = got;
+        }
+    }
+}
+
+#else
+// The tick plus the part of the SysTick period counted down; scaling the
+// count may lose up to 1 us
+static void _hardwareClock(void) {
+    uint64_t last = 0;
+    for (uint32_t i = 0; i < 2000U; i++) {
+        uint64_t got = _stamp();
+        uint64_t want = _virtualUs();
+        CHECK(got <= want && got + 1U >= want);
+        CHECK(got >= last);
+        last = got;
+        mock_advance((uint64_t)(i * 7919U % 1000U) * 1003U + 17U);
+    }
+
+    // SysTick reloaded but its interrupt is masked: the tick lags by one
+    mock_advance(1000000U - mock_now() % 1000000U + 2000U);
+    mock_tick_base--;
+    SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+    mock_advance(1);        // the RA/MSPM0 tick variable follows mock_tick_base
+    uint64_t got = _stamp();
+    mock_tick_base++;
+    SCB->ICSR = 0;
+    mock_advance(1);
+    CHECK(got <= _virtualUs() && got + 1U >= _virtualUs());
+}
+#endif
+#endif
+
+int main(void) {
+    mock_reset();
+    mock_tick_base = TICK_BASE;
+    mock_advance(1);
+    debug_init(TEST_PORT, true, false, false);
+
+#if DEBUG_TIMESTAMP_US
+    _hardwareClock();
+#endif
+    _fakeClock();
+
+#if DEBUG_TIMESTAMP_US
+    // NULL goes back to the built-in source
+    uint64_t now = _stamp();
+    CHECK(now + 1U >= _virtualUs() / 1000U * 1000U && now <= _virtualUs());
+#endif
+
+    printf("timestamps follow the clock source\n");
+    return 0;
+}
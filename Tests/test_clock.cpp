@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * @file        test_clock.cpp
+ * @brief       The C++ DWT clock on STM32 (Cortex-M4), driven by virtual
+ *              time as in test_clock.c: whole-MHz, fractional-MHz and sub-MHz
+ *              core clocks, each one stepping the count exactly.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define TICK_BASE 3723456U      // ms tick at virtual time 0: 01:02:03.456
+
+static ElegantDebug dbg(&huart1, true, false);
+
+static uint64_t _virtualUs() {
+    return TICK_BASE * 1000ULL + mock_now() / 1000U;
+}
+
+// Timestamp of the next line, in microseconds
+static uint64_t _stamp() {
+    size_t at = mock_wire_len;
+    dbg.log("t\n");
+    mock_flush();
+
+    unsigned long h, m, s, us;
+    int n = 0;
+    CHECK(sscanf(&mock_wire[at], "[%lu:%2lu:%2lu.%6lu] %n", &h, &m, &s, &us, &n) == 4 && n > 0);
+    CHECK_STR(&mock_wire[at + (size_t)n], "t\n");
+    return ((h * 60U + m) * 60U + s) * 1000000ULL + us;
+}
+
+int main() {
+    mock_reset();
+    mock_tick_base = TICK_BASE;
+
+    static const uint32_t clocks[] = { 168000000U, 2097000U, 32768U };
+    for (uint32_t hz : clocks) {
+        SystemCoreClock = hz;
+        uint64_t slack = (hz % 1000000U == 0U) ? 0U : 1000000U / hz + 1U;
+        mock_advance(1000000U - mock_now() % 1000000U);     // restart on a tick
+        CHECK_EQ(_stamp(), _virtualUs());
+        uint64_t last = 0;
+        for (uint32_t i = 0; i < 300U; i++) {
+            mock_advance((uint64_t)(i * 7919U % 1000U) * 1000003U + 333U);
+            uint64_t got = _stamp();
+            uint64_t want = _virtualUs();
+            CHECK(got + slack >= want && got <= want + slack);
+            CHECK(got >= last);
+            last = got;
+        }
+    }
+    SystemCoreClock = 168000000U;
+
+    printf("C++ DWT clock: no drift at 168 MHz, 2.097 MHz and 32.768 kHz\n");
+    return 0;
+}
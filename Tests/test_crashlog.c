@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * @file        test_crashlog.c
+ * @brief       DEBUG_CRASHLOG across resets. Each session from reset to
+ *              crash runs in a child process, so the library starts with its
+ *              variables initialized again while `_debug_crashlog`, like a
+ *              .noinit section, holds what the session before left in it.
+ *
+ *              Power-up garbage and a block whose magic, size or CRC does not
+ *              match replay nothing and start an empty log. After a reset the
+ *              replay sends the newest whole lines the block holds, once,
+ *              also when they span several sessions, when the ring wrapped,
+ *              and when the reset hit a write before its header was updated.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define LINES 100
+
+// Everything logged since the block was last started empty
+static char _stream[64 * 1024];
+static size_t _stream_len;
+
+static int _first;              // lines the next session logs: _first .. _first + _count - 1
+static int _count;
+static size_t _garbled;         // bytes of the oldest line the reset garbled
+
+static void _log(int i) {
+    debug_info("crash %d: %.*s\n", i, i % 23, "abcdefghijklmnopqrstuvw");
+}
+
+static void _logged(int first, int count) {
+    for (int i = first; i < first + count; i++) {
+        _stream_len += (size_t)snprintf(&_stream[_stream_len], sizeof(_stream) - _stream_len,
+                                        "[INFO] crash %d: %.*s\n", i, i % 23, "abcdefghijklmnopqrstuvw");
+    }
+}
+
+// What the replay should send: the newest whole lines of the stream that
+// the block holds, between the two markers; returns the bytes of the lines
+static size_t _expect(char* out, size_t size) {
+    size_t start = 0;
+    if (_stream_len > DEBUG_CRASHLOG_LEN) {
+        start = _stream_len - DEBUG_CRASHLOG_LEN + _garbled;
+        while (_stream[start++] != '\n') {}
+    }
+    out[0] = '\0';
+    if (start == _stream_len) return 0;
+    snprintf(out, size, "[WARNING] --- log before reset (%lu bytes) ---\n%s"
+             "[WARNING] --- end of log before reset ---\n",
+             (unsigned long)(_stream_len - start), &_stream[start]);
+    return _stream_len - start;
+}
+
+// One session from reset to crash, in a child process: the block comes
+// back as the session left it
+static void _session(void (*body)(void)) {
+    int fd[2];
+    CHECK(pipe(fd) == 0);
+    fflush(stdout);
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        close(fd[0]);
+        mock_reset();
+        debug_init(&huart1, false, false, false);
+        body();
+        CHECK(write(fd[1], &_debug_crashlog, sizeof(_debug_crashlog)) == (ssize_t)sizeof(_debug_crashlog));
+        fflush(stdout);
+        _exit(0);
+    }
+    close(fd[1]);
+    size_t got = 0;
+    ssize_t n;
+    while ((n = read(fd[0], (char*)&_debug_crashlog + got, sizeof(_debug_crashlog) - got)) > 0) {
+        got += (size_t)n;
+    }
+    close(fd[0]);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK_EQ(got, sizeof(_debug_crashlog));
+}
+
+// Nothing valid in the block: no replay, an empty log started
+static void _nothing(void) {
+    CHECK_EQ(debug_crashlogReplay(), 0U);
+    CHECK_EQ(mock_wire_len, 0U);
+    CHECK_EQ(_debug_crashlog.head, 0U);
+    for (int i = _first; i < _first + _count; i++) _log(i);
+}
+
+// Forgotten: the next session replays nothing
+static void _clear(void) {
+    debug_crashlogClear();
+    CHECK_EQ(debug_crashlogReplay(), 0U);
+    CHECK_EQ(mock_wire_len, 0U);
+}
+
+// The previous sessions' lines replayed once, then this session's logged
+static void _replay(void) {
+    static char expected[2 * DEBUG_CRASHLOG_LEN];
+    size_t len = _expect(expected, sizeof(expected));
+    CHECK_EQ(debug_crashlogReplay(), len);
+    CHECK_STR(mock_wire, expected);
+    CHECK_EQ(debug_crashlogReplay(), 0U);
+    for (int i = _first; i < _first + _count; i++) _log(i);
+}
+
+static void _run(void (*body)(void), int first, int count) {
+    _first = first;
+    _count = count;
+    _session(body);
+    _logged(first, count);
+    _garbled = 0;
+}
+
+int main(void) {
+    // Power-up: RAM holds garbage
+    memset(&_debug_crashlog, 0xA5, sizeof(_debug_crashlog));
+    _run(_nothing, 0, LINES);
+    CHECK(_stream_len > DEBUG_CRASHLOG_LEN);    // the ring wrapped
+
+    // Reset: the newest lines that fit, the oldest cut one skipped
+    _run(_replay, LINES, 3);
+
+    // Again: the three lines of the last session follow the older ones
+    _run(_replay, 2 * LINES, 0);
+    CHECK(_stream_len > DEBUG_CRASHLOG_LEN);
+
+    // A reset in the middle of a write: the bytes went in over the oldest
+    // line, the header still has the head before them
+    memset(&_debug_crashlog.data[_debug_crashlog.head & (DEBUG_CRASHLOG_LEN - 1U)], 'x', 10);
+    _garbled = 10;
+    _run(_replay, 3 * LINES, 2);
+
+    // Cleared: nothing to replay, not even the markers
+    _run(_clear, 0, 0);
+    _stream_len = 0;
+    _run(_replay, 4 * LINES, 0);
+
+    // Magic, size or CRC off: garbage, whatever the data looks like. The
+    // session after starts a block too short to wrap, replayed whole.
+    uint32_t* fields[] = { &_debug_crashlog.magic, &_debug_crashlog.size, &_debug_crashlog.head,
+                           &_debug_crashlog.crc };
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        *fields[i] ^= 0x100U;
+        _stream_len = 0;
+        _run(_nothing, 6 * LINES, 4);
+        _run(_replay, 7 * LINES, 0);
+    }
+
+    printf("crash log: replayed across resets, garbage and torn writes rejected\n");
+    return 0;
+}
@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * @file        test_flashlog.c
+ * @brief       DEBUG_FLASHLOG on a RAM-backed flash: 4 sectors of 512 bytes,
+ *              8-byte program units that may be written once between erases.
+ *              Each session from power-up to power loss runs in a child
+ *              process, so the library mounts the region afresh while the
+ *              region itself, shared memory, keeps what was programmed.
+ *
+ *              A power loss in the middle of a record loses that record only:
+ *              the export skips it and the next session goes on after it.
+ *              Logging past the end of the region erases the oldest sector
+ *              and keeps the rest; the next session finds the newest sector,
+ *              also when the sequence numbers wrap, and appends to it. Every
+ *              sector is erased as often as the others.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SECTOR   512U
+#define SECTORS  4U
+#define PROG     8U
+#define FL_MAGIC 0x4C464445U    // sector header: magic, sequence number
+#define RECORD   48U            // largest record the tests write
+
+typedef struct {
+    uint8_t mem[SECTORS * SECTOR];
+    uint32_t erases[SECTORS];
+} region_t;
+
+static region_t* _rg;           // shared with the sessions
+static long _budget = -1;       // bytes programmed before the power goes, -1: no loss
+
+static bool _read(void* ctx, uint32_t addr, void* dst, size_t len) {
+    (void)ctx;
+    CHECK(addr + len <= sizeof(_rg->mem));
+    memcpy(dst, &_rg->mem[addr], len);
+    return true;
+}
+
+// Whole, aligned units of erased flash only. The power going in the middle
+// leaves the first bytes programmed and the rest erased.
+static bool _program(void* ctx, uint32_t addr, const void* src, size_t len) {
+    (void)ctx;
+    CHECK(addr % PROG == 0U && len % PROG == 0U && addr + len <= sizeof(_rg->mem));
+    for (size_t i = 0; i < len; i++) CHECK(_rg->mem[addr + i] == 0xFFU);
+    if (_budget >= 0 && (size_t)_budget < len) {
+        memcpy(&_rg->mem[addr], src, (size_t)_budget);
+        fflush(stdout);
+        _exit(0);
+    }
+    memcpy(&_rg->mem[addr], src, len);
+    if (_budget >= 0) _budget -= (long)len;
+    return true;
+}
+
+static bool _erase(void* ctx, uint32_t sector) {
+    (void)ctx;
+    CHECK(sector < SECTORS);
+    memset(&_rg->mem[sector * SECTOR], 0xFF, SECTOR);
+    _rg->erases[sector]++;
+    return true;
+}
+
+static const debug_flash_t _flash = { _read, _program, _erase, NULL, SECTOR, SECTORS, PROG };
+
+// What should be stored, oldest first: lines and boot marks
+static char _model[4096][48];
+static int _model_n;
+
+static const char _filler[] = "abcdefghijklmnopqrs";
+
+static void _log(int i) {
+    debug_info("rec %d %.*s\n", i, i % 19, _filler);
+}
+
+// Flash a record takes: header and line, padded to whole units
+static size_t _record(const char* s) {
+    if (strcmp(s, "--- boot ---\n") == 0) return PROG;
+    size_t size = (4U + strlen(s) + PROG - 1U) / PROG * PROG;
+    CHECK(size <= RECORD);
+    return size;
+}
+
+// The export, between its two warning lines: the newest records of the
+// model, all of them when `whole`. Otherwise only the oldest sector may be
+// missing, the others are full.
+static void _checkExport(bool whole) {
+    size_t from = mock_wire_len;    // the lines went to the port too
+    size_t records = debug_flashlogExport();
+    const char head[] = "[WARNING] --- flash log ---\n";
+    CHECK(strncmp(&mock_wire[from], head, strlen(head)) == 0);
+
+    char* p = &mock_wire[from + strlen(head)];
+    int n = 0;
+    for (char* q = p; strncmp(q, "[WARNING]", 9) != 0; q = strchr(q, '\n') + 1) {
+        CHECK(strchr(q, '\n') != NULL);
+        n++;
+    }
+    CHECK(n <= _model_n);
+    CHECK(!whole || n == _model_n);
+
+    size_t lines = 0;
+    size_t bytes = 0;
+    for (int i = _model_n - n; i < _model_n; i++) {
+        size_t len = strlen(_model[i]);
+        CHECK(strncmp(p, _model[i], len) == 0);
+        p += len;
+        bytes += _record(_model[i]);
+        if (strcmp(_model[i], "--- boot ---\n") != 0) lines++;
+    }
+    if (!whole) CHECK(bytes >= (SECTORS - 1U) * (SECTOR - 8U - RECORD));
+
+    char tail[64];
+    snprintf(tail, sizeof(tail), "[WARNING] --- end of flash log (%lu records) ---\n", (unsigned long)lines);
+    CHECK_STR(p, tail);
+    CHECK_EQ(records, lines);
+}
+
+static struct {
+    int first;
+    int count;
+    long cut;       // the power goes after this many bytes of the next line, 0: it stays
+    bool export_;
+    bool whole;
+} _s;
+
+static void _body(void) {
+    for (int i = _s.first; i < _s.first + _s.count; i++) _log(i);
+    if (_s.cut > 0) {
+        _budget = _s.cut;
+        _log(_s.first + _s.count);
+        CHECK(!"the power stayed");
+    }
+    if (_s.export_) _checkExport(_s.whole);
+}
+
+// Power-up, debug_flashlogInit(), `count` lines from `first` on, then the
+// power loss or the export
+static void _session(int first, int count, long cut, bool export_, bool whole) {
+    _s.first = first;
+    _s.count = count;
+    _s.cut = cut;
+    _s.export_ = export_;
+    _s.whole = whole;
+    strcpy(_model[_model_n++], "--- boot ---\n");
+    for (int i = first; i < first + count; i++) {
+        snprintf(_model[_model_n++], sizeof(_model[0]), "[INFO] rec %d %.*s\n", i, i % 19, _filler);
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    CHECK(pid >= 0);
+    if (pid == 0) {
+        mock_reset();
+        debug_init(&huart1, false, false, false);
+        CHECK(debug_flashlogInit(&_flash, DEBUG_LEVEL_INFO) >= 0);
+        _body();
+        fflush(stdout);
+        _exit(0);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void _blank(void) {
+    memset(_rg, 0xFF, sizeof(_rg->mem));
+    memset(_rg->erases, 0, sizeof(_rg->erases));
+    _model_n = 0;
+}
+
+// Move every sector's sequence number so that the newest is 1: the older
+// ones are 0, 0xFFFFFFFF, ...
+static void _wrapSeq(void) {
+    uint32_t newest = 0;
+    bool found = false;
+    for (uint32_t s = 0; s < SECTORS; s++) {
+        uint32_t hdr[2];
+        memcpy(hdr, &_rg->mem[s * SECTOR], sizeof(hdr));
+        if (hdr[0] == FL_MAGIC && (!found || (int32_t)(hdr[1] - newest) > 0)) newest = hdr[1];
+        found = found || hdr[0] == FL_MAGIC;
+    }
+    CHECK(found);
+    for (uint32_t s = 0; s < SECTORS; s++) {
+        uint32_t hdr[2];
+        memcpy(hdr, &_rg->mem[s * SECTOR], sizeof(hdr));
+        if (hdr[0] != FL_MAGIC) continue;
+        hdr[1] = hdr[1] - newest + 1U;
+        memcpy(&_rg->mem[s * SECTOR], hdr, sizeof(hdr));
+    }
+}
+
+int main(void) {
+    _rg = mmap(NULL, sizeof(region_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(_rg != MAP_FAILED);
+
+    // Blank region, one session: everything comes back
+    _blank();
+    _session(0, 5, 0, true, true);
+
+    // The power goes after each byte of a record but its last (the padding
+    // after it is programmed as erased anyway)
+    char line[64];
+    size_t torn = 4U + (size_t)snprintf(line, sizeof(line), "[INFO] rec 5 %.*s\n", 5, _filler);
+    for (long cut = 1; cut < (long)torn; cut++) {
+        _blank();
+        _session(0, 5, cut, false, false);
+        _session(100, 3, 0, true, true);
+        _session(200, 2, 0, true, true);
+    }
+    printf("flash log: power lost at %lu points in a record, only that record lost\n",
+           (unsigned long)torn - 1U);
+
+    // More than the region holds: the oldest sectors are erased, the next
+    // session appends after the newest record
+    _blank();
+    _session(0, 300, 0, true, false);
+    _session(1000, 3, 0, true, false);
+
+    // Sequence numbers across 2^32: still the newest sector
+    _wrapSeq();
+    _session(2000, 2, 0, true, false);
+    _session(3000, 300, 0, true, false);
+    _session(4000, 1, 0, true, false);
+
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (uint32_t s = 0; s < SECTORS; s++) {
+        if (_rg->erases[s] < lo) lo = _rg->erases[s];
+        if (_rg->erases[s] > hi) hi = _rg->erases[s];
+    }
+    CHECK(lo > 0U && hi - lo <= 1U);
+    printf("flash log: %u sectors erased %lu~%lu times, the newest records kept\n",
+           SECTORS, (unsigned long)lo, (unsigned long)hi);
+    return 0;
+}
@@ -0,0 +1,153 @@
+/*******************************************************************************
+ * @file        test_hexdump.cpp
+ * @brief       ElegantDebug::hexdump() against the same byte-by-byte
+ *              reference as test_hexdump.c: row lengths, the ASCII column
+ *              of every byte value in every lane, 4- and 8-digit offsets
+ *              and the changed-byte runs with colors on and off.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+// One row as the header documents it, a byte at a time
+static size_t _row(char* o, const uint8_t* p, size_t off, size_t n, uint32_t changed, bool wide) {
+    char* s = o;
+    o += sprintf(o, wide ? "%08lX " : "%04lX ", (unsigned long)off);
+    for (size_t i = 0; i < 16U; i++) {
+        if (i % 8U == 0U) *o++ = ' ';
+        if (i >= n) {
+            o += sprintf(o, "   ");
+            continue;
+        }
+        bool red = ((changed >> i) & 1U) != 0U;
+        if (red && (i == 0U || !((changed >> (i - 1U)) & 1U))) o += sprintf(o, "%s", COLOR_RED);
+        o += sprintf(o, "%02X", p[i]);
+        if (red && !((changed >> (i + 1U)) & 1U)) o += sprintf(o, "%s", CLR);
+        *o++ = ' ';
+    }
+    o += sprintf(o, " |");
+    for (size_t i = 0; i < n; i++) {
+        *o++ = (p[i] >= 0x20U && p[i] <= 0x7EU) ? (char)p[i] : '.';
+    }
+    o += sprintf(o, "|\n");
+    return (size_t)(o - s);
+}
+
+// The whole dump as the reference builds it
+static void _dump(char* o, const uint8_t* p, const uint8_t* q, size_t len) {
+    *o = '\0';
+    for (size_t off = 0; off < len; off += 16U) {
+        size_t n = (len - off < 16U) ? len - off : 16U;
+        uint32_t changed = 0;
+        for (size_t i = 0; q != nullptr && i < n; i++) {
+            if (p[off + i] != q[off + i]) changed |= 1UL << i;
+        }
+        o += _row(o, p + off, off, n, changed, len > 0x10000U);
+    }
+}
+
+static ElegantDebug dbg(&huart1, false, false);
+
+static uint8_t _big[0x10000 + 17];
+static char _want[MOCK_WIRE_LEN + 1U];
+
+int main() {
+    mock_reset();
+
+    uint8_t data[17];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)(0x41U + i);
+
+    // Lengths around a row: nothing, one byte, one short of a row, a row,
+    // a row and one byte
+    dbg.hexdump(data, 0, nullptr);
+    CHECK_EQ(mock_wire_len, 0U);
+    dbg.hexdump(nullptr, 16, nullptr);
+    CHECK_EQ(mock_wire_len, 0U);
+    dbg.hexdump(data, 1, nullptr);
+    CHECK_STR(mock_wire,
+        "0000  41                                                |A|\n");
+    mock_reset();
+    dbg.hexdump(data, 15, nullptr);
+    CHECK_STR(mock_wire,
+        "0000  41 42 43 44 45 46 47 48  49 4A 4B 4C 4D 4E 4F     |ABCDEFGHIJKLMNO|\n");
+    mock_reset();
+    dbg.hexdump(data, 16, nullptr);
+    CHECK_STR(mock_wire,
+        "0000  41 42 43 44 45 46 47 48  49 4A 4B 4C 4D 4E 4F 50  |ABCDEFGHIJKLMNOP|\n");
+    mock_reset();
+    dbg.hexdump(data, 17, nullptr);
+    CHECK_STR(mock_wire,
+        "0000  41 42 43 44 45 46 47 48  49 4A 4B 4C 4D 4E 4F 50  |ABCDEFGHIJKLMNOP|\n"
+        "0010  51                                                |Q|\n");
+
+    // The edges of printable ASCII, in the word-wide part and in the tail
+    static const uint8_t edges[] = { 0x1F, 0x20, 0x7E, 0x7F, 0x80, 0x1F, 0x20, 0x7E, 0x7F, 0x80 };
+    mock_reset();
+    dbg.hexdump(edges, sizeof(edges), nullptr);
+    CHECK_STR(mock_wire,
+        "0000  1F 20 7E 7F 80 1F 20 7E  7F 80                    |. ~... ~..|\n");
+
+    // Every byte value in every lane of a word, with every length's tail,
+    // and in the byte-by-byte tail alone
+    uint8_t all[256 + 3];
+    for (size_t shift = 0; shift < 4U; shift++) {
+        for (size_t i = 0; i < sizeof(all); i++) all[i] = (uint8_t)(i - shift);
+        for (size_t len = 253; len <= sizeof(all); len++) {
+            mock_reset();
+            dbg.hexdump(all, len, nullptr);
+            _dump(_want, all, nullptr, len);
+            CHECK_STR(mock_wire, _want);
+        }
+    }
+    for (size_t v = 0; v < 256U; v++) {
+        uint8_t tail[3] = { (uint8_t)v, (uint8_t)(v + 85U), (uint8_t)(v + 170U) };
+        mock_reset();
+        dbg.hexdump(tail, sizeof(tail), nullptr);
+        _dump(_want, tail, nullptr, sizeof(tail));
+        CHECK_STR(mock_wire, _want);
+    }
+
+    // 4-digit offsets up to 64 KB, 8 digits past it
+    for (size_t i = 0; i < sizeof(_big); i++) _big[i] = (uint8_t)(i ^ (i >> 8));
+    mock_reset();
+    dbg.hexdump(_big, 0x10000, nullptr);
+    CHECK(strstr(mock_wire, "\nFFF0  ") != nullptr);
+    _dump(_want, _big, nullptr, 0x10000);
+    CHECK_STR(mock_wire, _want);
+    mock_reset();
+    dbg.hexdump(_big, sizeof(_big), nullptr);
+    CHECK(strncmp(mock_wire, "00000000  ", 10) == 0);
+    CHECK(strstr(mock_wire, "\n00010000  ") != nullptr);
+    _dump(_want, _big, nullptr, sizeof(_big));
+    CHECK_STR(mock_wire, _want);
+
+    // Changed bytes in red, one pair per run: at the start, alone, across
+    // the middle gap, at the end of a row and of a short row
+    uint8_t prev[sizeof(data)];
+    memcpy(prev, data, sizeof(data));
+    static const size_t flip[] = { 0, 1, 2, 5, 7, 8, 15, 16 };
+    for (size_t i = 0; i < sizeof(flip) / sizeof(flip[0]); i++) prev[flip[i]] ^= 0x20U;
+    dbg.setColorEnabled(true);
+    mock_reset();
+    dbg.hexdump(data, sizeof(data), prev);
+    _dump(_want, data, prev, sizeof(data));
+    CHECK_STR(mock_wire, _want);
+    static const char runs[] =
+        "0000  " COLOR_RED "41 42 43" CLR " 44 45 " COLOR_RED "46" CLR " 47 " COLOR_RED "48  49" CLR " 4A";
+    CHECK(strncmp(mock_wire, runs, sizeof(runs) - 1U) == 0);
+
+    // ... none without a snapshot or with colors off
+    mock_reset();
+    dbg.hexdump(data, sizeof(data), nullptr);
+    CHECK(strchr(mock_wire, '\x1B') == nullptr);
+    dbg.setColorEnabled(false);
+    mock_reset();
+    dbg.hexdump(data, sizeof(data), prev);
+    _dump(_want, data, nullptr, sizeof(data));
+    CHECK_STR(mock_wire, _want);
+
+    printf("hexdump (C++): row lengths, ASCII column, wide offsets and changed bytes as expected\n");
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * @file        test_minlevel.c
+ * @brief       DEBUG_MIN_LEVEL at DEBUG_LEVEL_WARNING: the filtered C calls
+ *              must not evaluate their arguments nor print, the others must
+ *              do both. Built in text and in binary mode. check_strings.cmake
+ *              then looks for the format literals in the executable: the
+ *              filtered ones must be gone.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define MOD_ADC 1
+
+static int _evaluated;
+
+static int _arg(void) {
+    return ++_evaluated;
+}
+
+int main(void) {
+    mock_reset();
+    debug_init(&huart1, false, false, false);
+    debug_moduleRegister(MOD_ADC, "adc", DEBUG_LEVEL_LOG);
+    uint8_t data[4] = { 1, 2, 3, 4 };
+
+    debug_log("filtered-log %d\n", _arg());
+    debug_logWithType("[T] ", "", "filtered-type %d\n", _arg());
+    debug_info("filtered-info %d\n", _arg());
+    debug_ok("filtered-ok %d\n", _arg());
+    debug_success("filtered-success %d\n", _arg());
+    debug_moduleLog(MOD_ADC, "filtered-module-log %d\n", _arg());
+    debug_moduleInfo(MOD_ADC, "filtered-module-info %d\n", _arg());
+    debug_moduleOk(MOD_ADC, "filtered-module-ok %d\n", _arg());
+    debug_moduleSuccess(MOD_ADC, "filtered-module-success %d\n", _arg());
+    debug_hexdump(data, (size_t)_arg(), NULL);
+    for (int i = 0; i < 3; i++) {
+        debug_once(INFO, "folded-once %d\n", _arg());
+        debug_everyN(OK, 2, "folded-every-n %d\n", _arg());
+        debug_everyMs(LOG, 10, "folded-every-ms %d\n", _arg());
+    }
+    CHECK_EQ(_evaluated, 0);
+    CHECK_EQ(mock_wire_len, 0U);
+
+    debug_warning("kept-warning %d\n", _arg());
+    debug_error("kept-error %d\n", _arg());
+    debug_moduleWarning(MOD_ADC, "kept-module-warning %d\n", _arg());
+    debug_moduleError(MOD_ADC, "kept-module-error %d\n", _arg());
+    debug_once(WARNING, "kept-once %d\n", _arg());
+    CHECK_EQ(_evaluated, 5);
+#if !DEBUG_BINARY_MODE
+    CHECK_STR(mock_wire,
+        "[WARNING] kept-warning 1\n"
+        "[ERROR] kept-error 2\n"
+        "[WARNING] [adc] kept-module-warning 3\n"
+        "[ERROR] [adc] kept-module-error 4\n"
+        "[WARNING] kept-once 5\n");
+#else
+    CHECK(mock_wire_len > 0U);
+#endif
+
+    printf("min level: %d filtered call sites, no argument evaluated\n", 13);
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * @file        test_minlevel.cpp
+ * @brief       DEBUG_MIN_LEVEL at DEBUG_LEVEL_WARNING through the C++ API:
+ *              the filtered dbg_* macros must not evaluate their arguments
+ *              nor print, the others must do both. The filtered methods do
+ *              not print but, being functions, still evaluate their
+ *              arguments. Built in text and in binary mode (the methods only
+ *              in text mode); check_strings.cmake then looks for the format
+ *              literals in the executable: those of the macros must be gone.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define MOD_ADC 1
+
+static ElegantDebug dbg(&huart1, false, false);
+
+static int _evaluated;
+
+static int _arg() {
+    return ++_evaluated;
+}
+
+int main() {
+    mock_reset();
+    dbg.moduleRegister(MOD_ADC, "adc", DEBUG_LEVEL_LOG);
+
+    dbg_log(dbg, "filtered-log %d\n", _arg());
+    dbg_logWithType(dbg, "[T] ", "", "filtered-type %d\n", _arg());
+    dbg_info(dbg, "filtered-info %d\n", _arg());
+    dbg_ok(dbg, "filtered-ok %d\n", _arg());
+    dbg_success(dbg, "filtered-success %d\n", _arg());
+    dbg_moduleLog(dbg, MOD_ADC, "filtered-module-log %d\n", _arg());
+    dbg_moduleInfo(dbg, MOD_ADC, "filtered-module-info %d\n", _arg());
+    dbg_moduleOk(dbg, MOD_ADC, "filtered-module-ok %d\n", _arg());
+    dbg_moduleSuccess(dbg, MOD_ADC, "filtered-module-success %d\n", _arg());
+    for (int i = 0; i < 3; i++) {
+        dbg_once(dbg, INFO, "folded-once %d\n", _arg());
+        dbg_everyN(dbg, OK, 2, "folded-every-n %d\n", _arg());
+        dbg_everyMs(dbg, LOG, 10, "folded-every-ms %d\n", _arg());
+    }
+    CHECK_EQ(_evaluated, 0);
+    CHECK_EQ(mock_wire_len, 0U);
+
+#if !DEBUG_BINARY_MODE
+    dbg.info("method-info %d\n", _arg());
+    dbg.log("method-log %d\n", _arg());
+    CHECK_EQ(_evaluated, 2);
+    CHECK_EQ(mock_wire_len, 0U);
+    _evaluated = 0;
+#endif
+
+    dbg_warning(dbg, "kept-warning %d\n", _arg());
+    dbg_error(dbg, "kept-error %d\n", _arg());
+    dbg_moduleWarning(dbg, MOD_ADC, "kept-module-warning %d\n", _arg());
+    dbg_moduleError(dbg, MOD_ADC, "kept-module-error %d\n", _arg());
+    dbg_once(dbg, WARNING, "kept-once %d\n", _arg());
+    CHECK_EQ(_evaluated, 5);
+#if !DEBUG_BINARY_MODE
+    CHECK_STR(mock_wire,
+        "[WARNING] kept-warning 1\n"
+        "[ERROR] kept-error 2\n"
+        "[WARNING] [adc] kept-module-warning 3\n"
+        "[ERROR] [adc] kept-module-error 4\n"
+        "[WARNING] kept-once 5\n");
+#else
+    CHECK(mock_wire_len > 0U);
+#endif
+
+    printf("min level (C++): %d filtered call sites, no argument evaluated\n", 12);
+    return 0;
+}
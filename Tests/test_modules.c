@@ -0,0 +1,123 @@
+/*******************************************************************************
+ * @file        test_modules.c
+ * @brief       Per-module runtime levels: each module's calls pass or are
+ *              dropped by its own level, before their arguments are
+ *              evaluated, and carry its "[name] " after the type prefix and
+ *              before "[file:line] ". IDs past DEBUG_MODULE_COUNT are not
+ *              stored anywhere: they always pass, without a name.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+enum { MOD_ADC, MOD_NET, MOD_NAMELESS, MOD_LAST = DEBUG_MODULE_COUNT - 1, MOD_OUT = DEBUG_MODULE_COUNT };
+
+static int _evaluated;
+
+static int _arg(void) {
+    return ++_evaluated;
+}
+
+// One call of each level; the wire and the count from before are cleared
+static void _all(uint8_t module) {
+    mock_reset();
+    _evaluated = 0;
+    debug_moduleLog(module, "log %d\n", _arg());
+    debug_moduleInfo(module, "info %d\n", _arg());
+    debug_moduleOk(module, "ok %d\n", _arg());
+    debug_moduleSuccess(module, "success %d\n", _arg());
+    debug_moduleWarning(module, "warning %d\n", _arg());
+    debug_moduleError(module, "error %d\n", _arg());
+}
+
+int main(void) {
+    mock_reset();
+    debug_init(&huart1, false, false, false);
+
+    // Unregistered: everything passes, no name
+    for (uint8_t m = 0; m < DEBUG_MODULE_COUNT; m++) {
+        CHECK_EQ(debug_moduleGetLevel(m), DEBUG_LEVEL_LOG);
+        CHECK_STR(debug_moduleName(m), "");
+    }
+    _all(MOD_ADC);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "log 1\n[INFO] info 2\n[OK] ok 3\n[SUCCESS] success 4\n[WARNING] warning 5\n[ERROR] error 6\n");
+
+    debug_moduleRegister(MOD_ADC, "adc", DEBUG_LEVEL_WARNING);
+    debug_moduleRegister(MOD_NET, "net", DEBUG_LEVEL_LOG);
+    debug_moduleRegister(MOD_NAMELESS, NULL, DEBUG_LEVEL_OK);
+    debug_moduleRegister(MOD_LAST, "last", DEBUG_LEVEL_ERROR);
+    CHECK_EQ(debug_moduleGetLevel(MOD_ADC), DEBUG_LEVEL_WARNING);
+    CHECK_STR(debug_moduleName(MOD_ADC), "adc");
+    CHECK_STR(debug_moduleName(MOD_NAMELESS), "");
+    CHECK(!debug_moduleEnabled(MOD_ADC, DEBUG_LEVEL_SUCCESS));
+    CHECK(debug_moduleEnabled(MOD_ADC, DEBUG_LEVEL_WARNING));
+    CHECK(debug_moduleEnabled(MOD_NET, DEBUG_LEVEL_LOG));
+
+    // Below the level: dropped, arguments not evaluated
+    _all(MOD_ADC);
+    CHECK_EQ(_evaluated, 2);
+    CHECK_STR(mock_wire, "[WARNING] [adc] warning 1\n[ERROR] [adc] error 2\n");
+
+    _all(MOD_NET);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "[net] log 1\n[INFO] [net] info 2\n[OK] [net] ok 3\n[SUCCESS] [net] success 4\n"
+        "[WARNING] [net] warning 5\n[ERROR] [net] error 6\n");
+
+    _all(MOD_NAMELESS);
+    CHECK_EQ(_evaluated, 4);
+    CHECK_STR(mock_wire, "[OK] ok 1\n[SUCCESS] success 2\n[WARNING] warning 3\n[ERROR] error 4\n");
+
+    _all(MOD_LAST);
+    CHECK_EQ(_evaluated, 1);
+    CHECK_STR(mock_wire, "[ERROR] [last] error 1\n");
+
+    // The level changes at run time, the name stays; other modules keep theirs
+    debug_moduleSetLevel(MOD_ADC, DEBUG_LEVEL_LOG);
+    CHECK_EQ(debug_moduleGetLevel(MOD_ADC), DEBUG_LEVEL_LOG);
+    _all(MOD_ADC);
+    CHECK_STR(mock_wire,
+        "[adc] log 1\n[INFO] [adc] info 2\n[OK] [adc] ok 3\n[SUCCESS] [adc] success 4\n"
+        "[WARNING] [adc] warning 5\n[ERROR] [adc] error 6\n");
+    debug_moduleSetLevel(MOD_ADC, DEBUG_LEVEL_NONE);
+    _all(MOD_ADC);
+    CHECK_EQ(_evaluated, 0);
+    CHECK_EQ(mock_wire_len, 0U);
+    CHECK_EQ(debug_moduleGetLevel(MOD_NET), DEBUG_LEVEL_LOG);
+    CHECK_EQ(debug_moduleGetLevel(MOD_LAST), DEBUG_LEVEL_ERROR);
+
+    // Out of range: ignored by the setters, reads as an unnamed module at
+    // DEBUG_LEVEL_LOG, always passes
+    debug_moduleRegister(MOD_OUT, "out", DEBUG_LEVEL_ERROR);
+    debug_moduleSetLevel(MOD_OUT, DEBUG_LEVEL_NONE);
+    debug_moduleSetLevel(255, DEBUG_LEVEL_NONE);
+    CHECK_EQ(debug_moduleGetLevel(MOD_OUT), DEBUG_LEVEL_LOG);
+    CHECK_EQ(debug_moduleGetLevel(255), DEBUG_LEVEL_LOG);
+    CHECK_STR(debug_moduleName(MOD_OUT), "");
+    CHECK(debug_moduleEnabled(MOD_OUT, DEBUG_LEVEL_LOG));
+    for (uint8_t m = 0; m < DEBUG_MODULE_COUNT; m++) {
+        CHECK(m == MOD_ADC || debug_moduleGetLevel(m) != DEBUG_LEVEL_NONE);
+    }
+    _all(MOD_OUT);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "log 1\n[INFO] info 2\n[OK] ok 3\n[SUCCESS] success 4\n[WARNING] warning 5\n[ERROR] error 6\n");
+
+    // The name comes before the location of warnings and errors
+    debug_init(&huart1, false, false, true);
+    mock_reset();
+    int line = __LINE__ + 1;
+    debug_moduleWarning(MOD_NET, "late by %d ms\n", 3);
+    char expected[128];
+    snprintf(expected, sizeof(expected), "test_modules.c:%d] late by 3 ms\n", line);
+    CHECK(strncmp(mock_wire, "[WARNING] [net] [", 17) == 0);
+    CHECK(mock_wire_len > strlen(expected));
+    CHECK_STR(&mock_wire[mock_wire_len - strlen(expected)], expected);
+
+    printf("modules: levels, names and out-of-range IDs as expected\n");
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * @file        test_modules.cpp
+ * @brief       test_modules.c through the C++ API: moduleRegister() and
+ *              friends on an instance, the calls through the dbg_module*()
+ *              macros. Unlike the C macros these forward to methods, which
+ *              evaluate the arguments of a dropped call too. Built as C++17,
+ *              so without the file:line part.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+enum { MOD_ADC, MOD_NET, MOD_NAMELESS, MOD_LAST = DEBUG_MODULE_COUNT - 1, MOD_OUT = DEBUG_MODULE_COUNT };
+
+static ElegantDebug dbg(&huart1, false, false);
+
+static int _evaluated;
+
+static int _arg() {
+    return ++_evaluated;
+}
+
+// One call of each level; the wire and the count from before are cleared
+static void _all(uint8_t module) {
+    mock_reset();
+    _evaluated = 0;
+    dbg_moduleLog(dbg, module, "log %d\n", _arg());
+    dbg_moduleInfo(dbg, module, "info %d\n", _arg());
+    dbg_moduleOk(dbg, module, "ok %d\n", _arg());
+    dbg_moduleSuccess(dbg, module, "success %d\n", _arg());
+    dbg_moduleWarning(dbg, module, "warning %d\n", _arg());
+    dbg_moduleError(dbg, module, "error %d\n", _arg());
+}
+
+int main() {
+    mock_reset();
+
+    // Unregistered: everything passes, no name
+    for (uint8_t m = 0; m < DEBUG_MODULE_COUNT; m++) {
+        CHECK_EQ(dbg.moduleGetLevel(m), DEBUG_LEVEL_LOG);
+        CHECK_STR(dbg.moduleName(m), "");
+    }
+    _all(MOD_ADC);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "log 1\n[INFO] info 2\n[OK] ok 3\n[SUCCESS] success 4\n[WARNING] warning 5\n[ERROR] error 6\n");
+
+    dbg.moduleRegister(MOD_ADC, "adc", DEBUG_LEVEL_WARNING);
+    dbg.moduleRegister(MOD_NET, "net", DEBUG_LEVEL_LOG);
+    dbg.moduleRegister(MOD_NAMELESS, nullptr, DEBUG_LEVEL_OK);
+    dbg.moduleRegister(MOD_LAST, "last", DEBUG_LEVEL_ERROR);
+    CHECK_EQ(dbg.moduleGetLevel(MOD_ADC), DEBUG_LEVEL_WARNING);
+    CHECK_STR(dbg.moduleName(MOD_ADC), "adc");
+    CHECK_STR(dbg.moduleName(MOD_NAMELESS), "");
+    CHECK(!dbg.moduleEnabled(MOD_ADC, DEBUG_LEVEL_SUCCESS));
+    CHECK(dbg.moduleEnabled(MOD_ADC, DEBUG_LEVEL_WARNING));
+    CHECK(dbg.moduleEnabled(MOD_NET, DEBUG_LEVEL_LOG));
+
+    // Below the level: dropped. The calls are functions, so their arguments
+    // are evaluated all the same
+    _all(MOD_ADC);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire, "[WARNING] [adc] warning 5\n[ERROR] [adc] error 6\n");
+
+    _all(MOD_NET);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "[net] log 1\n[INFO] [net] info 2\n[OK] [net] ok 3\n[SUCCESS] [net] success 4\n"
+        "[WARNING] [net] warning 5\n[ERROR] [net] error 6\n");
+
+    _all(MOD_NAMELESS);
+    CHECK_STR(mock_wire, "[OK] ok 3\n[SUCCESS] success 4\n[WARNING] warning 5\n[ERROR] error 6\n");
+
+    _all(MOD_LAST);
+    CHECK_STR(mock_wire, "[ERROR] [last] error 6\n");
+
+    // The level changes at run time, the name stays; other modules keep theirs
+    dbg.moduleSetLevel(MOD_ADC, DEBUG_LEVEL_LOG);
+    CHECK_EQ(dbg.moduleGetLevel(MOD_ADC), DEBUG_LEVEL_LOG);
+    _all(MOD_ADC);
+    CHECK_STR(mock_wire,
+        "[adc] log 1\n[INFO] [adc] info 2\n[OK] [adc] ok 3\n[SUCCESS] [adc] success 4\n"
+        "[WARNING] [adc] warning 5\n[ERROR] [adc] error 6\n");
+    dbg.moduleSetLevel(MOD_ADC, DEBUG_LEVEL_NONE);
+    _all(MOD_ADC);
+    CHECK_EQ(mock_wire_len, 0U);
+    CHECK_EQ(dbg.moduleGetLevel(MOD_NET), DEBUG_LEVEL_LOG);
+    CHECK_EQ(dbg.moduleGetLevel(MOD_LAST), DEBUG_LEVEL_ERROR);
+
+    // Out of range: ignored by the setters, reads as an unnamed module at
+    // DEBUG_LEVEL_LOG, always passes
+    dbg.moduleRegister(MOD_OUT, "out", DEBUG_LEVEL_ERROR);
+    dbg.moduleSetLevel(MOD_OUT, DEBUG_LEVEL_NONE);
+    dbg.moduleSetLevel(255, DEBUG_LEVEL_NONE);
+    CHECK_EQ(dbg.moduleGetLevel(MOD_OUT), DEBUG_LEVEL_LOG);
+    CHECK_EQ(dbg.moduleGetLevel(255), DEBUG_LEVEL_LOG);
+    CHECK_STR(dbg.moduleName(MOD_OUT), "");
+    CHECK(dbg.moduleEnabled(MOD_OUT, DEBUG_LEVEL_LOG));
+    for (uint8_t m = 0; m < DEBUG_MODULE_COUNT; m++) {
+        CHECK(m == MOD_ADC || dbg.moduleGetLevel(m) != DEBUG_LEVEL_NONE);
+    }
+    _all(MOD_OUT);
+    CHECK_EQ(_evaluated, 6);
+    CHECK_STR(mock_wire,
+        "log 1\n[INFO] info 2\n[OK] ok 3\n[SUCCESS] success 4\n[WARNING] warning 5\n[ERROR] error 6\n");
+
+    printf("modules (C++): levels, names and out-of-range IDs as expected\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * @file        test_nonblocking.c
+ * @brief       UART at 115200 baud, built blocking and with
+ *              DEBUG_TX_NONBLOCKING, on STM32 (DMA and IT) and MSPM0 (TX
+ *              FIFO refilled from the TX interrupt). Both must put the same
+ *              bytes on the wire; only the blocking build may spend wire time
+ *              inside the call, which is CPU time spinning on the port. Prints
+ *              that and the host time per call. On STM32, a UART used
+ *              elsewhere until the ring is full is taken back by the next
+ *              line, though that one finds no room.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #define TEST_PORT (&huart1)
+#elif defined(USE_TI_MSPM0_DL)
+    #define TEST_PORT UART_0_INST
+    #define FIFO_LEN  4U        // plus one byte in the shift register
+#endif
+#include <time.h>
+
+#define BYTE_NS 86806U      // 10 bits at 115200 baud
+#define LINES   16
+
+#if DEBUG_TX_NONBLOCKING && defined(USE_STM32_HAL)
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+#elif DEBUG_TX_NONBLOCKING && defined(USE_TI_MSPM0_DL)
+void UART_0_INST_IRQHandler(void) {
+    switch (DL_UART_getPendingInterrupt(UART_0_INST)) {
+        case DL_UART_IIDX_TX:
+            debug_txCpltCallback(UART_0_INST);
+            break;
+        default:
+            break;
+    }
+}
+#endif
+
+static uint64_t _wall(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+// Log LINES lines, letting a third of a line's wire time pass between them
+// so later lines are copied in while earlier ones are still being sent
+static void _burst(uint64_t* in_call_ns, uint64_t* wall_ns) {
+    for (int i = 0; i < LINES; i++) {
+        uint64_t t0 = mock_now();
+        uint64_t w0 = _wall();
+        debug_info("sample %d: %d mV\n", i, 1000 + 7 * i);
+        *wall_ns += _wall() - w0;
+        *in_call_ns += mock_now() - t0;
+        mock_advance(10U * BYTE_NS);
+    }
+    mock_flush();
+}
+
+static void _expect(void) {
+    char expected[LINES * 64] = "";
+    size_t n = 0;
+    for (int i = 0; i < LINES; i++) {
+        n += (size_t)snprintf(&expected[n], sizeof(expected) - n, "[INFO] sample %d: %d mV\n", i, 1000 + 7 * i);
+    }
+    CHECK_STR(mock_wire, expected);
+}
+
+static void _run(const char* port) {
+    uint64_t in_call = 0;
+    uint64_t wall = 0;
+    _burst(&in_call, &wall);
+    _expect();
+
+#if DEBUG_TX_NONBLOCKING
+    CHECK_EQ(in_call, 0);
+    CHECK_EQ(debug_txDropped(), 0);
+#elif defined(USE_TI_MSPM0_DL)
+    // Each line starts on an idle UART: all but what the FIFO and the
+    // shifter take is spun away in the call
+    CHECK(in_call <= mock_wire_bytes * BYTE_NS);
+    CHECK(in_call >= (mock_wire_bytes - (FIFO_LEN + 1U) * LINES) * BYTE_NS);
+#else
+    CHECK_EQ(in_call, mock_wire_bytes * BYTE_NS);
+#endif
+    printf("%-28s %8.1f us wire time in the call, %6.0f ns host time per line\n",
+           port, in_call / 1000.0 / LINES, (double)wall / LINES);
+}
+
+#if DEBUG_TX_NONBLOCKING && defined(USE_STM32_HAL)
+// HAL_BUSY until the ring is full: the line dropped after that retries the
+// transfer, what the ring kept goes out and the next line reports the loss
+static void _refused(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    mock_stalled = true;
+    uint32_t dropped0 = debug_txDroppedLines(DEBUG_LEVEL_INFO);
+    const size_t line = strlen("[INFO] busy 000\n");
+    const int fit = (int)(DEBUG_TX_RING_LEN / line);
+    for (int i = 0; i < fit; i++) debug_info("busy %03d\n", i);
+    CHECK_EQ(mock_wire_len, 0U);
+
+    mock_stalled = false;
+    debug_info("busy %03d\n", fit);
+    mock_flush();
+    CHECK_EQ(debug_txDroppedLines(DEBUG_LEVEL_INFO) - dropped0, 1U);
+    CHECK_EQ(mock_wire_len, (size_t)fit * line);
+    for (int i = 0; i < fit; i++) {
+        char want[32];
+        snprintf(want, sizeof(want), "[INFO] busy %03d\n", i);
+        CHECK(strncmp(&mock_wire[(size_t)i * line], want, line) == 0);
+    }
+    debug_info("end\n");
+    mock_flush();
+    CHECK_STR(&mock_wire[(size_t)fit * line], "[WARNING] 1 lines dropped (1 info)\n[INFO] end\n");
+}
+#endif
+
+int main(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_init(TEST_PORT, false, false, false);
+#if DEBUG_TX_NONBLOCKING && defined(USE_TI_MSPM0_DL)
+    _run("non-blocking, TX FIFO:");
+
+    // Bursts of at most the FIFO, and the interrupt off once the ring is empty
+    for (uint32_t i = 0; i < mock_transfers && i < MOCK_XFER_LOG; i++) {
+        CHECK(mock_xfer_len[i] >= 1U && mock_xfer_len[i] <= FIFO_LEN);
+    }
+    CHECK(mock_transfers < mock_wire_bytes);
+    CHECK_EQ(mock_UART0.IMASK & DL_UART_INTERRUPT_TX, 0U);
+#elif DEBUG_TX_NONBLOCKING
+    _run("non-blocking, DMA:");
+
+    // No DMA channel linked: the same ring, sent with HAL_UART_Transmit_IT()
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    huart1.hdmatx = NULL;
+    _run("non-blocking, IT:");
+
+    _refused();
+#else
+    _run("blocking:");
+#endif
+    return 0;
+}
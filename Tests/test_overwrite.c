@@ -0,0 +1,288 @@
+/*******************************************************************************
+ * @file        test_overwrite.c
+ * @brief       DEBUG_OVERFLOW_OVERWRITE: a full TX ring makes room for the
+ *              new line by dropping the oldest whole lines, as long as no
+ *              transfer is reading them.
+ *
+ *              USB-CDC with the cable unplugged: plugged back, the newest
+ *              lines that fit come out, then the report of the older ones.
+ *              MSPM0 TX FIFO flooded faster than the wire: the FIFO stops in
+ *              the middle of a line, whose rest is kept, so every line on the
+ *              wire is whole and in order, and the missing ones are exactly
+ *              those counted and reported as dropped.
+ *              STM32 DMA and IT: lines are counted by what they were queued
+ *              as, not by their text, so a debug_log() line that reads like an
+ *              error or a drop report counts as a "log" line, a telemetry
+ *              packet as a packet. While a transfer runs, nothing is
+ *              overwritten: the new lines are dropped instead.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+
+#if DEBUG_TX_CDC_ENABLED
+    #include "usbd_cdc_if.h"
+    #define TEST_PORT NULL
+    #define BYTE_NS   1000U
+#elif DEBUG_PLATFORM_STM32
+    #include "usart.h"
+    #define TEST_PORT (&huart1)
+    #define BYTE_NS   86806U
+#else
+    #define TEST_PORT UART_0_INST
+    #define BYTE_NS   86806U    // 10 bits at 115200 baud
+#endif
+
+#define LINES 2000
+
+static const char _filler[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+#if DEBUG_TX_CDC_ENABLED
+int8_t CDC_TransmitCplt_FS(uint8_t* Buf, uint32_t* Len, uint8_t epnum) {
+    (void)Buf; (void)Len; (void)epnum;
+    debug_cdcTxCpltCallback();
+    return USBD_OK;
+}
+#elif DEBUG_PLATFORM_STM32
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+#else
+void UART_0_INST_IRQHandler(void) {
+    if (DL_UART_getPendingInterrupt(UART_0_INST) == DL_UART_IIDX_TX) {
+        debug_txCpltCallback(UART_0_INST);
+    }
+}
+#endif
+
+static size_t _line(char* buf, size_t size, int i) {
+    return (size_t)snprintf(buf, size, "%s #%d %.*s\n", (i % 7 == 0) ? "[ERROR]" : "[INFO]",
+                            i, i % 29, _filler);
+}
+
+static void _log(int i) {
+    if (i % 7 == 0) {
+        debug_error("#%d %.*s\n", i, i % 29, _filler);
+    } else {
+        debug_info("#%d %.*s\n", i, i % 29, _filler);
+    }
+}
+
+// "[WARNING] 12 lines dropped (1 error, 11 info)", maybe followed by ", 2
+// telemetry packets", or "[WARNING] 2 telemetry packets dropped": adds the
+// counts per level, then packets
+static bool _report(const char* p, uint32_t reported[DEBUG_LEVEL_NONE + 1]) {
+    static const char* const names[DEBUG_LEVEL_NONE] = { "log", "info", "ok", "success", "warning", "error" };
+    unsigned long total;
+    int n = 0;
+    if (sscanf(p, "[WARNING] %lu telemetry packets dropped\n%n", &total, &n) == 1 && n != 0) {
+        reported[DEBUG_LEVEL_NONE] += (uint32_t)total;
+        return true;
+    }
+    if (sscanf(p, "[WARNING] %lu lines dropped (%n", &total, &n) != 1 || n == 0) return false;
+
+    unsigned long sum = 0;
+    for (p += n; *p != ')'; ) {
+        unsigned long count;
+        char name[16];
+        CHECK(sscanf(p, "%lu %15[a-z]%n", &count, name, &n) == 2);
+        uint8_t level = 0;
+        while (level < DEBUG_LEVEL_NONE && strcmp(name, names[level]) != 0) level++;
+        CHECK(level < DEBUG_LEVEL_NONE);
+        reported[level] += (uint32_t)count;
+        sum += count;
+        p += n;
+        if (*p == ',') p += 2;
+    }
+    CHECK_EQ(sum, total);
+    if (sscanf(p, "), %lu telemetry packets\n", &total) == 1) reported[DEBUG_LEVEL_NONE] += (uint32_t)total;
+    return true;
+}
+
+// Lines 0..LINES-1 then "[INFO] end" on the wire: whole, in order, and the
+// missing ones counted and reported. `gone` are the dropped lines logged
+// before them that were no numbered lines, per level then packets, and
+// `gone_bytes` their bytes. Returns how many numbered lines arrived.
+static uint32_t _checkWire(const uint32_t gone[DEBUG_LEVEL_NONE + 1], uint64_t gone_bytes) {
+    uint32_t missing[DEBUG_LEVEL_NONE + 1];
+    uint32_t reported[DEBUG_LEVEL_NONE + 1] = {0};
+    uint64_t missing_bytes = gone_bytes;
+    uint32_t arrived = 0;
+    int next = 0;
+    bool end = false;
+
+    memcpy(missing, gone, sizeof(missing));
+    CHECK_EQ(strlen(mock_wire), mock_wire_len);     // no packet made it
+    for (char* p = mock_wire; *p != '\0'; ) {
+        char* nl = strchr(p, '\n');
+        CHECK(nl != NULL);
+        char want[128];
+        int i;
+        if (sscanf(p, "[%*[A-Z]] #%d ", &i) == 1) {
+            CHECK(!end && i >= next && i < LINES);
+            CHECK(strncmp(p, want, _line(want, sizeof(want), i)) == 0);
+            for (; next < i; next++) {
+                missing[next % 7 == 0 ? DEBUG_LEVEL_ERROR : DEBUG_LEVEL_INFO]++;
+                missing_bytes += _line(want, sizeof(want), next);
+            }
+            next = i + 1;
+            arrived++;
+        } else if (!_report(p, reported)) {
+            CHECK(strncmp(p, "[INFO] end\n", 11) == 0);
+            end = true;
+        }
+        p = nl + 1;
+    }
+    CHECK(end);
+    CHECK_EQ(next, LINES);      // the newest line is never the one dropped
+
+    for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) {
+        CHECK_EQ(debug_txDroppedLines(level), missing[level]);
+        CHECK_EQ(reported[level], missing[level]);
+    }
+    #if DEBUG_TELEMETRY
+    CHECK_EQ(debug_txDroppedPackets(), missing[DEBUG_LEVEL_NONE]);
+    #endif
+    CHECK_EQ(reported[DEBUG_LEVEL_NONE], missing[DEBUG_LEVEL_NONE]);
+    CHECK_EQ(debug_txDropped(), missing_bytes);
+    return arrived;
+}
+
+#if (DEBUG_PLATFORM_STM32 && !DEBUG_TX_CDC_ENABLED)
+static int16_t _samples[8];
+
+// Stalled port, so nothing is in flight: the oldest lines make room, and
+// the first three are a line that reads like an error, one that reads
+// like a drop report, and a telemetry packet
+static void _lookalikes(void) {
+    const char* fakes[] = { "[ERROR] not an error\n", "[WARNING] 5 lines dropped (5 error)\n" };
+
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_streamSamples(0, _samples, 8);
+    mock_flush();
+    uint64_t packet = mock_wire_len;
+
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    mock_stalled = true;
+    debug_log("%s", fakes[0]);
+    debug_log("%s", fakes[1]);
+    debug_streamSamples(0, _samples, 8);
+    for (int i = 0; i < LINES; i++) _log(i);
+    CHECK_EQ(mock_wire_len, 0U);
+
+    // the first line back takes its room, the report follows it
+    mock_stalled = false;
+    debug_info("end\n");
+    mock_flush();
+    debug_info("end\n");
+    mock_flush();
+
+    uint32_t gone[DEBUG_LEVEL_NONE + 1] = {0};
+    gone[DEBUG_LEVEL_LOG] = 2;
+    gone[DEBUG_LEVEL_NONE] = 1;
+    uint32_t arrived = _checkWire(gone, strlen(fakes[0]) + strlen(fakes[1]) + packet);
+    printf("look-alikes: dropped as 2 log lines and 1 packet, %lu of %d lines kept\n",
+           (unsigned long)arrived, LINES);
+}
+
+// A transfer in flight reads the ring: the new lines that do not fit are
+// dropped, the queued ones all go out
+static void _inFlight(bool dma) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    if (!dma) huart1.hdmatx = NULL;
+    uint32_t before[DEBUG_LEVEL_NONE];
+    for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) before[level] = debug_txDroppedLines(level);
+    uint32_t bytes = debug_txDropped();
+
+    debug_info("first\n");
+    CHECK(!mock_idle());
+    const size_t len = strlen("[INFO] in flight 000\n");
+    const int fit = (int)((DEBUG_TX_RING_LEN - strlen("[INFO] first\n")) / len);
+    for (int i = 0; i < 100; i++) debug_info("in flight %03d\n", i);
+    CHECK_EQ(mock_wire_len, 0U);
+    mock_flush();
+    debug_info("end\n");
+    mock_flush();
+
+    static char expected[DEBUG_TX_RING_LEN + 256];
+    size_t n = (size_t)snprintf(expected, sizeof(expected), "[INFO] first\n");
+    for (int i = 0; i < fit; i++) n += (size_t)snprintf(&expected[n], sizeof(expected) - n, "[INFO] in flight %03d\n", i);
+    snprintf(&expected[n], sizeof(expected) - n, "[WARNING] %d lines dropped (%d info)\n[INFO] end\n",
+             100 - fit, 100 - fit);
+    CHECK_STR(mock_wire, expected);
+    for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) {
+        CHECK_EQ(debug_txDroppedLines(level) - before[level],
+                 (level == DEBUG_LEVEL_INFO) ? (uint32_t)(100 - fit) : 0U);
+    }
+    CHECK_EQ(debug_txDropped() - bytes, (uint32_t)((100 - fit) * len));
+    printf("%s in flight: %d lines queued kept, %d new ones dropped\n", dma ? "DMA" : "IT", fit, 100 - fit);
+}
+#endif
+
+int main(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_init(TEST_PORT, false, false, false);
+
+#if DEBUG_TX_CDC_ENABLED
+    // Unplugged: the ring keeps the newest lines that fit, each older one is
+    // dropped as a newer one needs its room
+    mock_stalled = true;
+    for (int i = 0; i < LINES; i++) _log(i);
+    CHECK_EQ(mock_wire_len, 0U);
+
+    // Plugged back, the next line restarts the transfers and takes its
+    // room from the oldest; the report of the dropped lines follows
+    mock_stalled = false;
+    debug_info("end\n");
+    mock_flush();
+    debug_info("back\n");
+    mock_flush();
+
+    char buf[128];
+    size_t kept = strlen("[INFO] end\n");
+    uint32_t dropped[DEBUG_LEVEL_NONE] = {0};
+    int first = LINES;
+    while (first > 0 && kept + _line(buf, sizeof(buf), first - 1) <= DEBUG_TX_RING_LEN) {
+        kept += _line(buf, sizeof(buf), --first);
+    }
+    for (int i = 0; i < first; i++) dropped[i % 7 == 0 ? DEBUG_LEVEL_ERROR : DEBUG_LEVEL_INFO]++;
+
+    static char expected[DEBUG_TX_RING_LEN + 256];
+    size_t n = 0;
+    for (int i = first; i < LINES; i++) n += _line(&expected[n], sizeof(expected) - n, i);
+    snprintf(&expected[n], sizeof(expected) - n,
+             "[INFO] end\n[WARNING] %d lines dropped (%lu error, %lu info)\n[INFO] back\n", first,
+             (unsigned long)dropped[DEBUG_LEVEL_ERROR], (unsigned long)dropped[DEBUG_LEVEL_INFO]);
+    CHECK_STR(mock_wire, expected);
+    CHECK_EQ(debug_txDroppedLines(DEBUG_LEVEL_ERROR), dropped[DEBUG_LEVEL_ERROR]);
+    CHECK_EQ(debug_txDroppedLines(DEBUG_LEVEL_INFO), dropped[DEBUG_LEVEL_INFO]);
+    printf("unplugged: %d lines, the newest %d kept\n", LINES, LINES - first);
+#elif DEBUG_PLATFORM_STM32
+    for (int i = 0; i < 8; i++) _samples[i] = (int16_t)(i * 1000);
+    _lookalikes();
+    _inFlight(true);
+    _inFlight(false);
+#else
+    // Flooded: a line every 10 bytes of wire time, about a third of what
+    // the lines need. The short pauses let a report in, which the flood
+    // after them drops again: its counts go to the next one.
+    for (int i = 0; i < LINES; i++) {
+        _log(i);
+        mock_advance(((i + 1) % 50 == 0 ? 200U : 10U) * BYTE_NS);
+    }
+    mock_flush();
+    debug_info("end\n");
+    mock_flush();
+    const uint32_t gone[DEBUG_LEVEL_NONE + 1] = {0};
+    uint32_t arrived = _checkWire(gone, 0);
+    CHECK(arrived > 0U && arrived < LINES);
+    printf("flooded: %d lines, %lu on the wire, the rest dropped oldest first\n",
+           LINES, (unsigned long)arrived);
+#endif
+    return 0;
+}
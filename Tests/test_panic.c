@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * @file        test_panic.c
+ * @brief       DEBUG_PANIC on the MSPM0 UART mock, polled through the TX
+ *              FIFO registers. debug_fault() gets a hand-built exception
+ *              frame and EXC_RETURN, as DEBUG_FAULT_HANDLER() passes them,
+ *              and must print each register where it belongs, after what the
+ *              TX ring still held, then reset. Built for a Cortex-M0+ and,
+ *              with STUB_CORE_M=4, for a core with the fault status
+ *              registers, whose set bits are named.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+
+#define BYTE_NS 86806U      // 10 bits at 115200 baud
+
+void UART_0_INST_IRQHandler(void) {
+    if (DL_UART_getPendingInterrupt(UART_0_INST) == DL_UART_IIDX_TX) {
+        debug_txCpltCallback(UART_0_INST);
+    }
+}
+
+static jmp_buf _reset;
+
+static void _setup(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    mock_reset_point = &_reset;
+}
+
+// The frame lines of the dump
+static size_t _frame(char* out, size_t size, const debug_fault_frame_t* f, uint32_t exc_return) {
+    return (size_t)snprintf(out, size,
+        "  PC   0x%08lX  LR   0x%08lX  xPSR 0x%08lX\n"
+        "  R0   0x%08lX  R1   0x%08lX  R2   0x%08lX\n"
+        "  R3   0x%08lX  R12  0x%08lX  SP   0x%08lX\n"
+        "  EXC_RETURN 0x%08lX\n",
+        (unsigned long)f->pc, (unsigned long)f->lr, (unsigned long)f->xpsr,
+        (unsigned long)f->r0, (unsigned long)f->r1, (unsigned long)f->r2,
+        (unsigned long)f->r3, (unsigned long)f->r12, (unsigned long)(uint32_t)(uintptr_t)f,
+        (unsigned long)exc_return);
+}
+
+int main(void) {
+    debug_init(UART_0_INST, false, false, false);
+    debug_fault_frame_t frame = {
+        .r0 = 0x00000001U, .r1 = 0x20001FF0U, .r2 = 0xDEADBEEFU, .r3 = 0x00000000U,
+        .r12 = 0x0000000CU, .lr = 0x08000F01U, .pc = 0x08001234U, .xpsr = 0x21000000U,
+    };
+    char expected[1024];
+    size_t n;
+
+    // A line still in the ring when the fault hits: only its first bytes
+    // are in the FIFO
+    _setup();
+    debug_info("before the fault\n");
+    CHECK_EQ(mock_wire_len, 0U);
+#if (STUB_CORE_M >= 3)
+    mock_SCB.CFSR = (1UL << 1) | (1UL << 7) | (1UL << 25);     // DACCVIOL, MMARVALID, DIVBYZERO
+    mock_SCB.HFSR = 1UL << 30;                                  // FORCED
+    mock_SCB.MMFAR = 0x20000100U;
+    mock_SCB.BFAR = 0xE000ED38U;
+#endif
+    if (setjmp(_reset) == 0) {
+        debug_fault(&frame, 0xFFFFFFFDU);       // thread mode, PSP
+    }
+    CHECK_EQ(mock_resets, 1U);
+    mock_flush();
+
+    n = (size_t)snprintf(expected, sizeof(expected), "[INFO] before the fault\n[ERROR] FAULT\n");
+    n += _frame(&expected[n], sizeof(expected) - n, &frame, 0xFFFFFFFDU);
+#if (STUB_CORE_M >= 3)
+    snprintf(&expected[n], sizeof(expected) - n,
+        "  CFSR 0x02000082  HFSR 0x40000000\n"
+        "  MMFAR 0x20000100  BFAR 0xE000ED38\n"
+        "  DACCVIOL DIVBYZERO FORCED\n");
+#endif
+    CHECK_STR(mock_wire, expected);
+
+    // Another frame, from handler mode; no fault status bit set, so no line
+    // of names
+    _setup();
+    frame.pc = 0x00000A5EU;
+    frame.lr = 0xFFFFFFFFU;
+    frame.r3 = 0x80000000U;
+#if (STUB_CORE_M >= 3)
+    mock_SCB.CFSR = 0U;
+    mock_SCB.HFSR = 0U;
+#endif
+    if (setjmp(_reset) == 0) {
+        debug_fault(&frame, 0xFFFFFFF1U);
+    }
+    CHECK_EQ(mock_resets, 1U);
+    mock_flush();
+    n = (size_t)snprintf(expected, sizeof(expected), "[ERROR] FAULT\n");
+    n += _frame(&expected[n], sizeof(expected) - n, &frame, 0xFFFFFFF1U);
+#if (STUB_CORE_M >= 3)
+    snprintf(&expected[n], sizeof(expected) - n,
+        "  CFSR 0x00000000  HFSR 0x00000000\n"
+        "  MMFAR 0x20000100  BFAR 0xE000ED38\n");
+#endif
+    CHECK_STR(mock_wire, expected);
+
+    // debug_panic(): the reason and an 8-digit caller address
+    _setup();
+    if (setjmp(_reset) == 0) {
+        debug_panic("heap corrupted");
+    }
+    CHECK_EQ(mock_resets, 1U);
+    mock_flush();
+    unsigned long caller;
+    int end = 0;
+    CHECK(sscanf(mock_wire, "[ERROR] PANIC: heap corrupted\n  caller 0x%8lX\n%n", &caller, &end) == 1);
+    CHECK_EQ((size_t)end, mock_wire_len);
+    CHECK(caller != 0U);
+
+    printf("fault dump: frame, EXC_RETURN%s in place\n",
+           (STUB_CORE_M >= 3) ? " and fault status registers" : "");
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * @file        test_prefix.c
+ * @brief       Each level's line starts with exactly its *_TYPE_PLAIN macro
+ *              with colors off and its *_TYPE macro with colors on, after
+ *              the timestamp when there is one: the prefix table's texts and
+ *              lengths against the header's literals.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define TICK_BASE 3723004U      // 01:02:03.004
+
+static const char* const _plain[DEBUG_LEVEL_NONE] = {
+    "", INFO_TYPE_PLAIN, OK_TYPE_PLAIN, SUCCESS_TYPE_PLAIN, WARNING_TYPE_PLAIN, ERROR_TYPE_PLAIN,
+};
+static const char* const _colored[DEBUG_LEVEL_NONE] = {
+    "", INFO_TYPE, OK_TYPE, SUCCESS_TYPE, WARNING_TYPE, ERROR_TYPE,
+};
+
+// One line of `level` with the text "m <level>\n"
+static void _line(uint8_t level) {
+    switch (level) {
+        case DEBUG_LEVEL_LOG:     debug_log("m %d\n", level); break;
+        case DEBUG_LEVEL_INFO:    debug_info("m %d\n", level); break;
+        case DEBUG_LEVEL_OK:      debug_ok("m %d\n", level); break;
+        case DEBUG_LEVEL_SUCCESS: debug_success("m %d\n", level); break;
+        case DEBUG_LEVEL_WARNING: debug_warning("m %d\n", level); break;
+        default:                  debug_error("m %d\n", level); break;
+    }
+}
+
+int main(void) {
+    char want[128];
+
+    for (int pass = 0; pass < 4; pass++) {
+        bool color = (pass & 1) != 0;
+        bool timestamp = (pass & 2) != 0;
+        mock_reset();
+        mock_tick_base = TICK_BASE;
+        debug_init(&huart1, timestamp, color, false);
+        const char* ts = timestamp ? "[01:02:03.004] " : "";
+        for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) {
+            mock_reset();
+            mock_tick_base = TICK_BASE;
+            _line(level);
+            snprintf(want, sizeof(want), "%s%sm %d\n", ts, color ? _colored[level] : _plain[level], level);
+            CHECK_STR(mock_wire, want);
+        }
+    }
+
+    printf("prefix: every level, plain and colored, with and without timestamps\n");
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * @file        test_prefix.cpp
+ * @brief       The C++ level prefixes, as in test_prefix.c: each level's line
+ *              starts with exactly its *_TYPE_PLAIN or *_TYPE macro, after
+ *              the timestamp when there is one.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define TICK_BASE 3723004U      // 01:02:03.004
+
+static ElegantDebug dbg(&huart1, false, false);
+
+static const char* const _plain[DEBUG_LEVEL_NONE] = {
+    "", INFO_TYPE_PLAIN, OK_TYPE_PLAIN, SUCCESS_TYPE_PLAIN, WARNING_TYPE_PLAIN, ERROR_TYPE_PLAIN,
+};
+static const char* const _colored[DEBUG_LEVEL_NONE] = {
+    "", INFO_TYPE, OK_TYPE, SUCCESS_TYPE, WARNING_TYPE, ERROR_TYPE,
+};
+
+// One line of `level` with the text "m <level>\n"
+static void _line(uint8_t level) {
+    switch (level) {
+        case DEBUG_LEVEL_LOG:     dbg.log("m %d\n", level); break;
+        case DEBUG_LEVEL_INFO:    dbg.info("m %d\n", level); break;
+        case DEBUG_LEVEL_OK:      dbg.ok("m %d\n", level); break;
+        case DEBUG_LEVEL_SUCCESS: dbg.success("m %d\n", level); break;
+        case DEBUG_LEVEL_WARNING: dbg.warning("m %d\n", level); break;
+        default:                  dbg.error("m %d\n", level); break;
+    }
+}
+
+int main() {
+    char want[128];
+
+    for (int pass = 0; pass < 4; pass++) {
+        bool color = (pass & 1) != 0;
+        bool timestamp = (pass & 2) != 0;
+        mock_reset();
+        mock_tick_base = TICK_BASE;
+        dbg.setTimestampEnabled(timestamp);
+        dbg.setColorEnabled(color);
+        const char* ts = timestamp ? "[01:02:03.004] " : "";
+        for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) {
+            mock_reset();
+            mock_tick_base = TICK_BASE;
+            _line(level);
+            snprintf(want, sizeof(want), "%s%sm %d\n", ts, color ? _colored[level] : _plain[level], level);
+            CHECK_STR(mock_wire, want);
+        }
+    }
+
+    printf("prefix (C++): every level, plain and colored, with and without timestamps\n");
+    return 0;
+}
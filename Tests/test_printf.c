@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * @file        test_printf.c
+ * @brief       The built-in printf engine (DEBUG_BUILTIN_PRINTF) against the
+ *              host's snprintf(), and its documented differences for floats
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The line debug_log() sends must be what snprintf() makes of the same call
+#define SAME(...)                                                               \
+    do {                                                                        \
+        char _want[256];                                                        \
+        snprintf(_want, sizeof(_want), __VA_ARGS__);                            \
+        mock_reset();                                                           \
+        debug_log(__VA_ARGS__);                                                 \
+        CHECK_STR(mock_wire, _want);                                            \
+    } while (0)
+
+#define GIVES(expected, ...)                                                    \
+    do {                                                                        \
+        mock_reset();                                                           \
+        debug_log(__VA_ARGS__);                                                 \
+        CHECK_STR(mock_wire, expected);                                         \
+    } while (0)
+
+int main(void) {
+    debug_init(&huart1, false, false, false);
+
+    // Integers, flags, width and precision
+    SAME("%d|%i|%u", -42, 7, 4000000000U);
+    SAME("%5d|%-5d|%05d|%+d|% d|%+d", 42, 42, 42, 42, 42, -42);
+    SAME("%x|%X|%#x|%#X|%o|%#o|%#x", 0xbeefU, 0xbeefU, 255U, 255U, 8U, 8U, 0U);
+    SAME("%hhd|%hhu|%hd|%hu|%ld|%lu", (signed char)-1, (unsigned char)200, (short)-2, (unsigned short)65535, -3L, 3UL);
+    SAME("%lld|%llu|%llx", -4000000000000LL, 18446744073709551615ULL, 0x123456789abcULL);
+    SAME("%zu|%td|%jd|%ju", (size_t)5, (ptrdiff_t)-6, (intmax_t)INT64_MIN, (uintmax_t)UINT64_MAX);
+    SAME("%.3d|%8.3d|%-8.3d|%.0d|%5.0d", 5, -5, 5, 0, 0);
+    SAME("%*d|%-*d|%*d|%.*d", 6, 1, 6, 2, -6, 3, 4, 7);
+    SAME("%d|%d", INT32_MIN, INT32_MAX);
+
+    // Characters and strings
+    SAME("%c|%s|%.3s|%10s|%-10s|%%|%5c", 'x', "str", "abcdef", "r", "l", 'y');
+    SAME("%.*s|%*s", 2, "abc", 4, "z");
+
+    // Floats in the range the engine covers
+    SAME("%f|%.2f|%.0f|%10.3f|%-10.1f|%+f|%08.3f", 1.5, 2.675, 2.5, -3.14159, 0.25, 1.0, -1.5);
+    SAME("%.0f|%.0f|%.0f|%#.0f", 0.5, 1.5, 3.5, 7.0);
+    SAME("%f|%f|%.9f", 123456789.125, 1e-7, 0.123456789);
+    SAME("%f|%+f|% f", 0.0, 0.0, 2.0);
+    SAME("%f|%f|%.1f", -0.0, -1e-9, -0.04);
+    SAME("%f|%f|%f|%5f|%-5f|", (double)NAN, (double)INFINITY, -(double)INFINITY, (double)INFINITY, (double)INFINITY);
+    SAME("%.3f|%.6f", 18446744073709.5, 1.8e18);
+
+    // Scaled products that round to exactly .5: above, below and a true tie
+    SAME("%.1f|%.2f|%.6f|%.6f|%.1f", 0.05, 1.005, 2.8260535, 0.0680965, 0.25);
+
+    // Random values from 2^-50 to 2^60 at every precision: the last digit
+    // must round like snprintf(), also where the decimal value is close to
+    // a tie
+    uint32_t seed = 12345U;
+    for (int i = 0; i < 20000; i++) {
+        seed = seed * 1103515245U + 12345U;
+        int exp = (int)(seed >> 8) % 110 - 50;
+        seed = seed * 1103515245U + 12345U;
+        double v = ldexp(1.0 + (double)(seed >> 1) / 2147483648.0, exp);
+        if (seed & 1U) v = -v;
+        SAME("%.*f", i % 10, v);
+    }
+
+    // Documented differences from vsnprintf()
+    GIVES("1234.500000|0.250000", "%e|%g", 1234.5, 0.25);
+    GIVES("0.100000000", "%.12f", 0.1);
+    GIVES("ovf|-ovf", "%f|%f", 1e20, -1e20);
+
+    // Truncated at the line buffer, like vsnprintf()
+    char big[DEBUG_BUFFER_LEN * 2];
+    memset(big, 'a', sizeof(big) - 1U);
+    big[sizeof(big) - 1U] = '\0';
+    mock_reset();
+    debug_log("%s", big);
+    CHECK(mock_wire_len > 0U && mock_wire_len < DEBUG_BUFFER_LEN + 128U);
+    CHECK(strspn(mock_wire, "a") == mock_wire_len || mock_wire[mock_wire_len - 1U] == '\n');
+
+    printf("built-in printf matches snprintf() on the supported conversions\n");
+    return 0;
+}
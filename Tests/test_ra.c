@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * @file        test_ra.c
+ * @brief       Renesas RA SCI UART: R_SCI_UART_Write() returns at once and
+ *              keeps reading the buffer until UART_EVENT_TX_COMPLETE, and
+ *              refuses a second write with FSP_ERR_IN_USE meanwhile. Lines
+ *              logged during a write are queued in the ring and sent from the
+ *              completion callback; none is lost or overwritten, and a write
+ *              refused by a UART used elsewhere is retried.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "hal_data.h"
+#include "mock_port.h"
+
+#define BYTE_NS 86806U      // 10 bits at 115200 baud
+#define LINES   300
+
+static bool _chain = true;
+
+// The callback set in the FSP configurator
+void user_uart_callback(uart_callback_args_t* p_args) {
+    if (_chain) debug_txCpltCallback(p_args);
+}
+
+static char _expected[LINES * 64];
+static size_t _expected_len;
+
+static void _log(int i) {
+    debug_info("sci %d: %.*s\n", i, i % 29, "abcdefghijklmnopqrstuvwxyz012");
+    _expected_len += (size_t)snprintf(&_expected[_expected_len], sizeof(_expected) - _expected_len,
+                                      "[INFO] sci %d: %.*s\n", i, i % 29, "abcdefghijklmnopqrstuvwxyz012");
+}
+
+// What a caller does with its stack after logging, while the SCI still
+// reads the line
+static void __attribute__((noinline)) _scribble(void) {
+    volatile char junk[1024];
+    for (size_t i = 0; i < sizeof(junk); i++) junk[i] = '#';
+    (void)junk[0];
+}
+
+static void _setup(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    _chain = true;
+    _expected_len = 0;
+}
+
+int main(void) {
+    debug_init(&g_uart0, false, false, false);
+
+    // Bursts of 8 lines, each logged while the write before is running, and
+    // the stack reused before the write ends: the ring keeps them intact
+    _setup();
+    for (int i = 0; i < LINES; i++) {
+        _log(i);
+        _scribble();
+        if ((i + 1) % 8 == 0) mock_advance(300U * BYTE_NS);
+    }
+    mock_flush();
+    CHECK_STR(mock_wire, _expected);
+    CHECK_EQ(debug_txDropped(), 0U);
+    CHECK(mock_transfers < LINES / 2);      // queued lines go out together
+    for (uint32_t i = 0; i < mock_transfers && i < MOCK_XFER_LOG; i++) {
+        CHECK(mock_xfer_len[i] <= DEBUG_TX_RING_LEN);
+    }
+    printf("%d lines in %lu writes\n", LINES, (unsigned long)mock_transfers);
+
+    // Every third write refused with FSP_ERR_IN_USE: retried on the next
+    // line or completion
+    _setup();
+    mock_busy_every = 3U;
+    for (int i = 0; i < LINES; i++) {
+        _log(i);
+        if ((i + 1) % 8 == 0) mock_advance(300U * BYTE_NS);
+    }
+    mock_flush();
+    mock_busy_every = 0U;
+    _log(LINES);
+    mock_flush();
+    CHECK_STR(mock_wire, _expected);
+    CHECK_EQ(debug_txDropped(), 0U);
+
+    // Without the callback forwarded nothing after the first write goes out
+    _setup();
+    _chain = false;
+    _log(0);
+    mock_flush();
+    _log(1);
+    _log(2);
+    mock_flush();
+    CHECK_EQ(mock_transfers, 1U);
+    _chain = true;
+    uart_callback_args_t args = { g_uart0_cfg.channel, UART_EVENT_TX_COMPLETE, 0U, NULL };
+    debug_txCpltCallback(&args);
+    mock_flush();
+    CHECK_STR(mock_wire, _expected);
+
+    // Only UART_EVENT_TX_COMPLETE of our channel ends the write: until it
+    // comes, the line being sent keeps its room in the ring
+    _setup();
+    debug_info("sci %02d\n", 0);
+    args.event = UART_EVENT_TX_DATA_EMPTY;
+    debug_txCpltCallback(&args);
+    args.channel = g_uart0_cfg.channel + 1U;
+    args.event = UART_EVENT_TX_COMPLETE;
+    debug_txCpltCallback(&args);
+
+    const size_t line = strlen("[INFO] sci 00\n");
+    const uint32_t fit = (uint32_t)((DEBUG_TX_RING_LEN - line) / line);
+    for (int i = 1; i < 100; i++) debug_info("sci %02d\n", i);
+    CHECK_EQ(debug_txDroppedLines(DEBUG_LEVEL_INFO), 99U - fit);
+    mock_flush();
+    CHECK_EQ(mock_wire_len, (1U + fit) * line);
+    for (uint32_t i = 0; i <= fit; i++) {
+        char want[32];
+        snprintf(want, sizeof(want), "[INFO] sci %02lu\n", (unsigned long)i);
+        CHECK(strncmp(&mock_wire[i * line], want, line) == 0);
+    }
+
+    printf("RA SCI UART: writes chained from UART_EVENT_TX_COMPLETE, no line lost\n");
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * @file        test_ratelimit.c
+ * @brief       debug_once(), debug_everyN() and debug_everyMs(): which calls
+ *              of a site get through, the "[N suppressed] " count on the
+ *              line after skipped ones, and skipped calls leaving their
+ *              arguments unevaluated. everyMs() runs on the ms tick across
+ *              its wrap: HAL_GetTick() on STM32, the library's own tick on
+ *              MSPM0.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+
+#if defined(USE_STM32_HAL)
+    #include "usart.h"
+    #define TEST_PORT (&huart1)
+#elif defined(USE_TI_MSPM0_DL)
+    #define TEST_PORT UART_0_INST
+#endif
+
+static int _evaluated;
+
+static int _arg(int v) {
+    _evaluated++;
+    return v;
+}
+
+// Each site has its own state, so each N its own function
+static void _every0(int i) { debug_everyN(INFO, 0, "n0 %d\n", _arg(i)); }
+static void _every1(int i) { debug_everyN(INFO, 1, "n1 %d\n", _arg(i)); }
+static void _every3(int i) { debug_everyN(WARNING, 3, "n3 %d\n", _arg(i)); }
+static void _once(int i) { debug_once(ERROR, "once %d\n", _arg(i)); }
+static void _everyMs(int i) { debug_everyMs(OK, 100, "ms %d\n", _arg(i)); }
+
+// Runs `site` for i = 0 .. calls-1; the pattern of calls that printed, '1'
+// or '.', and the lines they printed
+static void _run(void (*site)(int), int calls, char* pattern, char* lines, size_t size) {
+    lines[0] = '\0';
+    for (int i = 0; i < calls; i++) {
+        size_t at = mock_wire_len;
+        int before = _evaluated;
+        site(i);
+        mock_flush();
+        bool printed = mock_wire_len != at;
+        CHECK_EQ(_evaluated - before, printed ? 1 : 0);
+        pattern[i] = printed ? '1' : '.';
+        strncat(lines, &mock_wire[at], size - strlen(lines) - 1U);
+    }
+    pattern[calls] = '\0';
+}
+
+int main(void) {
+    char pattern[64];
+    char lines[1024];
+
+    mock_reset();
+    debug_init(TEST_PORT, false, false, false);
+
+    _run(_every0, 4, pattern, lines, sizeof(lines));
+    CHECK_STR(pattern, "1111");
+    CHECK_STR(lines, "[INFO] n0 0\n[INFO] n0 1\n[INFO] n0 2\n[INFO] n0 3\n");
+
+    _run(_every1, 4, pattern, lines, sizeof(lines));
+    CHECK_STR(pattern, "1111");
+
+    _run(_every3, 10, pattern, lines, sizeof(lines));
+    CHECK_STR(pattern, "1..1..1..1");
+    CHECK_STR(lines,
+        "[WARNING] n3 0\n"
+        "[WARNING] [2 suppressed] n3 3\n"
+        "[WARNING] [2 suppressed] n3 6\n"
+        "[WARNING] [2 suppressed] n3 9\n");
+
+    _run(_once, 5, pattern, lines, sizeof(lines));
+    CHECK_STR(pattern, "1....");
+    CHECK_STR(lines, "[ERROR] once 0\n");
+
+    // 100 ms apart, starting 30 ms before the tick wraps: the skips count
+    // up across the wrap and the next line gets through on time
+    mock_reset();
+    mock_tick_base = 0xFFFFFFFFU - 30U;
+    mock_advance(1);        // the MSPM0 tick variable follows mock_tick_base
+    debug_init(TEST_PORT, false, false, false);
+    static const uint32_t at_ms[] = { 0, 10, 31, 99, 100, 150, 199, 200, 5000, 5001 };
+    char got[64];
+    for (size_t i = 0; i < sizeof(at_ms) / sizeof(at_ms[0]); i++) {
+        mock_advance((uint64_t)at_ms[i] * 1000000U + 1U - mock_now());
+        size_t at = mock_wire_len;
+        int before = _evaluated;
+        _everyMs((int)i);
+        mock_flush();
+        got[i] = (mock_wire_len != at) ? '1' : '.';
+        CHECK_EQ(_evaluated - before, (got[i] == '1') ? 1 : 0);
+        got[i + 1] = '\0';
+    }
+    CHECK_STR(got, "1...1..11.");
+    CHECK_STR(mock_wire, "[OK] ms 0\n[OK] [3 suppressed] ms 4\n[OK] [2 suppressed] ms 7\n[OK] ms 8\n");
+
+    printf("rate limits: every 0, 1 and 3 calls, once, every 100 ms across the tick wrap\n");
+    return 0;
+}
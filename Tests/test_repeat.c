@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * @file        test_repeat.c
+ * @brief       DEBUG_REPEAT_SUPPRESS: back-to-back copies of a line collapse
+ *              into one "last message repeated N times" line per level, each
+ *              level keeps its own last line, two different lines with the
+ *              same FNV-1a hash and length are both shown, pending counts go
+ *              out after DEBUG_REPEAT_TIMEOUT_MS with the next line or from
+ *              debug_repeatPoll(), and turning the filter off reports them.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define MS 1000000U
+
+// The wire since `at`; the wire is then taken as read
+static const char* _since(size_t* at) {
+    const char* s = &mock_wire[*at];
+    *at = mock_wire_len;
+    return s;
+}
+
+int main(void) {
+    size_t at = 0;
+
+    mock_reset();
+    debug_init(&huart1, false, false, false);
+
+    // Collapsed up to the next different line of the level
+    for (int i = 0; i < 5; i++) debug_info("poll timeout\n");
+    debug_info("poll ok\n");
+    CHECK_STR(_since(&at),
+        "[INFO] poll timeout\n"
+        "[INFO] last message repeated 4 times\n"
+        "[INFO] poll ok\n");
+
+    // A single copy is shown again as soon as it is not the last line
+    debug_info("a\n");
+    debug_info("b\n");
+    debug_info("a\n");
+    CHECK_STR(_since(&at), "[INFO] a\n[INFO] b\n[INFO] a\n");
+
+    // Levels interleaved: each one keeps its own last line and count
+    debug_warning("a\n");
+    debug_info("a\n");
+    debug_warning("a\n");
+    debug_info("a\n");
+    debug_warning("a\n");
+    debug_error("b\n");
+    debug_info("c\n");
+    CHECK_STR(_since(&at),
+        "[WARNING] a\n"
+        "[ERROR] b\n"
+        "[INFO] last message repeated 2 times\n"
+        "[INFO] c\n");
+    debug_warning("d\n");
+    CHECK_STR(_since(&at), "[WARNING] last message repeated 2 times\n[WARNING] d\n");
+
+    // Same length and hash, different text: both are shown
+    debug_info("key 0174628\n");
+    debug_info("key 1872066\n");
+    debug_info("key 1872066\n");
+    debug_info("key 0174628\n");
+    CHECK_STR(_since(&at),
+        "[INFO] key 0174628\n"
+        "[INFO] key 1872066\n"
+        "[INFO] last message repeated 1 times\n"
+        "[INFO] key 0174628\n");
+
+    // Timeout, counted from the first dropped copy, reported with the next
+    // line of any level
+    debug_ok("x\n");
+    debug_ok("x\n");
+    mock_advance(400U * MS);
+    debug_ok("x\n");
+    mock_advance(599U * MS);
+    debug_error("not yet\n");
+    CHECK_STR(_since(&at), "[OK] x\n[ERROR] not yet\n");
+    mock_advance(1U * MS);
+    debug_error("now\n");
+    CHECK_STR(_since(&at), "[OK] last message repeated 2 times\n[ERROR] now\n");
+    // ... after which the same line starts a new count
+    debug_ok("x\n");
+    debug_ok("x\n");
+    debug_ok("y\n");
+    CHECK_STR(_since(&at), "[OK] last message repeated 2 times\n[OK] y\n");
+
+    // ... or from debug_repeatPoll() without another line
+    debug_success("z\n");
+    debug_success("z\n");
+    debug_success("z\n");
+    debug_repeatPoll();
+    mock_advance(999U * MS);
+    debug_repeatPoll();
+    CHECK_STR(_since(&at), "[SUCCESS] z\n");
+    mock_advance(1U * MS);
+    debug_repeatPoll();
+    CHECK_STR(_since(&at), "[SUCCESS] last message repeated 2 times\n");
+    debug_repeatPoll();
+    CHECK_EQ(mock_wire_len, at);
+
+    // Turned off: the pending counts of every level are reported, in level
+    // order, and the last lines forgotten
+    debug_success("z\n");
+    debug_log("l\n");
+    debug_log("l\n");
+    debug_log("l\n");
+    debug_error("e\n");
+    debug_error("e\n");
+    CHECK_STR(_since(&at), "l\n[ERROR] e\n");
+    debug_setRepeatSuppressEnabled(false);
+    CHECK_STR(_since(&at),
+        "last message repeated 2 times\n"
+        "[SUCCESS] last message repeated 1 times\n"
+        "[ERROR] last message repeated 1 times\n");
+    debug_setRepeatSuppressEnabled(false);
+    CHECK_EQ(mock_wire_len, at);
+    debug_error("e\n");
+    debug_error("e\n");
+    CHECK_STR(_since(&at), "[ERROR] e\n[ERROR] e\n");
+
+    // On again: nothing is remembered from before
+    debug_setRepeatSuppressEnabled(true);
+    debug_error("e\n");
+    debug_error("e\n");
+    debug_setRepeatSuppressEnabled(false);
+    CHECK_STR(_since(&at), "[ERROR] e\n[ERROR] last message repeated 1 times\n");
+
+    printf("repeat: collapsed per level, hash collisions shown, timeout by line and by poll\n");
+    return 0;
+}
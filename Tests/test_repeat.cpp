@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * @file        test_repeat.cpp
+ * @brief       DEBUG_REPEAT_SUPPRESS through the C++ class, as in
+ *              test_repeat.c: collapsing per level, lines with the same hash
+ *              and length, the timeout with the next line and from
+ *              repeatPoll(), and setRepeatSuppressEnabled(false) reporting
+ *              the pending counts.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define MS 1000000U
+
+static ElegantDebug dbg(&huart1, false, false);
+
+// The wire since `at`; the wire is then taken as read
+static const char* _since(size_t* at) {
+    const char* s = &mock_wire[*at];
+    *at = mock_wire_len;
+    return s;
+}
+
+int main() {
+    size_t at = 0;
+
+    mock_reset();
+
+    // Collapsed up to the next different line of the level
+    for (int i = 0; i < 5; i++) dbg.info("poll timeout\n");
+    dbg.info("poll ok\n");
+    CHECK_STR(_since(&at),
+        "[INFO] poll timeout\n"
+        "[INFO] last message repeated 4 times\n"
+        "[INFO] poll ok\n");
+
+    // A single copy is shown again as soon as it is not the last line
+    dbg.info("a\n");
+    dbg.info("b\n");
+    dbg.info("a\n");
+    CHECK_STR(_since(&at), "[INFO] a\n[INFO] b\n[INFO] a\n");
+
+    // Levels interleaved: each one keeps its own last line and count
+    dbg.warning("a\n");
+    dbg.info("a\n");
+    dbg.warning("a\n");
+    dbg.info("a\n");
+    dbg.warning("a\n");
+    dbg.error("b\n");
+    dbg.info("c\n");
+    CHECK_STR(_since(&at),
+        "[WARNING] a\n"
+        "[ERROR] b\n"
+        "[INFO] last message repeated 2 times\n"
+        "[INFO] c\n");
+    dbg.warning("d\n");
+    CHECK_STR(_since(&at), "[WARNING] last message repeated 2 times\n[WARNING] d\n");
+
+    // Same length and hash, different text: both are shown
+    dbg.info("key 0174628\n");
+    dbg.info("key 1872066\n");
+    dbg.info("key 1872066\n");
+    dbg.info("key 0174628\n");
+    CHECK_STR(_since(&at),
+        "[INFO] key 0174628\n"
+        "[INFO] key 1872066\n"
+        "[INFO] last message repeated 1 times\n"
+        "[INFO] key 0174628\n");
+
+    // Timeout, counted from the first dropped copy, reported with the next
+    // line of any level
+    dbg.ok("x\n");
+    dbg.ok("x\n");
+    mock_advance(400U * MS);
+    dbg.ok("x\n");
+    mock_advance(599U * MS);
+    dbg.error("not yet\n");
+    CHECK_STR(_since(&at), "[OK] x\n[ERROR] not yet\n");
+    mock_advance(1U * MS);
+    dbg.error("now\n");
+    CHECK_STR(_since(&at), "[OK] last message repeated 2 times\n[ERROR] now\n");
+    // ... after which the same line starts a new count
+    dbg.ok("x\n");
+    dbg.ok("x\n");
+    dbg.ok("y\n");
+    CHECK_STR(_since(&at), "[OK] last message repeated 2 times\n[OK] y\n");
+
+    // ... or from dbg.repeatPoll() without another line
+    dbg.success("z\n");
+    dbg.success("z\n");
+    dbg.success("z\n");
+    dbg.repeatPoll();
+    mock_advance(999U * MS);
+    dbg.repeatPoll();
+    CHECK_STR(_since(&at), "[SUCCESS] z\n");
+    mock_advance(1U * MS);
+    dbg.repeatPoll();
+    CHECK_STR(_since(&at), "[SUCCESS] last message repeated 2 times\n");
+    dbg.repeatPoll();
+    CHECK_EQ(mock_wire_len, at);
+
+    // Turned off: the pending counts of every level are reported, in level
+    // order, and the last lines forgotten
+    dbg.success("z\n");
+    dbg.log("l\n");
+    dbg.log("l\n");
+    dbg.log("l\n");
+    dbg.error("e\n");
+    dbg.error("e\n");
+    CHECK_STR(_since(&at), "l\n[ERROR] e\n");
+    dbg.setRepeatSuppressEnabled(false);
+    CHECK_STR(_since(&at),
+        "last message repeated 2 times\n"
+        "[SUCCESS] last message repeated 1 times\n"
+        "[ERROR] last message repeated 1 times\n");
+    dbg.setRepeatSuppressEnabled(false);
+    CHECK_EQ(mock_wire_len, at);
+    dbg.error("e\n");
+    dbg.error("e\n");
+    CHECK_STR(_since(&at), "[ERROR] e\n[ERROR] e\n");
+
+    // On again: nothing is remembered from before
+    dbg.setRepeatSuppressEnabled(true);
+    dbg.error("e\n");
+    dbg.error("e\n");
+    dbg.setRepeatSuppressEnabled(false);
+    CHECK_STR(_since(&at), "[ERROR] e\n[ERROR] last message repeated 1 times\n");
+
+    printf("repeat (C++): collapsed per level, hash collisions shown, timeout by line and by poll\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*******************************************************************************
+ * @file        test_sinks.cpp
+ * @brief       DEBUG_SINKS through the C++ class, as in test_sinks.c: sink
+ *              levels, colors and toggles, the ANSI-free copy of a line cut
+ *              inside an escape sequence, calls no sink takes left
+ *              unformatted, and the RAM ring read back after a wrap.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+typedef struct {
+    char buf[4096];
+    size_t len;
+    int calls;
+} _capture_t;
+
+static _capture_t _colored;  // warnings and up, colored
+static _capture_t _plain;    // everything, plain
+
+static void _capWrite(void* ctx, const char* data, size_t len) {
+    _capture_t* c = static_cast<_capture_t*>(ctx);
+    CHECK(c->len + len < sizeof(c->buf));
+    memcpy(&c->buf[c->len], data, len);
+    c->len += len;
+    c->buf[c->len] = '\0';
+    c->calls++;
+}
+
+// Every sink and the port start empty
+static void _clear() {
+    mock_reset();
+    memset(&_colored, 0, sizeof(_colored));
+    memset(&_plain, 0, sizeof(_plain));
+}
+
+static ElegantDebug dbg(&huart1, false, false);
+
+static char _big[DEBUG_BUFFER_LEN * 2];
+
+int main() {
+    mock_reset();
+    const ElegantDebug::Stats* stats = &dbg.stats();
+
+    // IDs after the port and the RAM ring, none past DEBUG_SINK_MAX
+    CHECK_EQ(dbg.sinkAdd(nullptr, nullptr, DEBUG_LEVEL_LOG, false), -1);
+    int a = dbg.sinkAdd(_capWrite, &_colored, DEBUG_LEVEL_WARNING, true);
+    int b = dbg.sinkAdd(_capWrite, &_plain, DEBUG_LEVEL_LOG, false);
+    CHECK_EQ(a, 2);
+    CHECK_EQ(b, 3);
+    CHECK_EQ(dbg.sinkAdd(_capWrite, &_plain, DEBUG_LEVEL_LOG, false), -1);
+
+    // Each sink by its own level; the colored one gets the line as
+    // formatted, the plain ones the same line stripped
+    _clear();
+    dbg.info("i %d\n", 1);
+    dbg.warning("w %d\n", 2);
+    CHECK_STR(mock_wire, "[INFO] i 1\n[WARNING] w 2\n");
+    CHECK_STR(_colored.buf, WARNING_TYPE "w 2\n");
+    CHECK_STR(_plain.buf, "[INFO] i 1\n[WARNING] w 2\n");
+    CHECK_EQ(_plain.calls, 2);
+
+    // The port's color is dbg.setColorEnabled()
+    _clear();
+    dbg.sinkSetColor(DEBUG_SINK_PORT, true);
+    dbg.error("e\n");
+    CHECK_STR(mock_wire, ERROR_TYPE "e\n");
+    CHECK_STR(_colored.buf, ERROR_TYPE "e\n");
+    CHECK_STR(_plain.buf, "[ERROR] e\n");
+    dbg.setColorEnabled(false);
+
+    // Levels, color and enable changed at run time; unknown IDs are ignored
+    _clear();
+    dbg.sinkSetLevel((uint8_t)a, DEBUG_LEVEL_LOG);
+    dbg.sinkSetColor((uint8_t)a, false);
+    dbg.sinkEnable((uint8_t)b, false);
+    dbg.sinkEnable(DEBUG_SINK_MAX, false);
+    dbg.sinkSetLevel(DEBUG_SINK_MAX, DEBUG_LEVEL_NONE);
+    dbg.sinkSetColor(DEBUG_SINK_MAX, true);
+    dbg.ok("ok\n");
+    dbg.log("log\n");
+    CHECK_STR(mock_wire, "[OK] ok\nlog\n");
+    CHECK_STR(_colored.buf, "[OK] ok\nlog\n");
+    CHECK_EQ(_plain.len, 0U);
+    dbg.sinkEnable((uint8_t)b, true);
+    dbg.sinkEnable(DEBUG_SINK_PORT, false);
+    dbg.sinkSetLevel((uint8_t)a, DEBUG_LEVEL_ERROR);
+    dbg.success("s\n");
+    dbg.error("e\n");
+    CHECK_STR(mock_wire, "[OK] ok\nlog\n");
+    CHECK_STR(_colored.buf, "[OK] ok\nlog\n[ERROR] e\n");
+    CHECK_STR(_plain.buf, "[SUCCESS] s\n[ERROR] e\n");
+    dbg.sinkEnable(DEBUG_SINK_PORT, true);
+
+    // Nothing takes it: no sink is called and the line is never formatted,
+    // so an over-long one is not counted as truncated
+    memset(_big, 'x', sizeof(_big) - 1U);
+    dbg.sinkSetLevel(DEBUG_SINK_PORT, DEBUG_LEVEL_ERROR);
+    dbg.sinkSetLevel(DEBUG_SINK_RAM, DEBUG_LEVEL_ERROR);
+    dbg.sinkSetLevel((uint8_t)b, DEBUG_LEVEL_ERROR);
+    dbg.sinkRamClear();
+    _clear();
+    dbg.warning("%s\n", _big);
+    dbg.info("%s\n", _big);
+    CHECK_EQ(stats->truncated, 0U);
+    CHECK_EQ(mock_wire_len + _colored.len + _plain.len, 0U);
+    char ram[512];
+    CHECK_EQ(dbg.sinkRamRead(ram, sizeof(ram)), 0U);
+    dbg.sinkSetLevel((uint8_t)b, DEBUG_LEVEL_WARNING);
+    dbg.warning("%s\n", _big);
+    CHECK_EQ(stats->truncated, 1U);
+    CHECK(_plain.len > DEBUG_BUFFER_LEN);
+    CHECK_EQ(mock_wire_len, 0U);
+
+    // Cut at the line buffer inside an escape sequence: the plain sink gets
+    // the text up to it and nothing of the sequence
+    dbg.sinkSetLevel(DEBUG_SINK_PORT, DEBUG_LEVEL_LOG);
+    dbg.sinkSetLevel(DEBUG_SINK_RAM, DEBUG_LEVEL_LOG);
+    dbg.sinkSetLevel((uint8_t)a, DEBUG_LEVEL_LOG);
+    dbg.sinkSetLevel((uint8_t)b, DEBUG_LEVEL_LOG);
+    dbg.sinkSetColor((uint8_t)a, true);
+    _clear();
+    dbg.info("%s", _big);
+    size_t full = _colored.len;       // the longest line, prefix included
+    size_t prefix = sizeof(INFO_TYPE) - 1U;
+    CHECK(full > DEBUG_BUFFER_LEN && full < sizeof(_big));
+    for (size_t kept = 1; kept < sizeof(COLOR_RED) - 1U; kept++) {
+        static char text[sizeof(_big)];
+        size_t k = full - prefix - kept;
+        memset(text, 'x', k);
+        snprintf(&text[k], sizeof(text) - k, "%s", COLOR_RED "red" CLR "\n");
+        _clear();
+        dbg.info("%s", text);
+        CHECK_EQ(_colored.len, full);
+        CHECK(memcmp(&_colored.buf[full - kept], COLOR_RED, kept) == 0);
+        CHECK_EQ(_plain.len, sizeof(INFO_TYPE_PLAIN) - 1U + k);
+        CHECK(strncmp(_plain.buf, INFO_TYPE_PLAIN, sizeof(INFO_TYPE_PLAIN) - 1U) == 0);
+        CHECK_EQ(strspn(&_plain.buf[sizeof(INFO_TYPE_PLAIN) - 1U], "x"), k);
+        CHECK_STR(mock_wire, _plain.buf);
+    }
+    // ... and whole sequences anywhere in the line
+    _clear();
+    dbg.info(COLOR_RED "a" CLR "b" COLOR_RED "\n" CLR);
+    CHECK_STR(_colored.buf, INFO_TYPE COLOR_RED "a" CLR "b" COLOR_RED "\n" CLR);
+    CHECK_STR(_plain.buf, "[INFO] ab\n");
+    CHECK_STR(mock_wire, "[INFO] ab\n");
+    dbg.sinkEnable((uint8_t)a, false);
+    dbg.sinkEnable((uint8_t)b, false);
+
+    // RAM ring: everything since the clear while it fits, then the latest
+    // lines from a whole one on, ending with the last
+    dbg.sinkRamClear();
+    char want[4096] = "";
+    for (int i = 0; i < 5; i++) {
+        dbg.info("ram %03d\n", i);
+        snprintf(&want[strlen(want)], sizeof(want) - strlen(want), "[INFO] ram %03d\n", i);
+    }
+    size_t n = dbg.sinkRamRead(ram, sizeof(ram));
+    CHECK_EQ(n, strlen(want));
+    CHECK(memcmp(ram, want, n) == 0);
+    for (int i = 5; i < 40; i++) {
+        dbg.info("ram %03d\n", i);
+        snprintf(&want[strlen(want)], sizeof(want) - strlen(want), "[INFO] ram %03d\n", i);
+    }
+    CHECK(strlen(want) > DEBUG_SINK_RAM_LEN);
+    for (size_t size = DEBUG_SINK_RAM_LEN + 16U; size >= 16U; size /= 2U) {
+        n = dbg.sinkRamRead(ram, size);
+        size_t last = (size < DEBUG_SINK_RAM_LEN) ? size : DEBUG_SINK_RAM_LEN;
+        CHECK(n <= last && n + 15U >= last);    // at most one line skipped
+        CHECK(strncmp(ram, "[INFO] ram ", 11) == 0);
+        CHECK(memcmp(ram, &want[strlen(want) - n], n) == 0);
+        CHECK(want[strlen(want) - n - 1U] == '\n');
+    }
+    // ... of which a line longer than the ring leaves only its end, not a
+    // whole line
+    char wide[DEBUG_SINK_RAM_LEN + 44];
+    memset(wide, 'y', sizeof(wide) - 1U);
+    wide[sizeof(wide) - 1U] = '\0';
+    dbg.log("%s\n", wide);
+    CHECK_EQ(dbg.sinkRamRead(ram, sizeof(ram)), 0U);
+    dbg.log("tail\n");
+    CHECK_EQ(dbg.sinkRamRead(ram, sizeof(ram)), 5U);
+    CHECK(memcmp(ram, "tail\n", 5) == 0);
+
+    printf("sinks (C++): levels, colors, toggles, escape sequences cut at the line end, RAM ring wrap\n");
+    return 0;
+}
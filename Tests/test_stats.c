@@ -0,0 +1,212 @@
+/*******************************************************************************
+ * @file        test_stats.c
+ * @brief       DEBUG_STATS on the STM32 DMA port: lines and bytes per level
+ *              match what reached the wire, lines cut at DEBUG_BUFFER_LEN are
+ *              counted as truncated, a stalled port fills the TX ring up to
+ *              its high-water mark and then drops lines, counted by level.
+ *              Telemetry packets stay out of lines[]. debug_dumpStats()
+ *              prints the counters as they were before its first line, and
+ *              debug_statsReset() zeroes them.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define BYTE_NS 86806U      // 10 bits at 115200 baud
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+
+static void _checkZero(const debug_stats_t* s) {
+    for (int i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        CHECK_EQ(s->lines[i], 0U);
+        CHECK_EQ(s->bytes[i], 0U);
+        CHECK_EQ(s->dropped[i], 0U);
+    }
+    CHECK_EQ(s->truncated, 0U);
+    CHECK_EQ(s->ring_high_water, 0U);
+    CHECK_EQ(s->tlm_packets, 0U);
+    CHECK_EQ(s->tlm_bytes, 0U);
+    CHECK_EQ(s->tlm_dropped, 0U);
+    CHECK_EQ(s->log_cycles, 0U);
+    CHECK_EQ(s->tx_cycles, 0U);
+}
+
+// Bytes of the lines starting with `prefix` on the wire from `from` on
+static uint32_t _wireBytes(size_t from, const char* prefix, uint32_t* lines) {
+    uint32_t bytes = 0;
+    *lines = 0;
+    for (const char* p = &mock_wire[from]; *p != '\0'; ) {
+        const char* end = strchr(p, '\n');
+        CHECK(end != NULL);
+        bool plain = p[0] != '[';       // log lines have no prefix
+        if ((prefix[0] == '\0') ? plain : strncmp(p, prefix, strlen(prefix)) == 0) {
+            bytes += (uint32_t)(end + 1 - p);
+            (*lines)++;
+        }
+        p = end + 1;
+    }
+    return bytes;
+}
+
+int main(void) {
+    static const char* const prefixes[DEBUG_LEVEL_NONE] = {
+        "", "[INFO] ", "[OK] ", "[SUCCESS] ", "[WARNING] ", "[ERROR] ",
+    };
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_init(&huart1, false, false, false);
+    const debug_stats_t* s = debug_stats();
+    CHECK(s == &_debug_stats);
+    debug_statsReset();
+    _checkZero(s);
+
+    // Per level: as many lines and bytes as reached the wire
+    for (int i = 0; i < 5; i++) {
+        debug_log("log %d\n", i);
+        if (i < 4) debug_info("info %d\n", i * 1000);
+        if (i < 3) debug_ok("ok\n");
+        if (i < 2) debug_success("success %s\n", "!");
+        if (i < 1) debug_warning("warning %d\n", i);
+        debug_error("error %d\n", i);
+        mock_flush();
+    }
+    static const uint32_t counts[DEBUG_LEVEL_NONE] = { 5, 4, 3, 2, 1, 5 };
+    uint32_t total = 0;
+    for (int i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        uint32_t lines;
+        uint32_t bytes = _wireBytes(0, prefixes[i], &lines);
+        CHECK_EQ(lines, counts[i]);
+        CHECK_EQ(s->lines[i], counts[i]);
+        CHECK_EQ(s->bytes[i], bytes);
+        CHECK_EQ(s->dropped[i], 0U);
+        total += bytes;
+    }
+    CHECK_EQ(total, mock_wire_len);
+    CHECK_EQ(s->truncated, 0U);
+    CHECK(s->ring_high_water > 0U && s->ring_high_water <= total);
+    CHECK(s->log_cycles >= s->tx_cycles);     // the virtual time stands still in a call
+
+    // Cut at the line buffer: counted once as truncated, bytes as sent
+    static char big[DEBUG_BUFFER_LEN * 2];
+    memset(big, 'x', sizeof(big) - 1U);
+    size_t at = mock_wire_len;
+    uint32_t warning_bytes = s->bytes[DEBUG_LEVEL_WARNING];
+    debug_warning("%s\n", big);
+    mock_flush();
+    CHECK_EQ(s->truncated, 1U);
+    CHECK_EQ(s->lines[DEBUG_LEVEL_WARNING], 2U);
+    CHECK(mock_wire_len - at >= DEBUG_BUFFER_LEN && mock_wire_len - at < strlen(big));
+    CHECK_EQ(s->bytes[DEBUG_LEVEL_WARNING], warning_bytes + (mock_wire_len - at));
+
+    // Telemetry packets: their own counters, not lines[LOG]
+    int16_t samples[16];
+    for (int i = 0; i < 16; i++) samples[i] = (int16_t)(i * 100);
+    at = mock_wire_len;
+    debug_streamSamples(0, samples, 16);
+    mock_flush();
+    CHECK_EQ(s->tlm_packets, 1U);
+    CHECK_EQ(s->tlm_bytes, mock_wire_len - at);
+    CHECK_EQ(s->lines[DEBUG_LEVEL_LOG], 5U);
+
+    // Reset, then a stalled port: the ring holds every byte queued until it
+    // is full, then lines are dropped and counted by level
+    debug_statsReset();
+    _checkZero(s);
+    size_t reset_at = mock_wire_len;
+    mock_stalled = true;
+    char line[64];
+    uint32_t queued = 0;
+    uint32_t sent[DEBUG_LEVEL_NONE] = { 0 };
+    uint32_t dropped[DEBUG_LEVEL_NONE] = { 0 };
+    for (int i = 0; i < 60; i++) {
+        uint8_t level = (i % 3 == 0) ? DEBUG_LEVEL_ERROR : DEBUG_LEVEL_INFO;
+        uint32_t len = (uint32_t)snprintf(line, sizeof(line), "%s%02d abcdefghijklmnopqrstuvwxyz\n",
+                                          prefixes[level], i);
+        bool fits = queued + len <= DEBUG_TX_RING_LEN;
+        if (level == DEBUG_LEVEL_ERROR) {
+            debug_error("%02d abcdefghijklmnopqrstuvwxyz\n", i);
+        } else {
+            debug_info("%02d abcdefghijklmnopqrstuvwxyz\n", i);
+        }
+        if (fits) {
+            queued += len;
+            sent[level]++;
+        } else {
+            dropped[level]++;
+        }
+        CHECK_EQ(s->ring_high_water, queued);
+    }
+    CHECK(dropped[DEBUG_LEVEL_INFO] > 0U && dropped[DEBUG_LEVEL_ERROR] > 0U);
+    for (int i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        CHECK_EQ(s->lines[i], sent[i]);
+        CHECK_EQ(s->dropped[i], dropped[i]);
+        CHECK_EQ(s->dropped[i], debug_txDroppedLines((uint8_t)i));
+    }
+    uint32_t dropped_all = dropped[DEBUG_LEVEL_INFO] + dropped[DEBUG_LEVEL_ERROR];
+    uint32_t sent_all = sent[DEBUG_LEVEL_INFO] + sent[DEBUG_LEVEL_ERROR];
+
+    // Packets that do not fit are counted as telemetry drops
+    debug_streamSamples(0, samples, 16);
+    CHECK_EQ(s->tlm_dropped, 1U);
+    CHECK_EQ(s->tlm_packets, 0U);
+    CHECK_EQ(s->dropped[DEBUG_LEVEL_LOG], 0U);
+
+    // Unstalled, the next line still finds no room for the drop report but
+    // restarts the port; the one after it carries the report, which is not
+    // a line of the counters
+    mock_stalled = false;
+    debug_info("back\n");
+    mock_flush();
+    debug_info("again\n");
+    mock_flush();
+    CHECK_EQ(s->lines[DEBUG_LEVEL_INFO], sent[DEBUG_LEVEL_INFO] + 2U);
+    CHECK_EQ(s->lines[DEBUG_LEVEL_WARNING], 0U);
+    char report[128];
+    snprintf(report, sizeof(report), "[WARNING] %lu lines dropped (%lu error, %lu info), 1 telemetry packets\n",
+             (unsigned long)dropped_all, (unsigned long)dropped[DEBUG_LEVEL_ERROR],
+             (unsigned long)dropped[DEBUG_LEVEL_INFO]);
+    CHECK(strstr(&mock_wire[reset_at], report) != NULL);
+
+    // The dump shows the counters from before its own lines
+    debug_stats_t before = *s;
+    at = mock_wire_len;
+    debug_dumpStats();
+    mock_flush();
+    uint32_t all_lines = 0, all_bytes = 0;
+    for (int i = 0; i < DEBUG_LEVEL_NONE; i++) {
+        all_lines += before.lines[i];
+        all_bytes += before.bytes[i];
+    }
+    char want[512];
+    int n = snprintf(want, sizeof(want),
+        "[INFO] Logger stats: %lu lines, %lu bytes, %lu dropped, 0 truncated\n"
+        "[INFO]   error   %8lu lines %9lu B %6lu dropped\n"
+        "[INFO]   info    %8lu lines %9lu B %6lu dropped\n"
+        "[INFO]   telemetry%7u packets %7u B %6u dropped\n"
+        "[INFO]   TX ring high-water %lu / %u B\n",
+        (unsigned long)all_lines, (unsigned long)all_bytes, (unsigned long)dropped_all,
+        (unsigned long)sent[DEBUG_LEVEL_ERROR], (unsigned long)before.bytes[DEBUG_LEVEL_ERROR],
+        (unsigned long)dropped[DEBUG_LEVEL_ERROR],
+        (unsigned long)sent[DEBUG_LEVEL_INFO] + 2U, (unsigned long)before.bytes[DEBUG_LEVEL_INFO],
+        (unsigned long)dropped[DEBUG_LEVEL_INFO],
+        0U, 0U, 1U,
+        (unsigned long)before.ring_high_water, (unsigned)DEBUG_TX_RING_LEN);
+    CHECK_EQ(all_bytes, at - reset_at - strlen(report));
+    CHECK_EQ(before.ring_high_water, queued + strlen("[INFO] back\n"));   // queued behind the rest
+    CHECK(strncmp(&mock_wire[at], want, (size_t)n) == 0);
+    CHECK(strncmp(&mock_wire[at + (size_t)n], "[INFO]   ", 9) == 0);
+    CHECK(strstr(&mock_wire[at + (size_t)n], " cycles in log calls, ") != NULL);
+    // ... and its lines are counted afterwards
+    CHECK(s->lines[DEBUG_LEVEL_INFO] > before.lines[DEBUG_LEVEL_INFO]);
+
+    debug_statsReset();
+    _checkZero(s);
+
+    printf("stats: %lu lines sent, %lu dropped, high-water %lu B\n",
+           (unsigned long)sent_all, (unsigned long)dropped_all, (unsigned long)queued);
+    return 0;
+}
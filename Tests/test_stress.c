@@ -0,0 +1,244 @@
+/*******************************************************************************
+ * @file        test_stress.c
+ * @brief       DEBUG_THREAD_SAFE with several writer threads logging at once
+ *              into a small TX ring; built to run under ThreadSanitizer.
+ *
+ *              Blocking build: the writer that finds the port idle sends
+ *              the ring for everyone. DEBUG_TX_NONBLOCKING build: DMA drains
+ *              the ring and a "hardware" thread lets virtual time pass, so
+ *              TX-complete callbacks race the writers like an interrupt.
+ *              With STRESS_ISR a 20 us timer signal also logs an error line
+ *              from whatever instruction a writer is at, like an ISR that
+ *              preempts it between reserving its room and committing it.
+ *
+ *              Every line on the wire must be whole and each writer's lines
+ *              in order. Lines that are missing must be exactly the ones
+ *              counted as dropped: by debug_txDroppedLines(), by
+ *              debug_txDropped() (bytes) and by the "lines dropped" reports.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define WRITERS 4
+#ifndef LINES
+#define LINES   4000U       // per writer
+#endif
+#define FILL    41U         // body lengths vary from 0 to FILL - 1 filler bytes
+
+static const char _filler[] = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGH";
+
+static volatile int _done = 0;
+
+#if DEBUG_TX_NONBLOCKING
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+
+static void* _hardware(void* arg) {
+    (void)arg;
+    while (!__atomic_load_n(&_done, __ATOMIC_ACQUIRE)) {
+        mock_advance(100000U);      // 10 KB of wire time: the whole ring
+    }
+    return NULL;
+}
+#endif
+
+#ifdef STRESS_ISR
+static volatile uint32_t _isr_lines = 0;
+static volatile uint32_t _isr_running = 0;
+
+// The signal may arrive on another thread while the handler runs; like an
+// interrupt it only runs once at a time
+static void _isr(int sig) {
+    (void)sig;
+    if (__atomic_exchange_n(&_isr_running, 1U, __ATOMIC_ACQUIRE) != 0U) return;
+    debug_error("isr %lu\n", (unsigned long)_isr_lines);
+    _isr_lines = _isr_lines + 1U;
+    __atomic_store_n(&_isr_running, 0U, __ATOMIC_RELEASE);
+}
+
+static timer_t _timerStart(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = _isr;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    CHECK(sigaction(SIGALRM, &sa, NULL) == 0);
+
+    struct sigevent ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.sigev_notify = SIGEV_SIGNAL;
+    ev.sigev_signo = SIGALRM;
+    timer_t timer;
+    CHECK(timer_create(CLOCK_MONOTONIC, &ev, &timer) == 0);
+
+    struct itimerspec period = { { 0, 20000 }, { 0, 20000 } };
+    CHECK(timer_settime(timer, 0, &period, NULL) == 0);
+    return timer;
+}
+
+static void _timerStop(timer_t timer) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+    timer_delete(timer);
+}
+#endif
+
+static uint32_t _fill(uint32_t w, uint32_t seq) {
+    return (w * 7U + seq * 13U) % FILL;
+}
+
+// Bytes of line `seq` of writer `w`, WRITERS being the ISR
+static size_t _lineLen(uint32_t w, uint32_t seq) {
+    char buf[128];
+    if (w == WRITERS) return (size_t)snprintf(buf, sizeof(buf), "[ERROR] isr %lu\n", (unsigned long)seq);
+    return (size_t)snprintf(buf, sizeof(buf), "[INFO] w%lu %lu %.*s\n",
+                            (unsigned long)w, (unsigned long)seq, (int)_fill(w, seq), _filler);
+}
+
+static void* _writer(void* arg) {
+    uint32_t w = (uint32_t)(uintptr_t)arg;
+    for (uint32_t seq = 0; seq < LINES; seq++) {
+        debug_info("w%lu %lu %.*s\n", (unsigned long)w, (unsigned long)seq, (int)_fill(w, seq), _filler);
+    #if DEBUG_TX_NONBLOCKING
+        if (seq % 8U == 0U) sched_yield();      // let the hardware thread in, also on one core
+    #endif
+    }
+    return NULL;
+}
+
+// "[WARNING] 12 lines dropped (1 error, 11 info)": adds the counts per level
+static bool _report(const char* p, uint32_t reported[DEBUG_LEVEL_NONE]) {
+    unsigned long total;
+    int n = 0;
+    if (sscanf(p, "[WARNING] %lu lines dropped (%n", &total, &n) != 1 || n == 0) return false;
+
+    unsigned long sum = 0;
+    for (p += n; *p != ')'; ) {
+        unsigned long count;
+        char name[16];
+        CHECK(sscanf(p, "%lu %15[a-z]%n", &count, name, &n) == 2);
+        if (strcmp(name, "error") == 0) {
+            reported[DEBUG_LEVEL_ERROR] += (uint32_t)count;
+        } else {
+            CHECK_STR(name, "info");
+            reported[DEBUG_LEVEL_INFO] += (uint32_t)count;
+        }
+        sum += count;
+        p += n;
+        if (*p == ',') p += 2;
+    }
+    CHECK_STR(p, ")");
+    CHECK_EQ(sum, total);
+    return true;
+}
+
+int main(void) {
+    mock_reset();
+    mock_byte_ns = 10U;
+    debug_init(&huart1, false, false, false);
+
+    pthread_t writers[WRITERS];
+#if DEBUG_TX_NONBLOCKING
+    pthread_t hardware;
+    CHECK(pthread_create(&hardware, NULL, _hardware, NULL) == 0);
+#endif
+#ifdef STRESS_ISR
+    timer_t timer = _timerStart();
+#endif
+    for (uintptr_t w = 0; w < WRITERS; w++) {
+        CHECK(pthread_create(&writers[w], NULL, _writer, (void*)w) == 0);
+    }
+    for (int w = 0; w < WRITERS; w++) {
+        pthread_join(writers[w], NULL);
+    }
+#ifdef STRESS_ISR
+    _timerStop(timer);
+    const uint32_t sent[WRITERS + 1] = { LINES, LINES, LINES, LINES, _isr_lines };
+#else
+    const uint32_t sent[WRITERS + 1] = { LINES, LINES, LINES, LINES, 0U };
+#endif
+    __atomic_store_n(&_done, 1, __ATOMIC_RELEASE);
+#if DEBUG_TX_NONBLOCKING
+    pthread_join(hardware, NULL);
+#endif
+
+    // Whatever is still dropped gets reported ahead of the last line
+    mock_flush();
+    debug_info("end\n");
+    mock_flush();
+    CHECK(mock_wire_len < MOCK_WIRE_LEN);
+
+    uint32_t next[WRITERS + 1] = { 0 };
+    uint32_t missing[DEBUG_LEVEL_NONE] = { 0 };
+    uint32_t reported[DEBUG_LEVEL_NONE] = { 0 };
+    uint64_t missing_bytes = 0;
+    uint32_t lines = 0;
+    bool end = false;
+
+    char* p = mock_wire;
+    while (*p != '\0') {
+        char* nl = strchr(p, '\n');
+        CHECK(nl != NULL);
+        *nl = '\0';
+        CHECK(!end);
+
+        unsigned long w, seq;
+        int n = 0;
+        if (sscanf(p, "[INFO] w%lu %lu %n", &w, &seq, &n) == 2 && n > 0) {
+            CHECK(w < WRITERS);
+            CHECK_EQ(strlen(p + n), _fill((uint32_t)w, (uint32_t)seq));
+            CHECK(strncmp(p + n, _filler, strlen(p + n)) == 0);
+        } else if (sscanf(p, "[ERROR] isr %lu%n", &seq, &n) == 1 && p[n] == '\0') {
+            w = WRITERS;
+        } else {
+            if (!_report(p, reported)) {
+                CHECK_STR(p, "[INFO] end");
+                end = true;
+            }
+            p = nl + 1;
+            continue;
+        }
+
+        CHECK(seq < sent[w] && seq >= next[w]);     // in order, none twice
+        for (uint32_t s = next[w]; s < seq; s++) {
+            missing[w == WRITERS ? DEBUG_LEVEL_ERROR : DEBUG_LEVEL_INFO]++;
+            missing_bytes += _lineLen((uint32_t)w, s);
+        }
+        next[w] = (uint32_t)seq + 1U;
+        lines++;
+        p = nl + 1;
+    }
+    CHECK(end);
+    for (uint32_t w = 0; w <= WRITERS; w++) {
+        for (uint32_t s = next[w]; s < sent[w]; s++) {
+            missing[w == WRITERS ? DEBUG_LEVEL_ERROR : DEBUG_LEVEL_INFO]++;
+            missing_bytes += _lineLen(w, s);
+        }
+    }
+
+    uint32_t total = WRITERS * LINES + sent[WRITERS];
+    uint32_t dropped = missing[DEBUG_LEVEL_INFO] + missing[DEBUG_LEVEL_ERROR];
+    CHECK_EQ(lines + dropped, total);
+    for (uint8_t level = 0; level < DEBUG_LEVEL_NONE; level++) {
+        CHECK_EQ(debug_txDroppedLines(level), missing[level]);
+        CHECK_EQ(reported[level], missing[level]);
+    }
+    CHECK_EQ(debug_txDropped(), missing_bytes);
+
+    printf("%d writers, %lu lines (%lu from the ISR): %lu on the wire, %lu dropped and reported\n",
+           WRITERS, (unsigned long)total, (unsigned long)sent[WRITERS],
+           (unsigned long)lines, (unsigned long)dropped);
+    return 0;
+}
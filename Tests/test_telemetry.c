@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * @file        test_telemetry.c
+ * @brief       DEBUG_TELEMETRY: packets share the TX ring with the log lines
+ *              but are counted apart from them. Sent packets go to the
+ *              telemetry counters, not to lines[DEBUG_LEVEL_LOG]; packets
+ *              dropped on a full ring are reported as packets, not as "log"
+ *              lines.
+ ******************************************************************************/
+
+#include "ElegantDebug.h"
+#include "check.h"
+#include "mock_port.h"
+#include "usart.h"
+
+#define BYTE_NS 86806U      // 10 bits at 115200 baud
+#define BLOCKS  40
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef* huart) {
+    debug_txCpltCallback(huart);
+}
+
+static int16_t _samples[32];
+
+// Packets on the wire: runs between two 0x00 delimiters
+static uint32_t _packets(void) {
+    uint32_t n = 0;
+    bool open = false;
+    for (size_t i = 0; i < mock_wire_len; i++) {
+        if (mock_wire[i] != '\0') continue;
+        if (open) n++;
+        open = !open;
+    }
+    CHECK(!open);
+    return n;
+}
+
+int main(void) {
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_init(&huart1, false, false, false);
+    for (int i = 0; i < 32; i++) _samples[i] = (int16_t)(1000 + i * 3);
+
+    // Port keeping up: one packet per block, none counted as a log line
+    for (int i = 0; i < BLOCKS; i++) {
+        debug_streamSamples(0, _samples, 32);
+        debug_info("block %d\n", i);
+        mock_flush();
+    }
+    const debug_stats_t* s = debug_stats();
+    CHECK_EQ(_packets(), (uint32_t)BLOCKS);
+    CHECK_EQ(s->tlm_packets, (uint32_t)BLOCKS);
+    CHECK_EQ(s->tlm_bytes + s->bytes[DEBUG_LEVEL_INFO], (uint32_t)mock_wire_len);
+    CHECK_EQ(s->lines[DEBUG_LEVEL_LOG], 0U);
+    CHECK_EQ(s->lines[DEBUG_LEVEL_INFO], (uint32_t)BLOCKS);
+
+    // Port stalled: the ring fills, packets and lines are dropped and each
+    // counted as what they are
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    debug_statsReset();
+    mock_stalled = true;
+    for (int i = 0; i < BLOCKS; i++) {
+        debug_streamSamples(0, _samples, 32);
+        debug_info("block %d\n", i);
+    }
+    uint32_t packets = debug_txDroppedPackets();
+    uint32_t lines = debug_txDroppedLines(DEBUG_LEVEL_INFO);
+    CHECK(packets > 0U && packets < BLOCKS);
+    CHECK(lines > 0U && lines < BLOCKS);
+    CHECK_EQ(debug_txDroppedLines(DEBUG_LEVEL_LOG), 0U);
+    CHECK_EQ(s->tlm_dropped, packets);
+    CHECK_EQ(s->dropped[DEBUG_LEVEL_INFO], lines);
+    CHECK_EQ(s->dropped[DEBUG_LEVEL_LOG], 0U);
+    CHECK_EQ(s->tlm_packets + packets, (uint32_t)BLOCKS);
+
+    // Unstalled, the next line finds no room yet but restarts the queue;
+    // the one after it carries the report
+    mock_stalled = false;
+    debug_info("back\n");
+    mock_flush();
+    CHECK_EQ(_packets(), (uint32_t)BLOCKS - packets);
+    debug_info("end\n");
+    mock_flush();
+    char want[128];
+    snprintf(want, sizeof(want), "[WARNING] %lu lines dropped (%lu info), %lu telemetry packets\n[INFO] end\n",
+             (unsigned long)lines + 1U, (unsigned long)lines + 1U, (unsigned long)packets);
+    CHECK(mock_wire_len > strlen(want));
+    CHECK(memcmp(&mock_wire[mock_wire_len - strlen(want)], want, strlen(want)) == 0);
+
+    // Packets alone get a report of their own
+    mock_reset();
+    mock_byte_ns = BYTE_NS;
+    mock_stalled = true;
+    for (int i = 0; i < BLOCKS; i++) debug_streamSamples(1, _samples, 32);
+    mock_stalled = false;
+    debug_streamSamples(1, _samples, 32);
+    mock_flush();
+    uint32_t more = debug_txDroppedPackets() - packets;
+    CHECK(more > 0U);
+    debug_info("end\n");
+    mock_flush();
+    snprintf(want, sizeof(want), "[WARNING] %lu telemetry packets dropped\n[INFO] end\n", (unsigned long)more);
+    CHECK(memcmp(&mock_wire[mock_wire_len - strlen(want)], want, strlen(want)) == 0);
+
+    printf("telemetry: %lu packets and %lu lines dropped, counted apart\n",
+           (unsigned long)packets, (unsigned long)lines);
+    return 0;
+}
@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+"""
+ed_decode.py - host-side decoder for ElegantDebug binary logging mode.
+
+Reads the format strings from the `.elegant_debug_fmt` section of the
+firmware ELF and turns the binary record stream (DEBUG_BINARY_MODE = 1) back
+into the same text the library prints in text mode, ANSI colors included.
+Bytes outside valid records (e.g. text printed before the mode switch) are
+passed through unchanged.
+
+The argument bytes carry no types: their sizes come from the C types of the
+arguments, the decoder reads them by the conversions of the format. When the
+two do not add up to the record (say an int64_t logged with "%d"), the line
+says so instead of rendering garbage.
+
+Usage:
+    python ed_decode.py firmware.elf capture.bin
+    python ed_decode.py firmware.elf -                      # read stdin
+    python ed_decode.py firmware.elf --port COM5 --baud 115200   # needs pyserial
+    python ed_decode.py sim.elf capture.bin --long-size 8   # 64-bit host build
+
+Record layout: see "Binary logging" in Src-C/ElegantDebug.h.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SECTION = ".elegant_debug_fmt"
+SYNC = 0xED
+
+FLAG_TIMESTAMP = 0x01
+FLAG_COLOR = 0x02
+FLAG_FILENAME_LINE = 0x04
+FLAG_SUPPRESSED = 0x08
+FLAG_TRUNCATED = 0x80
+
+# Same strings as the *_TYPE / *_TYPE_PLAIN macros in ElegantDebug.h
+PREFIX = {
+    "E": ("\033[91m\033[1m[ERROR]\033[0m ", "[ERROR] "),
+    "W": ("\033[93m\033[1m[WARNING]\033[0m ", "[WARNING] "),
+    "I": ("\033[94m\033[1m[INFO]\033[0m ", "[INFO] "),
+    "O": ("\033[92m\033[1m[OK]\033[0m ", "[OK] "),
+    "S": ("\033[92m\033[1m[SUCCESS]\033[0m ", "[SUCCESS] "),
+}
+
+# printf conversion: flags, width, precision, length, specifier
+CONV = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t|L)?([diouxXcsfFeEgGaAp%])")
+
+
+def load_formats(elf_path):
+    """Return (section address, section bytes) of the format section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        sys.exit("%s: not an ELF file" % elf_path)
+
+    is64 = elf[4] == 2
+    end = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x3A)
+        hdr = end + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x2E)
+        hdr = end + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(hdr, elf, shoff + i * shentsize) for i in range(shnum)]
+    names = sections[shstrndx]
+    names_off = names[4]
+
+    for sh in sections:
+        name_end = elf.index(b"\0", names_off + sh[0])
+        if elf[names_off + sh[0]:name_end].decode() == SECTION:
+            addr, offset, size = sh[3], sh[4], sh[5]
+            return addr, elf[offset:offset + size]
+
+    sys.exit("%s: no %s section (is DEBUG_BINARY_MODE enabled?)" % (elf_path, SECTION))
+
+
+class Decoder:
+    def __init__(self, base, blob, out, long_size=4):
+        self.base = base
+        self.blob = blob
+        self.out = out
+        self.long_size = long_size      # sizeof(long) on the target
+        self.pending = bytearray()
+
+    def entry(self, addr):
+        off = (addr - self.base) & 0xFFFFFFFF
+        if off >= len(self.blob):
+            return None
+        text = self.blob[off:self.blob.index(b"\0", off)].decode("utf-8", "replace")
+        parts = text.split("\x1f", 3)
+        return parts if len(parts) == 4 else None
+
+    def feed(self, data):
+        self.pending += data
+        buf = self.pending
+        i = 0
+        while i < len(buf):
+            if buf[i] != SYNC:
+                j = buf.find(bytes([SYNC]), i)
+                j = len(buf) if j < 0 else j
+                self.out.write(buf[i:j].decode("utf-8", "replace"))
+                i = j
+                continue
+            if i + 2 > len(buf) or i + 2 + buf[i + 1] + 1 > len(buf):
+                break   # wait for the rest of the record
+            n = buf[i + 1]
+            payload = bytes(buf[i + 2:i + 2 + n])
+            if (~sum(payload)) & 0xFF == buf[i + 2 + n] and self.record(payload):
+                i += 3 + n
+            else:
+                self.out.write(chr(buf[i]))   # not a record, pass the byte through
+                i += 1
+        del buf[:i]
+        self.out.flush()
+
+    def record(self, p):
+        flags = p[0]
+        pos, addr, shift = 1, 0, 0
+        while True:
+            if pos >= len(p):
+                return False
+            b = p[pos]
+            pos += 1
+            addr |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        e = self.entry(addr)
+        if e is None:
+            return False
+        tag, file, line, fmt = e
+
+        line_text = ""
+        if flags & FLAG_TIMESTAMP:
+            ms, = struct.unpack_from("<I", p, pos)
+            pos += 4
+            s = ms // 1000
+            line_text = "[%02d:%02d:%02d.%03d] " % (s // 3600, (s % 3600) // 60, s % 60, ms % 1000)
+        suppressed = 0
+        if flags & FLAG_SUPPRESSED:
+            suppressed, = struct.unpack_from("<I", p, pos)
+            pos += 4
+
+        if tag == "H":
+            if pos + 7 > len(p):
+                return False
+            line_text += self.hexrow(p, pos, flags & FLAG_COLOR)
+            self.out.write(line_text)
+            return True
+
+        # lower case tags are the module variants, module name sent first
+        module = tag.islower()
+        tag = tag.upper()
+
+        args, used = self.args(p, pos, fmt, 2 if tag == "T" else int(module))
+        sent = len(p) - pos
+        if tag == "T":
+            typ, style, args = args[0], args[1], args[2:]
+            line_text += "\033[1m%s[%s]\033[0m " % (style, typ)
+        elif tag in PREFIX:
+            line_text += PREFIX[tag][0 if flags & FLAG_COLOR else 1]
+        if module:
+            name, args = args[0], args[1:]
+            if name:
+                line_text += "[%s] " % name
+        if tag in "EW" and flags & FLAG_FILENAME_LINE:
+            line_text += "[%s:%s] " % (file, line)
+        if suppressed:
+            line_text += "[%d suppressed] " % suppressed
+
+        if used != sent and not flags & FLAG_TRUNCATED:
+            line_text += "<arguments do not match %r: it reads %d bytes, the record has %d>\n" % (
+                fmt, used, sent)
+            self.out.write(line_text)
+            return True
+        line_text += self.render(fmt, args)
+        if flags & FLAG_TRUNCATED:
+            line_text += " <truncated>\n"
+        self.out.write(line_text)
+        return True
+
+    @staticmethod
+    def hexrow(p, pos, color):
+        """One debug_hexdump() row, as the text mode renders it."""
+        off, count, changed = struct.unpack_from("<IBH", p, pos)
+        data = p[pos + 7:pos + 7 + (count & 0x7F)]
+        text = "%08X " % off if count & 0x80 else "%04X " % (off & 0xFFFF)
+        for i in range(16):
+            if i % 8 == 0:
+                text += " "
+            if i >= len(data):
+                text += "   "
+                continue
+            bit = 1 << i
+            if color and changed & bit and not changed & (bit >> 1):
+                text += "\033[91m"
+            text += "%02X" % data[i]
+            if color and changed & bit and not changed & (bit << 1):
+                text += "\033[0m"
+            text += " "
+        ascii_col = "".join(chr(b) if 0x20 <= b < 0x7F else "." for b in data)
+        return text + " |" + ascii_col + "|\n"
+
+    @staticmethod
+    def take(p, pos, size):
+        if pos + size > len(p):
+            return None, len(p)
+        return p[pos:pos + size], pos + size
+
+    def args(self, p, pos, fmt, strings_first):
+        """Argument values for `fmt`, and the bytes they take (more than the
+        record has when it is short)"""
+        start = pos
+        kinds = ["s"] * strings_first
+        for m in CONV.finditer(fmt):
+            flags, width, prec, length, spec = m.groups()
+            if spec == "%":
+                continue
+            kinds += ["i"] * ((width == "*") + (prec == "*"))
+            if spec == "s":
+                kinds.append("s")
+            elif spec in "fFeEgGaA":
+                kinds.append("f")
+            elif length == "ll" or length == "j":
+                kinds.append("q")
+            elif length == "l" and self.long_size == 8:
+                kinds.append("q")
+            else:
+                kinds.append("i")
+
+        values = []
+        used = 0
+        for k in kinds:
+            if k == "s":
+                end = p.find(b"\0", pos)
+                if end < 0:
+                    values.append(None)
+                    used += 1 + len(p) - pos
+                    pos = len(p)
+                    continue
+                values.append(p[pos:end].decode("utf-8", "replace"))
+                used += end + 1 - pos
+                pos = end + 1
+            else:
+                size = 8 if k in "fq" else 4
+                used += size
+                raw, pos = self.take(p, pos, size)
+                if raw is None:
+                    values.append(None)
+                elif k == "f":
+                    values.append(struct.unpack("<d", raw)[0])
+                else:
+                    values.append(int.from_bytes(raw, "little"))
+        return values, used
+
+    def render(self, fmt, args):
+        """printf-style rendering with C semantics for the common conversions."""
+        out, it = [], iter(args)
+
+        def nxt():
+            return next(it, None)
+
+        last = 0
+        for m in CONV.finditer(fmt):
+            out.append(fmt[last:m.start()])
+            last = m.end()
+            flags, width, prec, length, spec = m.groups()
+            if spec == "%":
+                out.append("%")
+                continue
+            if width == "*":
+                w = nxt()
+                width = str(w - (1 << 32) if w is not None and w & 0x80000000 else w)
+            if prec == "*":
+                prec = str(nxt())
+            v = nxt()
+            if v is None:
+                out.append("?")
+                continue
+
+            bits = 64 if length in ("ll", "j") or (length == "l" and self.long_size == 8) else 32
+            if spec in "di":
+                if v & (1 << (bits - 1)):
+                    v -= 1 << bits
+                spec = "d"
+            elif spec == "u":
+                spec = "d"
+            elif spec == "p":
+                flags, spec = "#", "x"
+            elif spec == "c":
+                v &= 0xFF
+            elif spec in "aA":
+                out.append(float.hex(v))
+                continue
+
+            pyfmt = "%" + (flags or "") + (width or "") + ("." + prec if prec is not None else "") + spec
+            out.append(pyfmt % v)
+        out.append(fmt[last:])
+        return "".join(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode ElegantDebug binary log streams")
+    ap.add_argument("elf", help="firmware ELF containing the %s section" % SECTION)
+    ap.add_argument("input", nargs="?", default="-", help="captured stream file, '-' for stdin")
+    ap.add_argument("--port", help="read live from a serial port instead (pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--long-size", type=int, choices=(4, 8), default=4,
+                    help="sizeof(long) of the firmware, 8 for 64-bit host builds")
+    a = ap.parse_args()
+
+    base, blob = load_formats(a.elf)
+    dec = Decoder(base, blob, sys.stdout, a.long_size)
+
+    if a.port:
+        import serial
+        with serial.Serial(a.port, a.baud, timeout=0.1) as port:
+            while True:
+                dec.feed(port.read(256))
+    else:
+        src = sys.stdin.buffer if a.input == "-" else open(a.input, "rb")
+        with src:
+            while True:
+                chunk = src.read(4096)
+                if not chunk:
+                    break
+                dec.feed(chunk)
+
+
+if __name__ == "__main__":
+    main()
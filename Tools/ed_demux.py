@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""
+ed_demux.py - splits an ElegantDebug capture into log text and telemetry.
+
+Telemetry packets (DEBUG_TELEMETRY = 1) are COBS-framed between 0x00 bytes
+on the same port as the text log lines, which never contain 0x00 (the
+firmware does not allow telemetry with DEBUG_BINARY_MODE). This tool writes
+everything else to the log output and the samples to one CSV file per
+channel ("index,ms,value").
+
+Usage:
+    python ed_demux.py capture.bin --csv-dir samples
+    python ed_demux.py capture.bin --csv-dir samples --log log.txt
+    python ed_demux.py --port COM5 --baud 921600 --csv-dir samples   # needs pyserial
+
+Packet layout: see debug_streamSamples() in Src-C/ElegantDebug.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+KIND_INT16 = 1
+KIND_INT32 = 2
+KIND_FLOAT = 3
+
+MAX_FRAME = 254 + 2     # DEBUG_TELEMETRY_LEN max, plus the COBS code byte and spare
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def varint(p, pos):
+    v, shift = 0, 0
+    while True:
+        if pos >= len(p):
+            return None, pos
+        b = p[pos]
+        pos += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, pos
+
+
+def parse_packet(p):
+    """Return (channel, ms, samples) or None when the packet is not valid."""
+    if len(p) < 5 or (~sum(p[:-1])) & 0xFF != p[-1]:
+        return None
+    channel, kind = p[0], p[1]
+    ms, pos = varint(p, 2)
+    if ms is None or pos >= len(p) - 1:
+        return None
+    count = p[pos]
+    pos += 1
+    body = p[pos:-1]
+
+    samples = []
+    if kind == KIND_FLOAT:
+        if len(body) != 4 * count:
+            return None
+        samples = list(struct.unpack("<%df" % count, body))
+    elif kind in (KIND_INT16, KIND_INT32):
+        last, pos = 0, 0
+        for i in range(count):
+            zz, pos = varint(body, pos)
+            if zz is None:
+                return None
+            d = (zz >> 1) ^ -(zz & 1)
+            last = (d if i == 0 else last + d) & 0xFFFFFFFF
+            samples.append(last - (1 << 32) if last & 0x80000000 else last)
+        if pos != len(body):
+            return None
+    else:
+        return None
+    return channel, ms, samples
+
+
+class Demux:
+    def __init__(self, log, csv_dir):
+        self.log = log
+        self.csv_dir = csv_dir
+        self.files = {}
+        self.index = {}
+        self.pending = bytearray()
+        self.packets = 0
+        self.bad = 0
+
+    def text(self, data):
+        if data:
+            self.log.write(bytes(data).decode("utf-8", "replace"))
+
+    def samples(self, channel, ms, values):
+        f = self.files.get(channel)
+        if f is None:
+            f = open(os.path.join(self.csv_dir, "ch%d.csv" % channel), "w", newline="")
+            f.write("index,ms,value\n")
+            self.files[channel] = f
+            self.index[channel] = 0
+        n = self.index[channel]
+        for v in values:
+            f.write("%d,%d,%s\n" % (n, ms, ("%.9g" % v) if isinstance(v, float) else v))
+            n += 1
+        self.index[channel] = n
+        self.packets += 1
+
+    def feed(self, data, final=False):
+        buf = self.pending
+        buf += data
+        i = 0
+        while i < len(buf):
+            b = buf[i]
+            if b == 0x00:
+                j = buf.find(b"\0", i + 1)
+                if j < 0:
+                    if len(buf) - i <= MAX_FRAME and not final:
+                        break   # wait for the closing delimiter
+                    self.bad += 1
+                    i += 1      # stray zero
+                    continue
+                raw = cobs_decode(buf[i + 1:j])
+                pkt = parse_packet(raw) if raw else None
+                if pkt is None:
+                    self.bad += j > i + 1
+                    i += 1      # not an opening delimiter, resync on the next zero
+                    continue
+                self.samples(*pkt)
+                i = j + 1
+            else:
+                j = buf.find(b"\0", i)
+                if j < 0:
+                    j = len(buf)
+                self.text(buf[i:j])
+                i = j
+        del buf[:i]
+        self.log.flush()
+
+    def close(self):
+        self.feed(b"", final=True)
+        for f in self.files.values():
+            f.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Split ElegantDebug captures into log text and telemetry CSV")
+    ap.add_argument("input", nargs="?", default="-", help="captured stream file, '-' for stdin")
+    ap.add_argument("--csv-dir", default=".", help="directory for the chN.csv files")
+    ap.add_argument("--log", help="log text output (default stdout)")
+    ap.add_argument("--port", help="read live from a serial port instead (pyserial)")
+    ap.add_argument("--baud", type=int, default=115200)
+    a = ap.parse_args()
+
+    os.makedirs(a.csv_dir, exist_ok=True)
+    log = open(a.log, "w", encoding="utf-8") if a.log else sys.stdout
+    demux = Demux(log, a.csv_dir)
+
+    try:
+        if a.port:
+            import serial
+            with serial.Serial(a.port, a.baud, timeout=0.1) as port:
+                while True:
+                    demux.feed(port.read(256))
+        else:
+            src = sys.stdin.buffer if a.input == "-" else open(a.input, "rb")
+            with src:
+                while True:
+                    chunk = src.read(4096)
+                    if not chunk:
+                        break
+                    demux.feed(chunk)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        demux.close()
+        print("%d packets, %d bad frames" % (demux.packets, demux.bad), file=sys.stderr)
+        if log is not sys.stdout:
+            log.close()
+
+
+if __name__ == "__main__":
+    main()